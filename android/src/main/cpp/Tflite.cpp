@@ -41,17 +41,32 @@ public:
       }
 
       static const auto cls = javaClassStatic();
-      static const auto method =
+      static const auto openMethod =
+          cls->getStaticMethod<jlongArray(std::string)>("openModelFileDescriptor");
+      static const auto fetchMethod =
           cls->getStaticMethod<jbyteArray(std::string)>("fetchByteDataFromUrl");
 
-      auto byteData = method(cls, url);
+      // Local files and uncompressed resources can be memory-mapped without any copies
+      auto fileDescriptor = openMethod(cls, url);
+      if (fileDescriptor != nullptr) {
+        auto values = fileDescriptor->getRegion(0, 3);
+        try {
+          return Buffer::mapFileDescriptor(static_cast<int>(values[0]),
+                                           static_cast<size_t>(values[1]),
+                                           static_cast<size_t>(values[2]));
+        } catch (std::exception&) {
+          // e.g. the file system doesn't support mmap, so the model is read into memory instead.
+          // The file descriptor was closed already.
+        }
+      }
+
+      auto byteData = fetchMethod(cls, url);
 
       auto size = byteData->size();
-      auto bytes = byteData->getRegion(0, size);
       void* data = malloc(size);
-      memcpy(data, bytes.get(), size);
+      byteData->getRegion(0, size, static_cast<jbyte*>(data));
 
-      return Buffer{.data = data, .size = size};
+      return Buffer{.data = data, .size = static_cast<size_t>(size)};
     };
 
     try {
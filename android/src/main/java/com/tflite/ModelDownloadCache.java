@@ -0,0 +1,339 @@
+package com.tflite;
+
+import android.util.Log;
+
+import androidx.annotation.NonNull;
+import androidx.annotation.Nullable;
+
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.nio.charset.StandardCharsets;
+import java.security.MessageDigest;
+import java.security.NoSuchAlgorithmException;
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.HashMap;
+import java.util.HashSet;
+import java.util.Map;
+import java.util.Properties;
+import java.util.Set;
+
+import okhttp3.Call;
+import okhttp3.Callback;
+import okhttp3.HttpUrl;
+import okhttp3.OkHttpClient;
+import okhttp3.Request;
+import okhttp3.Response;
+import okhttp3.ResponseBody;
+
+/**
+ * Caches Models downloaded from http(s) URLs in the app's cache directory, so they are only
+ * downloaded once and can be memory-mapped like local files.
+ * <p>
+ * Downloads are streamed to disk in chunks (never held in the Java heap) and stored with their
+ * SHA-256 hash, ETag and Last-Modified headers. A cached Model is returned right away without any
+ * network I/O, and revalidated with a conditional request in the background (once per app
+ * start), so a changed Model is used from the next load on. The hash of a cached file is checked
+ * once per app start before it is used, so a corrupted file is downloaded again.
+ */
+class ModelDownloadCache {
+  private static final String TAG = TfliteModule.NAME;
+  private static final String DIRECTORY_NAME = "tflite-models";
+  private static final int CHUNK_SIZE = 64 * 1024;
+  // Hosts of a development machine, as seen from a device or emulator
+  private static final Set<String> DEVELOPMENT_HOSTS = new HashSet<>(
+          Arrays.asList("localhost", "127.0.0.1", "::1", "10.0.2.2", "10.0.3.2"));
+
+  private static class Entry {
+    @Nullable String etag;
+    @Nullable String lastModified;
+    @NonNull String sha256 = "";
+    long size;
+    // The cached file's modification time, to notice files that were changed or replaced
+    long modifiedAt;
+  }
+
+  private final File directory;
+  private final OkHttpClient client;
+  // One lock per URL, so different Models can be downloaded at the same time
+  private final Map<String, Object> locks = new HashMap<>();
+  // Cached files that were already revalidated since the app started
+  private final Set<String> revalidatedKeys = Collections.synchronizedSet(new HashSet<>());
+  // Cached files whose hash was already checked (or computed while downloading) since the app
+  // started
+  private final Set<String> verifiedKeys = Collections.synchronizedSet(new HashSet<>());
+
+  ModelDownloadCache(File cacheDirectory, OkHttpClient client) {
+    this.directory = new File(cacheDirectory, DIRECTORY_NAME);
+    this.client = client;
+  }
+
+  /**
+   * Whether the Model at the given URL should be cached on disk. Models served by the Metro
+   * packager or from a development machine change while developing, so they are always
+   * downloaded again.
+   */
+  static boolean isCacheable(String url) {
+    HttpUrl httpUrl = HttpUrl.parse(url);
+    if (httpUrl == null) {
+      return false;
+    }
+    if (DEVELOPMENT_HOSTS.contains(httpUrl.host())) {
+      return false;
+    }
+    // Metro serves bundled assets as /assets/...?platform=android&hash=...
+    boolean isPackagerAsset = httpUrl.encodedPath().startsWith("/assets/")
+            && httpUrl.queryParameter("platform") != null;
+    return !isPackagerAsset;
+  }
+
+  /**
+   * Returns the cached file for the given URL, and downloads it first if it is not cached yet (or
+   * the cached file was changed or is incomplete).
+   */
+  File getFile(String url) throws IOException {
+    String key = sha256(url.getBytes(StandardCharsets.UTF_8));
+    synchronized (getLock(key)) {
+      Entry entry = readEntry(key);
+      if (entry != null && isValid(key, entry)) {
+        Log.i(TAG, "Using cached Model for " + url);
+        revalidateInBackground(url, key, entry);
+        return getModelFile(key);
+      }
+
+      Log.i(TAG, "Downloading Model from " + url + "...");
+      try (Response response = client.newCall(createRequest(url, null)).execute()) {
+        store(key, response, null);
+      }
+      revalidatedKeys.add(key);
+      return getModelFile(key);
+    }
+  }
+
+  private Object getLock(String key) {
+    synchronized (locks) {
+      Object lock = locks.get(key);
+      if (lock == null) {
+        lock = new Object();
+        locks.put(key, lock);
+      }
+      return lock;
+    }
+  }
+
+  private File getModelFile(String key) {
+    return new File(directory, key + ".tflite");
+  }
+
+  private File getEntryFile(String key) {
+    return new File(directory, key + ".properties");
+  }
+
+  private static Request createRequest(String url, @Nullable Entry entry) {
+    Request.Builder builder = new Request.Builder().url(url);
+    if (entry != null) {
+      if (entry.etag != null) {
+        builder.header("If-None-Match", entry.etag);
+      }
+      if (entry.lastModified != null) {
+        builder.header("If-Modified-Since", entry.lastModified);
+      }
+    }
+    return builder.build();
+  }
+
+  private void revalidateInBackground(String url, String key, Entry entry) {
+    if ((entry.etag == null && entry.lastModified == null) || !revalidatedKeys.add(key)) {
+      // Nothing to revalidate with, or already revalidated
+      return;
+    }
+    client.newCall(createRequest(url, entry)).enqueue(new Callback() {
+      @Override
+      public void onFailure(@NonNull Call call, @NonNull IOException e) {
+        // Offline - keep using the cached Model
+        Log.w(TAG, "Failed to revalidate cached Model " + url, e);
+      }
+
+      @Override
+      public void onResponse(@NonNull Call call, @NonNull Response response) {
+        try (Response r = response) {
+          if (r.code() == 304) {
+            return;
+          }
+          synchronized (getLock(key)) {
+            store(key, r, entry);
+          }
+          Log.i(TAG, "Updated cached Model for " + url);
+        } catch (IOException e) {
+          Log.w(TAG, "Failed to update cached Model " + url, e);
+        }
+      }
+    });
+  }
+
+  /**
+   * Streams the response body into a temporary file, then atomically replaces the cached file.
+   * Models that are currently memory-mapped keep using the old file until they are unloaded. If the
+   * downloaded Model has the same hash as the cached one, only the entry is updated.
+   */
+  private void store(String key, Response response, @Nullable Entry cachedEntry) throws IOException {
+    ResponseBody body = response.body();
+    if (!response.isSuccessful() || body == null) {
+      throw new IOException("Response was not successful! (HTTP " + response.code() + ")");
+    }
+    if (!directory.isDirectory() && !directory.mkdirs()) {
+      throw new IOException("Failed to create the Model cache directory " + directory);
+    }
+
+    File temporaryFile = File.createTempFile(key, ".tmp", directory);
+    try {
+      MessageDigest digest = createDigest();
+      long size = 0;
+      try (InputStream input = body.byteStream();
+           FileOutputStream output = new FileOutputStream(temporaryFile)) {
+        byte[] chunk = new byte[CHUNK_SIZE];
+        int length;
+        while ((length = input.read(chunk)) != -1) {
+          digest.update(chunk, 0, length);
+          output.write(chunk, 0, length);
+          size += length;
+        }
+        output.getFD().sync();
+      }
+      long expectedSize = body.contentLength();
+      if (expectedSize >= 0 && size != expectedSize) {
+        throw new IOException("Download was incomplete! (" + size + " of " + expectedSize + " bytes)");
+      }
+
+      Entry entry = new Entry();
+      entry.etag = response.header("ETag");
+      entry.lastModified = response.header("Last-Modified");
+      entry.sha256 = toHex(digest.digest());
+      entry.size = size;
+
+      File modelFile = getModelFile(key);
+      boolean isUnchanged = cachedEntry != null && cachedEntry.sha256.equals(entry.sha256);
+      if (!isUnchanged) {
+        // rename() replaces the old file atomically
+        if (!temporaryFile.renameTo(modelFile)) {
+          throw new IOException("Failed to move the downloaded Model to " + modelFile);
+        }
+      }
+      entry.modifiedAt = modelFile.lastModified();
+      writeEntry(key, entry);
+      verifiedKeys.add(key);
+    } finally {
+      //noinspection ResultOfMethodCallIgnored
+      temporaryFile.delete();
+    }
+  }
+
+  /**
+   * Checks that the cached file still is the one that was downloaded. The size and modification
+   * time are compared every time, but reading the whole file to compare its hash only happens once
+   * per app start.
+   */
+  private boolean isValid(String key, Entry entry) {
+    File file = getModelFile(key);
+    if (file.isFile() && file.length() == entry.size && file.lastModified() == entry.modifiedAt
+            && (verifiedKeys.contains(key) || hasHash(file, entry.sha256))) {
+      verifiedKeys.add(key);
+      return true;
+    }
+    Log.w(TAG, "Cached Model " + file + " was changed or is corrupted, downloading it again.");
+    //noinspection ResultOfMethodCallIgnored
+    file.delete();
+    //noinspection ResultOfMethodCallIgnored
+    getEntryFile(key).delete();
+    return false;
+  }
+
+  private static boolean hasHash(File file, String sha256) {
+    MessageDigest digest = createDigest();
+    try (InputStream input = new FileInputStream(file)) {
+      byte[] chunk = new byte[CHUNK_SIZE];
+      int length;
+      while ((length = input.read(chunk)) != -1) {
+        digest.update(chunk, 0, length);
+      }
+    } catch (IOException e) {
+      Log.w(TAG, "Failed to read cached Model " + file, e);
+      return false;
+    }
+    return toHex(digest.digest()).equals(sha256);
+  }
+
+  @Nullable
+  private Entry readEntry(String key) {
+    File file = getEntryFile(key);
+    if (!file.isFile()) {
+      return null;
+    }
+    try (InputStream input = new FileInputStream(file)) {
+      Properties properties = new Properties();
+      properties.load(input);
+      Entry entry = new Entry();
+      entry.etag = properties.getProperty("etag");
+      entry.lastModified = properties.getProperty("lastModified");
+      entry.sha256 = properties.getProperty("sha256", "");
+      entry.size = Long.parseLong(properties.getProperty("size", "-1"));
+      entry.modifiedAt = Long.parseLong(properties.getProperty("modifiedAt", "-1"));
+      return entry;
+    } catch (IOException | IllegalArgumentException e) {
+      Log.w(TAG, "Failed to read cache entry " + file, e);
+      return null;
+    }
+  }
+
+  private void writeEntry(String key, Entry entry) throws IOException {
+    Properties properties = new Properties();
+    if (entry.etag != null) {
+      properties.setProperty("etag", entry.etag);
+    }
+    if (entry.lastModified != null) {
+      properties.setProperty("lastModified", entry.lastModified);
+    }
+    properties.setProperty("sha256", entry.sha256);
+    properties.setProperty("size", Long.toString(entry.size));
+    properties.setProperty("modifiedAt", Long.toString(entry.modifiedAt));
+
+    File temporaryFile = File.createTempFile(key, ".tmp", directory);
+    try {
+      try (FileOutputStream output = new FileOutputStream(temporaryFile)) {
+        properties.store(output, null);
+        output.getFD().sync();
+      }
+      File entryFile = getEntryFile(key);
+      if (!temporaryFile.renameTo(entryFile)) {
+        throw new IOException("Failed to write cache entry " + entryFile);
+      }
+    } finally {
+      //noinspection ResultOfMethodCallIgnored
+      temporaryFile.delete();
+    }
+  }
+
+  private static MessageDigest createDigest() {
+    try {
+      return MessageDigest.getInstance("SHA-256");
+    } catch (NoSuchAlgorithmException e) {
+      // SHA-256 is available on every Android version
+      throw new IllegalStateException(e);
+    }
+  }
+
+  private static String sha256(byte[] data) {
+    return toHex(createDigest().digest(data));
+  }
+
+  private static String toHex(byte[] bytes) {
+    StringBuilder builder = new StringBuilder(bytes.length * 2);
+    for (byte b : bytes) {
+      builder.append(String.format("%02x", b));
+    }
+    return builder.toString();
+  }
+}
@@ -2,7 +2,9 @@ package com.tflite;
 
 import android.annotation.SuppressLint;
 import android.content.Context;
+import android.content.res.AssetFileDescriptor;
 import android.net.Uri;
+import android.os.ParcelFileDescriptor;
 import android.util.Log;
 
 import androidx.annotation.NonNull;
@@ -33,6 +35,7 @@ public class TfliteModule extends ReactContextBaseJavaModule {
   public static final String NAME = "Tflite";
   private static WeakReference<ReactApplicationContext> weakContext;
   private static final OkHttpClient client = new OkHttpClient();
+  private static ModelDownloadCache downloadCache;
 
   public TfliteModule(ReactApplicationContext reactContext) {
     super(reactContext);
@@ -54,6 +57,76 @@ public class TfliteModule extends ReactContextBaseJavaModule {
     );
   }
 
+  private static synchronized ModelDownloadCache getDownloadCache(Context context) {
+    if (downloadCache == null) {
+      downloadCache = new ModelDownloadCache(context.getCacheDir(), client);
+    }
+    return downloadCache;
+  }
+
+  /**
+   * Opens the model at the given URL as a file descriptor so it can be memory-mapped from C++.
+   * Network URLs are downloaded into (or served from) the {@link ModelDownloadCache} first, unless
+   * they point to a development machine.
+   * Returns {fd, offset, length}, or null if the model cannot be mapped (e.g. a compressed
+   * resource) and has to be loaded using {@link #fetchByteDataFromUrl(String)} instead.
+   * Ownership of the returned file descriptor is transferred to the caller.
+   * @noinspection unused
+   */
+  @DoNotStrip
+  public static long[] openModelFileDescriptor(String url) {
+    try {
+      if (url.contains("://")) {
+        Uri uri = Uri.parse(url);
+        File file;
+        if (Objects.equals(uri.getScheme(), "http") || Objects.equals(uri.getScheme(), "https")) {
+          Context context = weakContext.get();
+          if (context == null || !ModelDownloadCache.isCacheable(url)) {
+            // e.g. served by the Metro packager, always download it again
+            return null;
+          }
+          file = getDownloadCache(context).getFile(url);
+        } else if (Objects.equals(uri.getScheme(), "file")) {
+          String path = Objects.requireNonNull(uri.getPath(), "File path cannot be null");
+          file = new File(path);
+          if (!file.getName().toLowerCase().endsWith(".tflite")) {
+            throw new SecurityException("Only .tflite files are allowed");
+          }
+        } else {
+          return null;
+        }
+        try (ParcelFileDescriptor fd = ParcelFileDescriptor.open(file, ParcelFileDescriptor.MODE_READ_ONLY)) {
+          // The size of the opened file, a cached download might be replaced in the meantime
+          long length = fd.getStatSize();
+          if (length <= 0) {
+            // Not a regular file (or empty), so it is read into memory instead
+            return null;
+          }
+          return new long[] { fd.detachFd(), 0, length };
+        }
+      } else {
+        Context context = weakContext.get();
+        if (context == null) {
+          return null;
+        }
+        int resourceId = getResourceId(context, url);
+        // Only works if the resource is stored uncompressed in the APK
+        try (AssetFileDescriptor fd = context.getResources().openRawResourceFd(resourceId)) {
+          if (fd == null || fd.getLength() == AssetFileDescriptor.UNKNOWN_LENGTH) {
+            return null;
+          }
+          ParcelFileDescriptor duplicate = fd.getParcelFileDescriptor().dup();
+          return new long[] { duplicate.detachFd(), fd.getStartOffset(), fd.getLength() };
+        }
+      }
+    } catch (SecurityException e) {
+      throw e;
+    } catch (Exception e) {
+      Log.w(NAME, "Cannot memory-map model " + url + ", falling back to reading it into memory.", e);
+      return null;
+    }
+  }
+
   /** @noinspection unused*/
   @DoNotStrip
   public static byte[] fetchByteDataFromUrl(String url) throws Exception {
@@ -0,0 +1,198 @@
+package com.tflite;
+
+import static org.junit.Assert.assertArrayEquals;
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertNotNull;
+import static org.junit.Assert.assertNull;
+import static org.junit.Assert.assertTrue;
+import static org.junit.Assert.fail;
+
+import org.junit.After;
+import org.junit.Before;
+import org.junit.Rule;
+import org.junit.Test;
+import org.junit.rules.TemporaryFolder;
+
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.RandomAccessFile;
+import java.nio.charset.StandardCharsets;
+import java.util.concurrent.TimeUnit;
+
+import okhttp3.OkHttpClient;
+import okhttp3.mockwebserver.MockResponse;
+import okhttp3.mockwebserver.MockWebServer;
+import okhttp3.mockwebserver.RecordedRequest;
+import okhttp3.mockwebserver.SocketPolicy;
+import okio.Buffer;
+
+/**
+ * Runs the {@link ModelDownloadCache} against a local HTTP server. Every new cache instance is
+ * like a new app start.
+ */
+public class ModelDownloadCacheTest {
+  private static final byte[] MODEL = "first model".getBytes(StandardCharsets.UTF_8);
+  private static final byte[] UPDATED_MODEL = "updated model".getBytes(StandardCharsets.UTF_8);
+
+  @Rule
+  public TemporaryFolder temporaryFolder = new TemporaryFolder();
+
+  private MockWebServer server;
+  private OkHttpClient client;
+  private File cacheDirectory;
+  private String url;
+
+  @Before
+  public void setUp() throws IOException {
+    server = new MockWebServer();
+    server.start();
+    client = new OkHttpClient();
+    cacheDirectory = temporaryFolder.newFolder("cache");
+    url = server.url("/models/model.tflite").toString();
+  }
+
+  @After
+  public void tearDown() throws IOException {
+    server.shutdown();
+  }
+
+  private static MockResponse modelResponse(byte[] model, String etag) {
+    return new MockResponse().setBody(new Buffer().write(model)).setHeader("ETag", etag);
+  }
+
+  private static byte[] readFile(File file) throws IOException {
+    byte[] data = new byte[(int) file.length()];
+    try (InputStream input = new FileInputStream(file)) {
+      int offset = 0;
+      int length;
+      while (offset < data.length && (length = input.read(data, offset, data.length - offset)) != -1) {
+        offset += length;
+      }
+    }
+    return data;
+  }
+
+  @Test
+  public void downloadsModelOnce() throws Exception {
+    server.enqueue(modelResponse(MODEL, "\"1\""));
+
+    ModelDownloadCache cache = new ModelDownloadCache(cacheDirectory, client);
+    File first = cache.getFile(url);
+    File second = cache.getFile(url);
+
+    assertArrayEquals(MODEL, readFile(first));
+    assertEquals(first, second);
+    // The second call was served from disk, and was already revalidated by the download
+    assertEquals(1, server.getRequestCount());
+  }
+
+  @Test
+  public void revalidatesOncePerAppStart() throws Exception {
+    server.enqueue(modelResponse(MODEL, "\"1\""));
+    new ModelDownloadCache(cacheDirectory, client).getFile(url);
+    server.takeRequest();
+
+    server.enqueue(new MockResponse().setResponseCode(304));
+    ModelDownloadCache cache = new ModelDownloadCache(cacheDirectory, client);
+    File file = cache.getFile(url);
+    cache.getFile(url);
+
+    assertArrayEquals(MODEL, readFile(file));
+    RecordedRequest revalidation = server.takeRequest(5, TimeUnit.SECONDS);
+    assertNotNull(revalidation);
+    assertEquals("\"1\"", revalidation.getHeader("If-None-Match"));
+    assertNull(server.takeRequest(200, TimeUnit.MILLISECONDS));
+  }
+
+  @Test
+  public void usesChangedModelFromTheNextLoadOn() throws Exception {
+    server.enqueue(modelResponse(MODEL, "\"1\""));
+    new ModelDownloadCache(cacheDirectory, client).getFile(url);
+
+    server.enqueue(modelResponse(UPDATED_MODEL, "\"2\""));
+    ModelDownloadCache cache = new ModelDownloadCache(cacheDirectory, client);
+    // Returned right away, the update is downloaded in the background
+    File file = cache.getFile(url);
+    assertArrayEquals(MODEL, readFile(file));
+
+    long timeout = System.currentTimeMillis() + 5000;
+    while (!new String(readFile(file), StandardCharsets.UTF_8).equals("updated model")) {
+      if (System.currentTimeMillis() > timeout) {
+        fail("The cached Model was not updated");
+      }
+      Thread.sleep(10);
+    }
+    // Wait until the entry for the new file was written as well
+    Thread.sleep(100);
+    assertArrayEquals(UPDATED_MODEL, readFile(new ModelDownloadCache(cacheDirectory, client).getFile(url)));
+    assertEquals(2, server.getRequestCount());
+  }
+
+  @Test
+  public void keepsUsingCachedModelWhenOffline() throws Exception {
+    server.enqueue(modelResponse(MODEL, "\"1\""));
+    new ModelDownloadCache(cacheDirectory, client).getFile(url);
+    server.shutdown();
+
+    File file = new ModelDownloadCache(cacheDirectory, client).getFile(url);
+    assertArrayEquals(MODEL, readFile(file));
+  }
+
+  @Test
+  public void doesNotCacheIncompleteDownloads() throws Exception {
+    server.enqueue(modelResponse(MODEL, "\"1\"")
+            .setSocketPolicy(SocketPolicy.DISCONNECT_DURING_RESPONSE_BODY));
+    ModelDownloadCache cache = new ModelDownloadCache(cacheDirectory, client);
+    try {
+      cache.getFile(url);
+      fail("An incomplete download must fail");
+    } catch (IOException expected) {
+      // expected
+    }
+
+    server.enqueue(modelResponse(MODEL, "\"1\""));
+    assertArrayEquals(MODEL, readFile(cache.getFile(url)));
+    assertEquals(2, server.getRequestCount());
+  }
+
+  @Test
+  public void downloadsChangedCacheFileAgain() throws Exception {
+    server.enqueue(modelResponse(MODEL, "\"1\""));
+    File file = new ModelDownloadCache(cacheDirectory, client).getFile(url);
+    try (RandomAccessFile truncated = new RandomAccessFile(file, "rw")) {
+      truncated.setLength(3);
+    }
+
+    server.enqueue(modelResponse(MODEL, "\"1\""));
+    assertArrayEquals(MODEL, readFile(new ModelDownloadCache(cacheDirectory, client).getFile(url)));
+    assertEquals(2, server.getRequestCount());
+  }
+
+  @Test
+  public void downloadsCorruptedCacheFileAgain() throws Exception {
+    server.enqueue(modelResponse(MODEL, "\"1\""));
+    File file = new ModelDownloadCache(cacheDirectory, client).getFile(url);
+    // Same size and modification time, only the content changed
+    long modifiedAt = file.lastModified();
+    try (RandomAccessFile corrupted = new RandomAccessFile(file, "rw")) {
+      corrupted.write('X');
+    }
+    assertTrue(file.setLastModified(modifiedAt));
+
+    server.enqueue(modelResponse(MODEL, "\"1\""));
+    assertArrayEquals(MODEL, readFile(new ModelDownloadCache(cacheDirectory, client).getFile(url)));
+    assertEquals(2, server.getRequestCount());
+  }
+
+  @Test
+  public void skipsDevelopmentUrls() {
+    assertFalse(ModelDownloadCache.isCacheable("http://localhost:8081/model.tflite"));
+    assertFalse(ModelDownloadCache.isCacheable("http://10.0.2.2:8081/model.tflite"));
+    assertFalse(ModelDownloadCache.isCacheable(
+            "http://192.168.1.20:8081/assets/assets/model.tflite?platform=android&hash=abc"));
+    assertTrue(ModelDownloadCache.isCacheable("https://example.com/models/model.tflite"));
+  }
+}
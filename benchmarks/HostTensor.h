@@ -0,0 +1,67 @@
+//
+//  HostTensor.h
+//  react-native-fast-tflite
+//
+//  A tensor that owns its memory, so the tensor helpers can be measured and tested without
+//  loading a Model.
+//
+
+#pragma once
+
+#include "TensorHelpers.h"
+#include <cstdint>
+#include <vector>
+
+class HostTensor {
+public:
+  /**
+   A 1D tensor of the given byte size, every byte is set to 1.
+   */
+  HostTensor(TfLiteType type, size_t byteSize)
+      : HostTensor(type, std::vector<int>{getCount(type, byteSize)}) {}
+  /**
+   A tensor with the given shape, every byte is set to 1.
+   */
+  HostTensor(TfLiteType type, const std::vector<int>& shape) {
+    size_t count = 1;
+    for (int dim : shape) {
+      count *= static_cast<size_t>(dim);
+    }
+    _data.resize(count * TensorHelpers::getTFLTensorDataTypeSize(type), 1);
+    _tensor.type = type;
+    _tensor.data.raw = _data.data();
+    _tensor.bytes = _data.size();
+    _tensor.name = "host";
+    _tensor.dims = TfLiteIntArrayCreate(static_cast<int>(shape.size()));
+    for (size_t i = 0; i < shape.size(); i++) {
+      _tensor.dims->data[i] = shape[i];
+    }
+    // Quantized types are converted with a per-tensor scale
+    _tensor.params.scale = 0.5f;
+    _tensor.params.zero_point = 3;
+  }
+  ~HostTensor() {
+    TfLiteIntArrayFree(_tensor.dims);
+  }
+  HostTensor(const HostTensor&) = delete;
+  HostTensor& operator=(const HostTensor&) = delete;
+
+  TfLiteTensor* get() {
+    return &_tensor;
+  }
+  size_t byteSize() const {
+    return _data.size();
+  }
+  template <typename T> T* data() {
+    return reinterpret_cast<T*>(_data.data());
+  }
+
+private:
+  static int getCount(TfLiteType type, size_t byteSize) {
+    return static_cast<int>(byteSize / TensorHelpers::getTFLTensorDataTypeSize(type));
+  }
+
+private:
+  TfLiteTensor _tensor{};
+  std::vector<uint8_t> _data;
+};
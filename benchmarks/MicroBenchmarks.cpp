@@ -0,0 +1,268 @@
+//
+//  MicroBenchmarks.cpp
+//  react-native-fast-tflite
+//
+//  Measures the copy paths between JS buffers and TFLite tensors for every supported data type
+//  and tensor sizes from 1 KB to 64 MB. Every benchmark reports bytes/second, the time per
+//  iteration of the smallest sizes is the per-call overhead. With Hermes, it also measures
+//  marshalling the inputs of a run: Reading the kind and memory of every TypedArray.
+//
+
+#include "HostTensor.h"
+#include "TensorHelpers.h"
+#include "jsi/TypedArray.h"
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef FAST_TFLITE_BENCHMARK_HERMES
+#include <hermes/hermes.h>
+#endif
+
+using namespace facebook;
+using namespace mrousavy;
+
+namespace {
+
+constexpr int64_t kMinSize = 1 << 10;
+constexpr int64_t kMaxSize = 64 << 20;
+constexpr int kSizeMultiplier = 8;
+
+struct DataType {
+  TfLiteType type;
+  const char* name;
+};
+
+constexpr DataType kDataTypes[] = {
+    {kTfLiteFloat32, "float32"}, {kTfLiteFloat16, "float16"}, {kTfLiteFloat64, "float64"},
+    {kTfLiteInt8, "int8"},       {kTfLiteInt16, "int16"},     {kTfLiteInt32, "int32"},
+    {kTfLiteInt64, "int64"},     {kTfLiteUInt8, "uint8"},     {kTfLiteUInt16, "uint16"},
+    {kTfLiteUInt32, "uint32"},   {kTfLiteUInt64, "uint64"},
+};
+// The types that floatIO converts from and to float32
+constexpr DataType kFloatIODataTypes[] = {
+    {kTfLiteFloat16, "float16"}, {kTfLiteInt8, "int8"}, {kTfLiteUInt8, "uint8"}};
+
+void setBytesProcessed(benchmark::State& state, size_t byteSize) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * byteSize));
+}
+
+// Async runs: Copying the JS buffer's memory into the input tensor (on the worker Thread).
+void updateTensorFromData(benchmark::State& state, TfLiteType type) {
+  HostTensor tensor(type, state.range(0));
+  std::vector<uint8_t> input(tensor.byteSize(), 2);
+  TensorData data{.data = input.data(), .size = input.size()};
+  for (auto _ : state) {
+    TensorHelpers::updateTensorFromData(tensor.get(), data);
+    benchmark::ClobberMemory();
+  }
+  setBytesProcessed(state, tensor.byteSize());
+}
+
+// Async runs: Copying the output tensor into a new buffer (on the worker Thread).
+void copyTensorData(benchmark::State& state, TfLiteType type) {
+  HostTensor tensor(type, state.range(0));
+  for (auto _ : state) {
+    auto buffer = TensorHelpers::copyTensorData(tensor.get());
+    benchmark::DoNotOptimize(buffer->data());
+  }
+  setBytesProcessed(state, tensor.byteSize());
+}
+
+// floatIO: Converting float16 or quantized outputs to float32.
+void copyTensorDataAsFloat32(benchmark::State& state, TfLiteType type) {
+  HostTensor tensor(type, state.range(0));
+  size_t count = tensor.byteSize() / TensorHelpers::getTFLTensorDataTypeSize(type);
+  for (auto _ : state) {
+    auto buffer = TensorHelpers::copyTensorDataAsFloat32(tensor.get(), 0, count);
+    benchmark::DoNotOptimize(buffer->data());
+  }
+  setBytesProcessed(state, tensor.byteSize());
+}
+
+// floatIO: Converting float32 inputs to float16 or quantizing them.
+void updateTensorFromFloat32Data(benchmark::State& state, TfLiteType type) {
+  HostTensor tensor(type, state.range(0));
+  size_t count = tensor.byteSize() / TensorHelpers::getTFLTensorDataTypeSize(type);
+  std::vector<float> input(count, 1.5f);
+  TensorData data{.data = reinterpret_cast<uint8_t*>(input.data()),
+                  .size = input.size() * sizeof(float),
+                  .isFloat32 = true};
+  for (auto _ : state) {
+    TensorHelpers::updateTensorFromFloat32Data(tensor.get(), 0, data);
+    benchmark::ClobberMemory();
+  }
+  setBytesProcessed(state, tensor.byteSize());
+}
+
+#ifdef FAST_TFLITE_BENCHMARK_HERMES
+
+jsi::Runtime& getRuntime() {
+  static std::unique_ptr<jsi::Runtime> runtime = []() {
+    std::unique_ptr<jsi::Runtime> runtime = hermes::makeHermesRuntime();
+    // Drops the cached PropNameIDs and TypedArray constructors once the Runtime is destroyed.
+    auto invalidateCache = std::make_shared<InvalidateCacheOnDestroy>(*runtime);
+    runtime->global().setProperty(*runtime, "__tfliteTypedArrayCache",
+                                  jsi::Object::createFromHostObject(*runtime, invalidateCache));
+    return runtime;
+  }();
+  return *runtime;
+}
+
+void createJSBufferForTensor(benchmark::State& state, TfLiteType type) {
+  jsi::Runtime& runtime = getRuntime();
+  HostTensor tensor(type, state.range(0));
+  for (auto _ : state) {
+    TypedArrayBase buffer = TensorHelpers::createJSBufferForTensor(runtime, tensor.get());
+    benchmark::DoNotOptimize(&buffer);
+  }
+  setBytesProcessed(state, tensor.byteSize());
+}
+
+// Sync runs: Copying a TypedArray into the input tensor.
+void updateTensorFromJSBuffer(benchmark::State& state, TfLiteType type) {
+  jsi::Runtime& runtime = getRuntime();
+  HostTensor tensor(type, state.range(0));
+  TypedArrayBase buffer = TensorHelpers::createJSBufferForTensor(runtime, tensor.get());
+  for (auto _ : state) {
+    TensorHelpers::updateTensorFromJSBuffer(runtime, tensor.get(), buffer);
+    benchmark::ClobberMemory();
+  }
+  setBytesProcessed(state, tensor.byteSize());
+}
+
+// Sync runs: Copying the output tensor into its cached TypedArray.
+void updateJSBufferFromTensor(benchmark::State& state, TfLiteType type) {
+  jsi::Runtime& runtime = getRuntime();
+  HostTensor tensor(type, state.range(0));
+  TypedArrayBase buffer = TensorHelpers::createJSBufferForTensor(runtime, tensor.get());
+  for (auto _ : state) {
+    TensorHelpers::updateJSBufferFromTensor(runtime, buffer, tensor.get());
+    benchmark::ClobberMemory();
+  }
+  setBytesProcessed(state, tensor.byteSize());
+}
+
+template <TypedArrayKind T> void typedArrayUpdateUnsafe(benchmark::State& state) {
+  using ContentType = TypedArrayBase::ContentType<T>;
+  jsi::Runtime& runtime = getRuntime();
+  size_t count = state.range(0) / sizeof(ContentType);
+  std::vector<ContentType> data(count);
+  TypedArray<T> array(runtime, count);
+  for (auto _ : state) {
+    array.updateUnsafe(runtime, data.data(), count * sizeof(ContentType));
+    benchmark::ClobberMemory();
+  }
+  setBytesProcessed(state, count * sizeof(ContentType));
+}
+
+jsi::Array createInputArrays(jsi::Runtime& runtime, size_t count) {
+  jsi::Array inputs(runtime, count);
+  for (size_t i = 0; i < count; i++) {
+    TypedArray<TypedArrayKind::Float32Array> input(runtime, 1024);
+    inputs.setValueAtIndex(runtime, i, jsi::Value(runtime, input));
+  }
+  return inputs;
+}
+
+// Every run: Reading the kind, data pointer and byte length of all input TypedArrays.
+void readTypedArrayInfo(benchmark::State& state) {
+  jsi::Runtime& runtime = getRuntime();
+  size_t count = state.range(0);
+  jsi::Array inputs = createInputArrays(runtime, count);
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; i++) {
+      jsi::Object input = inputs.getValueAtIndex(runtime, i).asObject(runtime);
+      TypedArrayInfo info = getTypedArrayInfo(runtime, input);
+      benchmark::DoNotOptimize(info.data);
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+
+// Baseline for `readTypedArrayInfo`: Finding the kind by reading `constructor.name`.
+void readTypedArrayConstructorName(benchmark::State& state) {
+  jsi::Runtime& runtime = getRuntime();
+  size_t count = state.range(0);
+  jsi::Array inputs = createInputArrays(runtime, count);
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; i++) {
+      jsi::Object input = inputs.getValueAtIndex(runtime, i).asObject(runtime);
+      std::string name = input.getPropertyAsObject(runtime, "constructor")
+                             .getProperty(runtime, "name")
+                             .asString(runtime)
+                             .utf8(runtime);
+      benchmark::DoNotOptimize(name.data());
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+
+#endif
+
+template <typename Func, size_t N>
+void registerForTypes(const std::string& name, Func func, const DataType (&dataTypes)[N]) {
+  for (const DataType& dataType : dataTypes) {
+    std::string benchmarkName = name + "/" + dataType.name;
+    benchmark::RegisterBenchmark(benchmarkName.c_str(), func, dataType.type)
+        ->RangeMultiplier(kSizeMultiplier)
+        ->Range(kMinSize, kMaxSize);
+  }
+}
+
+void registerBenchmarks() {
+  registerForTypes("TensorHelpers::updateTensorFromData", updateTensorFromData, kDataTypes);
+  registerForTypes("TensorHelpers::copyTensorData", copyTensorData, kDataTypes);
+  registerForTypes("TensorHelpers::copyTensorDataAsFloat32", copyTensorDataAsFloat32,
+                   kFloatIODataTypes);
+  registerForTypes("TensorHelpers::updateTensorFromFloat32Data", updateTensorFromFloat32Data,
+                   kFloatIODataTypes);
+#ifdef FAST_TFLITE_BENCHMARK_HERMES
+  registerForTypes("TensorHelpers::createJSBufferForTensor", createJSBufferForTensor,
+                   kDataTypes);
+  registerForTypes("TensorHelpers::updateTensorFromJSBuffer", updateTensorFromJSBuffer,
+                   kDataTypes);
+  registerForTypes("TensorHelpers::updateJSBufferFromTensor", updateJSBufferFromTensor,
+                   kDataTypes);
+
+#define REGISTER_UPDATE_UNSAFE(kind)                                                            \
+  benchmark::RegisterBenchmark("TypedArray::updateUnsafe/" #kind,                              \
+                               typedArrayUpdateUnsafe<TypedArrayKind::kind>)                    \
+      ->RangeMultiplier(kSizeMultiplier)                                                        \
+      ->Range(kMinSize, kMaxSize)
+  REGISTER_UPDATE_UNSAFE(Int8Array);
+  REGISTER_UPDATE_UNSAFE(Int16Array);
+  REGISTER_UPDATE_UNSAFE(Int32Array);
+  REGISTER_UPDATE_UNSAFE(Uint8Array);
+  REGISTER_UPDATE_UNSAFE(Uint8ClampedArray);
+  REGISTER_UPDATE_UNSAFE(Uint16Array);
+  REGISTER_UPDATE_UNSAFE(Uint32Array);
+  REGISTER_UPDATE_UNSAFE(Float32Array);
+  REGISTER_UPDATE_UNSAFE(Float64Array);
+  REGISTER_UPDATE_UNSAFE(BigInt64Array);
+  REGISTER_UPDATE_UNSAFE(BigUint64Array);
+#undef REGISTER_UPDATE_UNSAFE
+
+  // Number of input tensors
+  benchmark::RegisterBenchmark("getTypedArrayInfo", readTypedArrayInfo)->Arg(1)->Arg(4)->Arg(16);
+  benchmark::RegisterBenchmark("TypedArray constructor.name", readTypedArrayConstructorName)
+      ->Arg(1)
+      ->Arg(4)
+      ->Arg(16);
+#endif
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  registerBenchmarks();
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,319 @@
+//
+//  TfliteBench.cpp
+//  react-native-fast-tflite
+//
+//  Loads a .tflite Model with the same delegate and thread setup as the app, runs it a number of
+//  times and prints the latency of every phase, the throughput and the peak memory usage.
+//  With `--pool <n>`, it also measures how the throughput scales with interpreter pools of size 1
+//  to n that run in parallel, like `interpreterPoolSize` does in the app.
+//
+
+#include "Buffer.h"
+#include "InferenceStats.h"
+#include "InterpreterPool.h"
+#include "TensorHelpers.h"
+#include "TensorflowPlugin.h"
+#include <sys/resource.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct BenchOptions {
+  std::string modelPath;
+  size_t warmupRuns = 5;
+  size_t runs = 50;
+  // Measure the throughput of interpreter pools of size 1 to this, 0 to skip
+  size_t maxPoolSize = 0;
+  TensorflowPlugin::Options pluginOptions;
+  // Raw bytes for the input tensors, in order. Inputs without a file get a fixed pattern.
+  std::vector<std::string> inputPaths;
+};
+
+void printUsage(const char* program) {
+  fprintf(stderr,
+          "Usage: %s <model.tflite> [options]\n"
+          "  --warmup <n>      Runs before measuring (default 5)\n"
+          "  --iterations <n>  Measured runs (default 50)\n"
+          "  --threads <n>     CPU threads per interpreter (default: up to 4, split)\n"
+          "  --fp16            Let XNNPACK run float models with 16-bit floats\n"
+          "  --pool <n>        Also measure the throughput of 1 to n interpreters in parallel\n"
+          "  --input <file>    Raw bytes of the next input tensor, can be repeated\n",
+          program);
+}
+
+size_t parseCount(const char* value, const char* name) {
+  char* end = nullptr;
+  long count = strtol(value, &end, 10);
+  if (end == value || *end != '\0' || count < 0) {
+    throw std::runtime_error(std::string("Invalid value for ") + name + ": " + value);
+  }
+  return static_cast<size_t>(count);
+}
+
+BenchOptions parseArguments(int argc, char** argv) {
+  BenchOptions options;
+  for (int i = 1; i < argc; i++) {
+    std::string argument = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (argument == "--warmup" && hasValue) {
+      options.warmupRuns = parseCount(argv[++i], "--warmup");
+    } else if (argument == "--iterations" && hasValue) {
+      options.runs = parseCount(argv[++i], "--iterations");
+    } else if (argument == "--threads" && hasValue) {
+      options.pluginOptions.numThreads = static_cast<int>(parseCount(argv[++i], "--threads"));
+    } else if (argument == "--pool" && hasValue) {
+      options.maxPoolSize = parseCount(argv[++i], "--pool");
+    } else if (argument == "--fp16") {
+      options.pluginOptions.useFp16 = true;
+    } else if (argument == "--input" && hasValue) {
+      options.inputPaths.push_back(argv[++i]);
+    } else if (options.modelPath.empty() && argument.rfind("--", 0) != 0) {
+      options.modelPath = argument;
+    } else {
+      throw std::runtime_error("Unknown argument: " + argument);
+    }
+  }
+  if (options.modelPath.empty() || options.runs == 0) {
+    throw std::runtime_error("Missing model path or iterations!");
+  }
+  return options;
+}
+
+std::vector<uint8_t> readFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Failed to open input file \"" + path + "\"!");
+  }
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), {});
+}
+
+std::shared_ptr<TfLiteInterpreter>
+createInterpreter(const std::shared_ptr<TfLiteModel>& model, const BenchOptions& options,
+                  const TensorflowPlugin::Options& pluginOptions,
+                  std::shared_ptr<TensorflowPlugin::WeightsCache> weightsCache) {
+  auto interpreter = TensorflowPlugin::createInterpreter(model, pluginOptions, options.modelPath,
+                                                         std::move(weightsCache));
+  if (TfLiteInterpreterAllocateTensors(interpreter.get()) != kTfLiteOk) {
+    throw std::runtime_error("Failed to allocate the Model's tensors!");
+  }
+  return interpreter;
+}
+
+std::vector<std::vector<uint8_t>> createInputs(TfLiteInterpreter* interpreter,
+                                               const BenchOptions& options) {
+  int count = TfLiteInterpreterGetInputTensorCount(interpreter);
+  std::vector<std::vector<uint8_t>> inputs;
+  for (int i = 0; i < count; i++) {
+    const TfLiteTensor* tensor = TfLiteInterpreterGetInputTensor(interpreter, i);
+    size_t byteSize = TfLiteTensorByteSize(tensor);
+    if (static_cast<size_t>(i) < options.inputPaths.size()) {
+      std::vector<uint8_t> data = readFile(options.inputPaths[i]);
+      if (data.size() != byteSize) {
+        throw std::runtime_error("Input file \"" + options.inputPaths[i] + "\" has " +
+                                 std::to_string(data.size()) + " bytes, but input tensor " +
+                                 std::to_string(i) + " expects " + std::to_string(byteSize) +
+                                 " bytes!");
+      }
+      inputs.push_back(std::move(data));
+    } else {
+      // Small byte values are valid numbers for every data type, so this never produces NaNs.
+      std::vector<uint8_t> data(byteSize);
+      for (size_t byte = 0; byte < byteSize; byte++) {
+        data[byte] = static_cast<uint8_t>((byte * 31) % 7);
+      }
+      inputs.push_back(std::move(data));
+    }
+  }
+  return inputs;
+}
+
+/**
+ One run like an async `run(..)` call: Copy the inputs in, invoke, copy the outputs out.
+ */
+void runOnce(TfLiteInterpreter* interpreter, const std::vector<std::vector<uint8_t>>& inputs,
+             InferenceStats& stats) {
+  {
+    InferenceStats::Timer timer(stats, InferenceStats::Phase::Input);
+    for (size_t i = 0; i < inputs.size(); i++) {
+      TfLiteTensor* tensor = TfLiteInterpreterGetInputTensor(interpreter, i);
+      TensorData data{.data = const_cast<uint8_t*>(inputs[i].data()), .size = inputs[i].size()};
+      TensorHelpers::updateTensorFromData(tensor, data);
+    }
+  }
+  {
+    InferenceStats::Timer timer(stats, InferenceStats::Phase::Invoke);
+    TfLiteStatus status = TfLiteInterpreterInvoke(interpreter);
+    if (status != kTfLiteOk) {
+      throw std::runtime_error("Failed to run the Model! Status: " + std::to_string(status));
+    }
+  }
+  {
+    InferenceStats::Timer timer(stats, InferenceStats::Phase::Output);
+    int count = TfLiteInterpreterGetOutputTensorCount(interpreter);
+    for (int i = 0; i < count; i++) {
+      auto buffer = TensorHelpers::copyTensorData(TfLiteInterpreterGetOutputTensor(interpreter, i));
+    }
+  }
+}
+
+/**
+ Runs the Model from `poolSize` threads at once on an InterpreterPool of the same size, like async
+ `run(..)` calls with `interpreterPoolSize` do, and returns the throughput in inferences per second.
+ */
+double measurePoolThroughput(const std::shared_ptr<TfLiteModel>& model,
+                             const BenchOptions& options, size_t poolSize,
+                             const std::vector<std::vector<uint8_t>>& inputs) {
+  // Same thread split and shared weights as the app uses for a pool of this size
+  TensorflowPlugin::Options pluginOptions = options.pluginOptions;
+  pluginOptions.interpreterPoolSize = poolSize;
+  auto weightsCache = TensorflowPlugin::createWeightsCache(pluginOptions);
+  std::vector<std::shared_ptr<TfLiteInterpreter>> interpreters;
+  for (size_t i = 0; i < poolSize; i++) {
+    interpreters.push_back(createInterpreter(model, options, pluginOptions, weightsCache));
+  }
+  InterpreterPool pool(std::move(interpreters));
+
+  InferenceStats stats;
+  for (size_t i = 0; i < poolSize; i++) {
+    auto lease = pool.acquire(i);
+    for (size_t run = 0; run < options.warmupRuns; run++) {
+      runOnce(lease.get(), inputs, stats);
+    }
+  }
+
+  std::atomic<size_t> nextRun{0};
+  std::mutex errorMutex;
+  std::exception_ptr error;
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < poolSize; i++) {
+    threads.emplace_back([&]() {
+      try {
+        InferenceStats threadStats;
+        while (nextRun++ < options.runs) {
+          auto lease = pool.acquire();
+          runOnce(lease.get(), inputs, threadStats);
+        }
+      } catch (...) {
+        std::unique_lock<std::mutex> lock(errorMutex);
+        error = std::current_exception();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> totalTime = std::chrono::steady_clock::now() - start;
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+  return static_cast<double>(options.runs) / totalTime.count();
+}
+
+double getPeakMemoryMegabytes() {
+  struct rusage usage {};
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  // bytes
+  return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);
+#else
+  // kilobytes
+  return static_cast<double>(usage.ru_maxrss) / 1024.0;
+#endif
+}
+
+void printLatency(const char* name, const LatencyHistogram::Summary& summary) {
+  printf("  %-8s mean %9.3f ms   p50 %9.3f ms   p99 %9.3f ms   max %9.3f ms\n", name,
+         summary.mean, summary.p50, summary.p99, summary.max);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  BenchOptions options;
+  try {
+    options = parseArguments(argc, argv);
+  } catch (std::exception& error) {
+    fprintf(stderr, "%s\n", error.what());
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  try {
+    auto loadStart = std::chrono::steady_clock::now();
+    Buffer buffer = Buffer::mapFile(options.modelPath);
+    auto model = TensorflowPlugin::createModel(buffer, options.modelPath);
+    auto weightsCache = TensorflowPlugin::createWeightsCache(options.pluginOptions);
+    auto interpreter = createInterpreter(model, options, options.pluginOptions, weightsCache);
+    std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() -
+                                                         loadStart;
+    auto inputs = createInputs(interpreter.get(), options);
+
+    // Delegates finish preparing lazily, so the first run is a lot slower than the others.
+    InferenceStats warmupStats;
+    std::chrono::duration<double, std::milli> firstRunTime{0};
+    for (size_t i = 0; i < options.warmupRuns; i++) {
+      auto runStart = std::chrono::steady_clock::now();
+      runOnce(interpreter.get(), inputs, warmupStats);
+      if (i == 0) {
+        firstRunTime = std::chrono::steady_clock::now() - runStart;
+      }
+    }
+
+    InferenceStats stats;
+    LatencyHistogram totals;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < options.runs; i++) {
+      auto runStart = std::chrono::steady_clock::now();
+      runOnce(interpreter.get(), inputs, stats);
+      auto runTime = std::chrono::steady_clock::now() - runStart;
+      totals.record(std::chrono::duration_cast<std::chrono::microseconds>(runTime).count());
+    }
+    std::chrono::duration<double> totalTime = std::chrono::steady_clock::now() - start;
+
+    printf("Model:      %s\n", options.modelPath.c_str());
+    printf("Load:       %.1f ms\n", loadTime.count());
+    printf("Runs:       %zu (+ %zu warm-up)\n", options.runs, options.warmupRuns);
+    if (options.warmupRuns > 0) {
+      printf("First run:  %.3f ms\n", firstRunTime.count());
+    }
+    printf("Latency:\n");
+    printLatency("total", totals.getSummary());
+    for (auto phase : {InferenceStats::Phase::Input, InferenceStats::Phase::Invoke,
+                       InferenceStats::Phase::Output}) {
+      printLatency(InferenceStats::getPhaseName(phase), stats.get(phase).getSummary());
+    }
+    printf("Throughput: %.2f inferences/s\n", static_cast<double>(options.runs) /
+                                                   totalTime.count());
+    if (options.maxPoolSize > 0) {
+      printf("Pool scaling:\n");
+      double baseline = 0;
+      for (size_t poolSize = 1; poolSize <= options.maxPoolSize; poolSize++) {
+        double throughput = measurePoolThroughput(model, options, poolSize, inputs);
+        if (poolSize == 1) {
+          baseline = throughput;
+        }
+        printf("  %2zu interpreters  %9.2f inferences/s   %.2fx\n", poolSize, throughput,
+               throughput / baseline);
+      }
+    }
+    printf("Peak RSS:   %.1f MB\n", getPeakMemoryMegabytes());
+  } catch (std::exception& error) {
+    fprintf(stderr, "%s\n", error.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,65 @@
+//
+//  BufferTest.cpp
+//  react-native-fast-tflite
+//
+
+#include "Buffer.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+class BufferTest : public testing::Test {
+protected:
+  void SetUp() override {
+    _path = testing::TempDir() + "buffer-test-" + std::to_string(getpid()) + ".tflite";
+  }
+  void TearDown() override {
+    std::remove(_path.c_str());
+  }
+
+  void writeFile(const std::string& contents) {
+    FILE* file = std::fopen(_path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    std::fwrite(contents.data(), 1, contents.size(), file);
+    std::fclose(file);
+  }
+
+  std::string _path;
+};
+
+TEST_F(BufferTest, MapsWholeFile) {
+  writeFile("model bytes");
+  Buffer buffer = Buffer::mapFile(_path);
+  ASSERT_EQ(buffer.size, 11u);
+  EXPECT_EQ(std::string(static_cast<char*>(buffer.data), buffer.size), "model bytes");
+  EXPECT_NE(buffer.mappedAddress, nullptr);
+  buffer.release();
+  EXPECT_EQ(buffer.data, nullptr);
+  EXPECT_EQ(buffer.size, 0u);
+}
+
+TEST_F(BufferTest, MapsRegionAtUnalignedOffset) {
+  // Like a Model stored inside an APK, the region does not start at a page boundary.
+  std::string contents(10000, 'x');
+  contents.replace(4099, 5, "model");
+  writeFile(contents);
+
+  int fd = open(_path.c_str(), O_RDONLY);
+  ASSERT_GE(fd, 0);
+  Buffer buffer = Buffer::mapFileDescriptor(fd, 4099, 5);
+  EXPECT_EQ(std::string(static_cast<char*>(buffer.data), buffer.size), "model");
+  buffer.release();
+}
+
+TEST_F(BufferTest, ThrowsForMissingOrEmptyFiles) {
+  EXPECT_THROW(Buffer::mapFile(_path), std::runtime_error);
+  writeFile("");
+  EXPECT_THROW(Buffer::mapFile(_path), std::runtime_error);
+}
+
+} // namespace
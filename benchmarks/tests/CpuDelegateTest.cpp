@@ -0,0 +1,125 @@
+//
+//  CpuDelegateTest.cpp
+//  react-native-fast-tflite
+//
+//  The tests that need a real Model only run if FAST_TFLITE_TEST_MODEL points to a .tflite file.
+//
+
+#include "Buffer.h"
+#include "TensorflowPlugin.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using Outputs = std::vector<std::vector<uint8_t>>;
+
+TEST(CpuDelegate, SplitsDefaultThreadsAcrossInterpreters) {
+  TensorflowPlugin::Options options;
+  int threads = TensorflowPlugin::getNumThreads(options);
+  EXPECT_GE(threads, 1);
+  EXPECT_LE(threads, 4);
+
+  options.interpreterPoolSize = 2;
+  EXPECT_EQ(TensorflowPlugin::getNumThreads(options), std::max(threads / 2, 1));
+  // Every pipeline stage has its own Interpreter as well
+  options.interpreterPoolSize = 1;
+  options.pipelineDepth = 3;
+  EXPECT_EQ(TensorflowPlugin::getNumThreads(options), std::max(threads / 3, 1));
+  options.interpreterPoolSize = 64;
+  EXPECT_EQ(TensorflowPlugin::getNumThreads(options), 1);
+}
+
+TEST(CpuDelegate, KeepsExplicitThreadCount) {
+  TensorflowPlugin::Options options;
+  options.numThreads = 3;
+  options.interpreterPoolSize = 4;
+  EXPECT_EQ(TensorflowPlugin::getNumThreads(options), 3);
+}
+
+TEST(CpuDelegate, OtherDelegatesHaveNoWeightsCache) {
+  TensorflowPlugin::Options options;
+  options.delegate = TensorflowPlugin::Delegate::CoreML;
+  EXPECT_EQ(TensorflowPlugin::createWeightsCache(options), nullptr);
+}
+
+class CpuDelegateModelTest : public testing::Test {
+protected:
+  void SetUp() override {
+    const char* path = std::getenv("FAST_TFLITE_TEST_MODEL");
+    if (path == nullptr) {
+      GTEST_SKIP() << "Set FAST_TFLITE_TEST_MODEL to a .tflite file to run this test.";
+    }
+    _path = path;
+    _model = TensorflowPlugin::createModel(Buffer::mapFile(_path), _path);
+    // One thread, so the results of different Interpreters are bit-exact.
+    _options.numThreads = 1;
+  }
+
+  std::shared_ptr<TfLiteInterpreter>
+  createInterpreter(std::shared_ptr<TensorflowPlugin::WeightsCache> weightsCache) {
+    auto interpreter = TensorflowPlugin::createInterpreter(_model, _options, _path, weightsCache);
+    EXPECT_EQ(TfLiteInterpreterAllocateTensors(interpreter.get()), kTfLiteOk);
+    return interpreter;
+  }
+
+  static Outputs run(TfLiteInterpreter* interpreter) {
+    for (int i = 0; i < TfLiteInterpreterGetInputTensorCount(interpreter); i++) {
+      TfLiteTensor* tensor = TfLiteInterpreterGetInputTensor(interpreter, i);
+      auto* data = static_cast<uint8_t*>(TfLiteTensorData(tensor));
+      // Small byte values are valid numbers for every data type
+      for (size_t byte = 0; byte < TfLiteTensorByteSize(tensor); byte++) {
+        data[byte] = static_cast<uint8_t>((byte * 31) % 7);
+      }
+    }
+    EXPECT_EQ(TfLiteInterpreterInvoke(interpreter), kTfLiteOk);
+    Outputs outputs;
+    for (int i = 0; i < TfLiteInterpreterGetOutputTensorCount(interpreter); i++) {
+      const TfLiteTensor* tensor = TfLiteInterpreterGetOutputTensor(interpreter, i);
+      auto* data = static_cast<const uint8_t*>(TfLiteTensorData(tensor));
+      outputs.emplace_back(data, data + TfLiteTensorByteSize(tensor));
+    }
+    return outputs;
+  }
+
+  std::string _path;
+  std::shared_ptr<TfLiteModel> _model;
+  TensorflowPlugin::Options _options;
+};
+
+TEST_F(CpuDelegateModelTest, PoolSharesPackedWeights) {
+  Outputs expected = run(createInterpreter(nullptr).get());
+
+  auto weightsCache = TensorflowPlugin::createWeightsCache(_options);
+  ASSERT_NE(weightsCache, nullptr);
+  std::vector<std::shared_ptr<TfLiteInterpreter>> pool;
+  for (int i = 0; i < 3; i++) {
+    pool.push_back(createInterpreter(weightsCache));
+  }
+  // The cache is kept alive by the Interpreters
+  weightsCache = nullptr;
+  for (const auto& interpreter : pool) {
+    EXPECT_EQ(run(interpreter.get()), expected);
+  }
+}
+
+TEST_F(CpuDelegateModelTest, WeightsCacheFileGivesSameResults) {
+  Outputs expected = run(createInterpreter(nullptr).get());
+
+  _options.weightsCachePath =
+      testing::TempDir() + "weights-cache-" + std::to_string(getpid()) + ".xnnpack";
+  // The first load packs the weights into the file, the second one maps it.
+  for (int load = 0; load < 2; load++) {
+    auto interpreter = createInterpreter(TensorflowPlugin::createWeightsCache(_options));
+    EXPECT_EQ(run(interpreter.get()), expected);
+  }
+  std::remove(_options.weightsCachePath.c_str());
+}
+
+} // namespace
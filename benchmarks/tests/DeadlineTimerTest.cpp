@@ -0,0 +1,74 @@
+//
+//  DeadlineTimerTest.cpp
+//  react-native-fast-tflite
+//
+
+#include "DeadlineTimer.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+
+TEST(DeadlineTimer, CallsCallbacksInDeadlineOrder) {
+  DeadlineTimer timer("Test Timer");
+  std::mutex mutex;
+  std::vector<int> order;
+  std::promise<void> done;
+  auto record = [&](int value) {
+    return [&, value]() {
+      std::unique_lock<std::mutex> lock(mutex);
+      order.push_back(value);
+      if (order.size() == 3) {
+        done.set_value();
+      }
+    };
+  };
+
+  auto now = Clock::now();
+  timer.schedule(now + 30ms, record(3));
+  timer.schedule(now + 10ms, record(1));
+  // An earlier deadline than the one the Thread already waits for
+  timer.schedule(now + 20ms, record(2));
+  done.get_future().wait();
+  EXPECT_EQ(order, (std::vector<int>{1, 2, 3}));
+}
+
+TEST(DeadlineTimer, DoesNotCallBeforeDeadline) {
+  DeadlineTimer timer("Test Timer");
+  std::promise<Clock::time_point> called;
+  auto deadline = Clock::now() + 20ms;
+  timer.schedule(deadline, [&]() { called.set_value(Clock::now()); });
+  EXPECT_GE(called.get_future().get(), deadline);
+}
+
+TEST(DeadlineTimer, CancelledCallbackIsNeverCalled) {
+  DeadlineTimer timer("Test Timer");
+  std::atomic<bool> cancelledWasCalled{false};
+  uint64_t id = timer.schedule(Clock::now() + 10ms, [&]() { cancelledWasCalled = true; });
+  timer.cancel(id);
+
+  std::promise<void> later;
+  timer.schedule(Clock::now() + 30ms, [&]() { later.set_value(); });
+  later.get_future().wait();
+  EXPECT_FALSE(cancelledWasCalled);
+  // Cancelling again (or after the call) does nothing
+  timer.cancel(id);
+}
+
+TEST(DeadlineTimer, DestroyingDropsPendingCallbacks) {
+  std::atomic<bool> wasCalled{false};
+  {
+    DeadlineTimer timer("Test Timer");
+    timer.schedule(Clock::now() + 1h, [&]() { wasCalled = true; });
+  }
+  EXPECT_FALSE(wasCalled);
+}
+
+} // namespace
@@ -0,0 +1,83 @@
+//
+//  DetectionTest.cpp
+//  react-native-fast-tflite
+//
+
+#include "HostTensor.h"
+#include "TensorHelpers.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+constexpr size_t kValuesPerDetection = 6;
+
+std::vector<float> decode(const TfLiteTensor* boxes, const TfLiteTensor* scores, size_t sample,
+                          size_t batchSize, const DetectionOptions& options) {
+  auto buffer = TensorHelpers::decodeDetections(boxes, scores, sample, batchSize, options);
+  auto* data = reinterpret_cast<const float*>(buffer->data());
+  return std::vector<float>(data, data + buffer->size() / sizeof(float));
+}
+
+// SSD outputs without a batch dimension (`[N, 4]` and `[N, C]`) stack the samples along N.
+TEST(Detection, DecodesSamplesOfBatchedSSDOutputs) {
+  constexpr size_t boxesPerSample = 2;
+  constexpr size_t batchSize = 2;
+  HostTensor boxes(kTfLiteFloat32, std::vector<int>{boxesPerSample * batchSize, 4});
+  HostTensor scores(kTfLiteFloat32, std::vector<int>{boxesPerSample * batchSize, 1});
+  std::fill_n(scores.data<float>(), boxesPerSample * batchSize, 0.0f);
+  // One box per sample as [y1, x1, y2, x2]
+  const float sampleBoxes[batchSize][4] = {{0.1f, 0.2f, 0.3f, 0.4f}, {0.5f, 0.6f, 0.7f, 0.8f}};
+  for (size_t sample = 0; sample < batchSize; sample++) {
+    std::copy_n(sampleBoxes[sample], 4, boxes.data<float>() + sample * boxesPerSample * 4);
+    scores.data<float>()[sample * boxesPerSample] = 0.9f;
+  }
+
+  DetectionOptions options;
+  for (size_t sample = 0; sample < batchSize; sample++) {
+    std::vector<float> detections = decode(boxes.get(), scores.get(), sample, batchSize, options);
+    ASSERT_EQ(detections.size(), kValuesPerDetection);
+    const float* box = sampleBoxes[sample];
+    EXPECT_FLOAT_EQ(detections[0], box[1]);
+    EXPECT_FLOAT_EQ(detections[1], box[0]);
+    EXPECT_FLOAT_EQ(detections[2], box[3]);
+    EXPECT_FLOAT_EQ(detections[3], box[2]);
+    EXPECT_FLOAT_EQ(detections[4], 0.9f);
+    EXPECT_FLOAT_EQ(detections[5], 0.0f);
+  }
+}
+
+TEST(Detection, DecodesSamplesOfBatchedYOLOOutputs) {
+  constexpr size_t boxesPerSample = 8;
+  constexpr size_t batchSize = 2;
+  // `[N, 4 + C]` rows of [cx, cy, w, h, score] without a batch dimension
+  HostTensor output(kTfLiteFloat32, std::vector<int>{boxesPerSample * batchSize, 5});
+  std::fill_n(output.data<float>(), boxesPerSample * batchSize * 5, 0.0f);
+  for (size_t sample = 0; sample < batchSize; sample++) {
+    float* row = output.data<float>() + (sample * boxesPerSample + sample) * 5;
+    float center = sample == 0 ? 0.25f : 0.75f;
+    std::copy_n(std::vector<float>{center, center, 0.5f, 0.5f, 0.8f}.data(), 5, row);
+  }
+
+  DetectionOptions options;
+  options.format = DetectionOptions::YOLO;
+  for (size_t sample = 0; sample < batchSize; sample++) {
+    std::vector<float> detections = decode(output.get(), nullptr, sample, batchSize, options);
+    ASSERT_EQ(detections.size(), kValuesPerDetection);
+    float center = sample == 0 ? 0.25f : 0.75f;
+    EXPECT_FLOAT_EQ(detections[0], center - 0.25f);
+    EXPECT_FLOAT_EQ(detections[1], center - 0.25f);
+    EXPECT_FLOAT_EQ(detections[2], center + 0.25f);
+    EXPECT_FLOAT_EQ(detections[3], center + 0.25f);
+    EXPECT_FLOAT_EQ(detections[4], 0.8f);
+  }
+}
+
+TEST(Detection, ThrowsForOutputsThatAreNotBatched) {
+  HostTensor boxes(kTfLiteFloat32, std::vector<int>{3, 4});
+  HostTensor scores(kTfLiteFloat32, std::vector<int>{3, 1});
+  EXPECT_THROW(decode(boxes.get(), scores.get(), 0, 2, DetectionOptions()), std::runtime_error);
+}
+
+} // namespace
@@ -0,0 +1,124 @@
+//
+//  Float16Test.cpp
+//  react-native-fast-tflite
+//
+//  The array conversions are compared against the scalar ones, so the vectorized paths are covered
+//  on hosts that compile them (F16C or NEON).
+//
+
+#include "Float16.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace {
+
+constexpr uint16_t kPositiveInfinity = 0x7c00;
+
+bool isNaN(uint16_t value) {
+  return (value & 0x7c00) == 0x7c00 && (value & 0x3ff) != 0;
+}
+
+uint32_t getBits(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+std::vector<uint16_t> getAllHalves() {
+  std::vector<uint16_t> halves(1 << 16);
+  for (size_t i = 0; i < halves.size(); i++) {
+    halves[i] = static_cast<uint16_t>(i);
+  }
+  return halves;
+}
+
+TEST(Float16, ConvertsKnownValues) {
+  EXPECT_EQ(Float16::toFloat32(uint16_t(0x3c00)), 1.0f);
+  EXPECT_EQ(Float16::toFloat32(uint16_t(0xc000)), -2.0f);
+  EXPECT_EQ(Float16::toFloat32(uint16_t(0x7bff)), 65504.0f);
+  EXPECT_EQ(Float16::toFloat32(uint16_t(0x0001)), std::ldexp(1.0f, -24));
+  EXPECT_EQ(Float16::toFloat32(kPositiveInfinity), std::numeric_limits<float>::infinity());
+  EXPECT_TRUE(std::signbit(Float16::toFloat32(uint16_t(0x8000))));
+
+  EXPECT_EQ(Float16::fromFloat32(1.0f), 0x3c00);
+  EXPECT_EQ(Float16::fromFloat32(-2.0f), 0xc000);
+  EXPECT_EQ(Float16::fromFloat32(-0.0f), 0x8000);
+  EXPECT_TRUE(isNaN(Float16::fromFloat32(std::numeric_limits<float>::quiet_NaN())));
+}
+
+TEST(Float16, RoundTripsEveryHalf) {
+  for (uint16_t half : getAllHalves()) {
+    uint16_t roundTripped = Float16::fromFloat32(Float16::toFloat32(half));
+    if (isNaN(half)) {
+      EXPECT_TRUE(isNaN(roundTripped)) << std::hex << half;
+    } else {
+      ASSERT_EQ(roundTripped, half) << std::hex << half;
+    }
+  }
+}
+
+TEST(Float16, RoundsToNearestEven) {
+  // Right between two halves, the one with the even mantissa wins.
+  EXPECT_EQ(Float16::fromFloat32(1.0f + std::ldexp(1.0f, -11)), 0x3c00);
+  EXPECT_EQ(Float16::fromFloat32(1.0f + 3 * std::ldexp(1.0f, -11)), 0x3c02);
+  EXPECT_EQ(Float16::fromFloat32(1.0f + std::ldexp(1.2f, -11)), 0x3c01);
+  // The same for subnormal halves
+  EXPECT_EQ(Float16::fromFloat32(std::ldexp(1.0f, -25)), 0x0000);
+  EXPECT_EQ(Float16::fromFloat32(3 * std::ldexp(1.0f, -25)), 0x0002);
+  // Values that round to the smallest normal half
+  EXPECT_EQ(Float16::fromFloat32(std::ldexp(1.0f, -14) - std::ldexp(1.0f, -26)), 0x0400);
+}
+
+TEST(Float16, OverflowsToInfinity) {
+  EXPECT_EQ(Float16::fromFloat32(65519.0f), 0x7bff);
+  EXPECT_EQ(Float16::fromFloat32(65520.0f), kPositiveInfinity);
+  EXPECT_EQ(Float16::fromFloat32(1e10f), kPositiveInfinity);
+  EXPECT_EQ(Float16::fromFloat32(-1e10f), 0xfc00);
+  EXPECT_EQ(Float16::fromFloat32(std::numeric_limits<float>::infinity()), kPositiveInfinity);
+}
+
+TEST(Float16, ArrayToFloat32MatchesScalar) {
+  std::vector<uint16_t> halves = getAllHalves();
+  std::vector<float> output(halves.size());
+  Float16::toFloat32(halves.data(), output.data(), halves.size());
+  for (size_t i = 0; i < halves.size(); i++) {
+    float expected = Float16::toFloat32(halves[i]);
+    if (std::isnan(expected)) {
+      EXPECT_TRUE(std::isnan(output[i])) << std::hex << halves[i];
+    } else {
+      ASSERT_EQ(getBits(output[i]), getBits(expected)) << std::hex << halves[i];
+    }
+  }
+}
+
+TEST(Float16, ArrayFromFloat32MatchesScalar) {
+  // Float bit patterns with a stride that hits all exponents
+  std::vector<float> values;
+  for (uint64_t bits = 0; bits <= 0xffffffff; bits += 0x1001) {
+    uint32_t value = static_cast<uint32_t>(bits);
+    float number;
+    std::memcpy(&number, &value, sizeof(number));
+    values.push_back(number);
+  }
+  if (values.size() % 8 == 0) {
+    // Leaves a tail for the scalar loop
+    values.pop_back();
+  }
+
+  std::vector<uint16_t> output(values.size());
+  Float16::fromFloat32(values.data(), output.data(), values.size());
+  for (size_t i = 0; i < values.size(); i++) {
+    uint16_t expected = Float16::fromFloat32(values[i]);
+    if (isNaN(expected)) {
+      EXPECT_TRUE(isNaN(output[i])) << values[i];
+    } else {
+      ASSERT_EQ(output[i], expected) << values[i];
+    }
+  }
+}
+
+} // namespace
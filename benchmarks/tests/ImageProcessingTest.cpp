@@ -0,0 +1,327 @@
+//
+//  ImageProcessingTest.cpp
+//  react-native-fast-tflite
+//
+//  Compares the resampled images with reference images that are computed per pixel in floating
+//  point, or by rotating and mirroring the source directly.
+//
+
+#include "ImageProcessing.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Color = std::array<uint8_t, 3>;
+
+// A tightly packed RGB image
+struct Image {
+  size_t width = 0;
+  size_t height = 0;
+  std::vector<uint8_t> pixels;
+
+  Image(size_t width, size_t height) : width(width), height(height), pixels(width * height * 3) {}
+
+  uint8_t* at(size_t x, size_t y) {
+    return pixels.data() + (y * width + x) * 3;
+  }
+  const uint8_t* at(size_t x, size_t y) const {
+    return pixels.data() + (y * width + x) * 3;
+  }
+};
+
+Image createTestImage(size_t width, size_t height) {
+  Image image(width, height);
+  for (size_t y = 0; y < height; y++) {
+    for (size_t x = 0; x < width; x++) {
+      uint8_t* pixel = image.at(x, y);
+      pixel[0] = static_cast<uint8_t>(x * 255 / std::max<size_t>(width - 1, 1));
+      pixel[1] = static_cast<uint8_t>(y * 255 / std::max<size_t>(height - 1, 1));
+      pixel[2] = static_cast<uint8_t>((x * 7 + y * 13) % 256);
+    }
+  }
+  return image;
+}
+
+Image resample(const ImageBuffer& buffer, const ImageTransform& transform, size_t width,
+               size_t height) {
+  Image result(width, height);
+  ImageProcessing::resample(buffer, transform, width, height,
+                            [&](size_t row, const uint8_t* pixels) {
+                              std::copy_n(pixels, width * 3, result.at(0, row));
+                            });
+  return result;
+}
+
+ImageBuffer createRGBBuffer(const Image& image) {
+  return ImageProcessing::createImageBuffer(image.pixels.data(), image.pixels.size(),
+                                            PixelFormat::RGB, image.width, image.height);
+}
+
+Image rotateClockwise(const Image& image) {
+  Image result(image.height, image.width);
+  for (size_t y = 0; y < result.height; y++) {
+    for (size_t x = 0; x < result.width; x++) {
+      std::copy_n(image.at(y, image.height - 1 - x), 3, result.at(x, y));
+    }
+  }
+  return result;
+}
+
+Image mirror(const Image& image) {
+  Image result(image.width, image.height);
+  for (size_t y = 0; y < image.height; y++) {
+    for (size_t x = 0; x < image.width; x++) {
+      std::copy_n(image.at(image.width - 1 - x, y), 3, result.at(x, y));
+    }
+  }
+  return result;
+}
+
+/**
+ Bilinear downscaling in floating point, with pixel centers at +0.5 and clamped edges.
+ */
+Image resampleReference(const Image& image, size_t width, size_t height) {
+  auto getCoordinate = [](size_t index, size_t outputSize, size_t inputSize) {
+    double position = (index + 0.5) / outputSize * inputSize - 0.5;
+    return std::clamp(position, 0.0, static_cast<double>(inputSize - 1));
+  };
+  Image result(width, height);
+  for (size_t y = 0; y < height; y++) {
+    double sourceY = getCoordinate(y, height, image.height);
+    auto y0 = static_cast<size_t>(sourceY);
+    size_t y1 = std::min(y0 + 1, image.height - 1);
+    double weightY = sourceY - y0;
+    for (size_t x = 0; x < width; x++) {
+      double sourceX = getCoordinate(x, width, image.width);
+      auto x0 = static_cast<size_t>(sourceX);
+      size_t x1 = std::min(x0 + 1, image.width - 1);
+      double weightX = sourceX - x0;
+      for (size_t channel = 0; channel < 3; channel++) {
+        auto lerp = [&](size_t row) {
+          return image.at(x0, row)[channel] * (1 - weightX) + image.at(x1, row)[channel] * weightX;
+        };
+        double value = lerp(y0) * (1 - weightY) + lerp(y1) * weightY;
+        result.at(x, y)[channel] = static_cast<uint8_t>(std::lround(value));
+      }
+    }
+  }
+  return result;
+}
+
+void expectImagesNear(const Image& actual, const Image& expected, int tolerance) {
+  ASSERT_EQ(actual.width, expected.width);
+  ASSERT_EQ(actual.height, expected.height);
+  for (size_t i = 0; i < actual.pixels.size(); i++) {
+    size_t pixel = i / 3;
+    ASSERT_LE(std::abs(actual.pixels[i] - expected.pixels[i]), tolerance)
+        << "at x " << pixel % actual.width << ", y " << pixel / actual.width << ", channel "
+        << i % 3;
+  }
+}
+
+// Full-range BT.601 (JFIF), like camera frames
+Color convertRGBToYUV(const Color& rgb) {
+  double r = rgb[0], g = rgb[1], b = rgb[2];
+  auto toByte = [](double value) {
+    return static_cast<uint8_t>(std::clamp(std::lround(value), 0l, 255l));
+  };
+  return {toByte(0.299 * r + 0.587 * g + 0.114 * b),
+          toByte(128 - 0.168736 * r - 0.331264 * g + 0.5 * b),
+          toByte(128 + 0.5 * r - 0.418688 * g - 0.081312 * b)};
+}
+
+/**
+ Creates a YUV image in the given format. `getYUV(x, y)` is called for every luma sample, the
+ chroma of a 2x2 block is taken from its top left pixel.
+ */
+template <typename GetYUV>
+std::vector<uint8_t> createYUVImage(PixelFormat format, size_t width, size_t height,
+                                    GetYUV&& getYUV) {
+  size_t chromaWidth = (width + 1) / 2;
+  size_t chromaHeight = (height + 1) / 2;
+  std::vector<uint8_t> data(width * height + chromaWidth * chromaHeight * 2);
+  uint8_t* chroma = data.data() + width * height;
+  for (size_t y = 0; y < height; y++) {
+    for (size_t x = 0; x < width; x++) {
+      Color yuv = getYUV(x, y);
+      data[y * width + x] = yuv[0];
+      if (x % 2 != 0 || y % 2 != 0) {
+        continue;
+      }
+      size_t index = (y / 2) * chromaWidth + x / 2;
+      switch (format) {
+        case PixelFormat::NV12:
+          chroma[index * 2] = yuv[1];
+          chroma[index * 2 + 1] = yuv[2];
+          break;
+        case PixelFormat::NV21:
+          chroma[index * 2] = yuv[2];
+          chroma[index * 2 + 1] = yuv[1];
+          break;
+        default:
+          chroma[index] = yuv[1];
+          chroma[chromaWidth * chromaHeight + index] = yuv[2];
+          break;
+      }
+    }
+  }
+  return data;
+}
+
+Image resampleYUV(PixelFormat format, const std::vector<uint8_t>& data, size_t width,
+                  size_t height) {
+  ImageBuffer buffer =
+      ImageProcessing::createImageBuffer(data.data(), data.size(), format, width, height);
+  return resample(buffer, ImageTransform(), width, height);
+}
+
+constexpr PixelFormat kYUVFormats[] = {PixelFormat::NV12, PixelFormat::NV21, PixelFormat::I420};
+
+TEST(ImageProcessing, CopiesImageOfSameSize) {
+  Image image = createTestImage(7, 5);
+  expectImagesNear(resample(createRGBBuffer(image), ImageTransform(), 7, 5), image, 0);
+}
+
+TEST(ImageProcessing, RotatesAndMirrors) {
+  Image image = createTestImage(5, 3);
+  Image rotated = image;
+  for (int rotation : {0, 90, 180, 270}) {
+    for (bool isMirrored : {false, true}) {
+      SCOPED_TRACE("rotation " + std::to_string(rotation) + ", mirror " +
+                   std::to_string(isMirrored));
+      ImageTransform transform;
+      transform.rotation = rotation;
+      transform.mirror = isMirrored;
+      Image expected = isMirrored ? mirror(rotated) : rotated;
+      Image actual =
+          resample(createRGBBuffer(image), transform, expected.width, expected.height);
+      expectImagesNear(actual, expected, 0);
+    }
+    rotated = rotateClockwise(rotated);
+  }
+}
+
+TEST(ImageProcessing, CropsRegion) {
+  Image image = createTestImage(8, 6);
+  ImageTransform transform;
+  transform.cropX = 2;
+  transform.cropY = 1;
+  transform.cropWidth = 4;
+  transform.cropHeight = 3;
+
+  Image expected(4, 3);
+  for (size_t y = 0; y < 3; y++) {
+    for (size_t x = 0; x < 4; x++) {
+      std::copy_n(image.at(x + 2, y + 1), 3, expected.at(x, y));
+    }
+  }
+  expectImagesNear(resample(createRGBBuffer(image), transform, 4, 3), expected, 0);
+}
+
+TEST(ImageProcessing, ResizesBilinear) {
+  Image image = createTestImage(16, 12);
+  for (auto size : {std::make_pair(7, 5), std::make_pair(16, 3), std::make_pair(24, 20)}) {
+    SCOPED_TRACE(std::to_string(size.first) + "x" + std::to_string(size.second));
+    Image actual = resample(createRGBBuffer(image), ImageTransform(), size.first, size.second);
+    // The kernel uses 8-bit fixed point weights
+    expectImagesNear(actual, resampleReference(image, size.first, size.second), 1);
+  }
+}
+
+TEST(ImageProcessing, ReadsRGBAAndBGRA) {
+  Image image = createTestImage(3, 2);
+  std::vector<uint8_t> rgba, bgra;
+  for (size_t i = 0; i < image.pixels.size(); i += 3) {
+    const uint8_t* pixel = image.pixels.data() + i;
+    rgba.insert(rgba.end(), {pixel[0], pixel[1], pixel[2], 255});
+    bgra.insert(bgra.end(), {pixel[2], pixel[1], pixel[0], 255});
+  }
+  for (auto [format, data] : {std::make_pair(PixelFormat::RGBA, &rgba),
+                              std::make_pair(PixelFormat::BGRA, &bgra)}) {
+    ImageBuffer buffer = ImageProcessing::createImageBuffer(data->data(), data->size(), format,
+                                                            image.width, image.height);
+    expectImagesNear(resample(buffer, ImageTransform(), 3, 2), image, 0);
+  }
+}
+
+TEST(ImageProcessing, SkipsRowPadding) {
+  Image image = createTestImage(3, 4);
+  constexpr size_t bytesPerRow = 16;
+  std::vector<uint8_t> padded(bytesPerRow * image.height, 0xEE);
+  for (size_t y = 0; y < image.height; y++) {
+    std::copy_n(image.at(0, y), image.width * 3, padded.data() + y * bytesPerRow);
+  }
+  ImageBuffer buffer = ImageProcessing::createImageBuffer(
+      padded.data(), padded.size(), PixelFormat::RGB, image.width, image.height, bytesPerRow);
+  expectImagesNear(resample(buffer, ImageTransform(), 3, 4), image, 0);
+}
+
+TEST(ImageProcessing, ConvertsYUVColors) {
+  const Color colors[] = {{255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 200, 30}, {90, 40, 160}};
+  for (PixelFormat format : kYUVFormats) {
+    for (const Color& color : colors) {
+      SCOPED_TRACE("format " + std::to_string(static_cast<int>(format)) + ", color " +
+                   std::to_string(color[0]) + " " + std::to_string(color[1]) + " " +
+                   std::to_string(color[2]));
+      Color yuv = convertRGBToYUV(color);
+      // Odd sizes have a chroma column and row that only cover one pixel
+      auto data = createYUVImage(format, 5, 3, [&](size_t, size_t) { return yuv; });
+
+      Image expected(5, 3);
+      for (size_t i = 0; i < expected.pixels.size(); i++) {
+        expected.pixels[i] = color[i % 3];
+      }
+      // Y, U and V are rounded to bytes
+      expectImagesNear(resampleYUV(format, data, 5, 3), expected, 2);
+    }
+  }
+}
+
+TEST(ImageProcessing, KeepsFullResolutionLuma) {
+  for (PixelFormat format : kYUVFormats) {
+    SCOPED_TRACE("format " + std::to_string(static_cast<int>(format)));
+    auto getLuma = [](size_t x, size_t y) { return static_cast<uint8_t>(x * 30 + y * 7); };
+    auto data = createYUVImage(format, 8, 6, [&](size_t x, size_t y) {
+      return Color{getLuma(x, y), 128, 128};
+    });
+
+    Image expected(8, 6);
+    for (size_t y = 0; y < 6; y++) {
+      for (size_t x = 0; x < 8; x++) {
+        std::fill_n(expected.at(x, y), 3, getLuma(x, y));
+      }
+    }
+    expectImagesNear(resampleYUV(format, data, 8, 6), expected, 0);
+  }
+}
+
+TEST(ImageProcessing, RejectsInvalidImages) {
+  std::vector<uint8_t> data(4 * 4 * 3);
+  EXPECT_THROW(ImageProcessing::createImageBuffer(data.data(), data.size(), PixelFormat::RGBA, 4,
+                                                  4),
+               std::runtime_error);
+  EXPECT_THROW(ImageProcessing::createImageBuffer(data.data(), 4 * 4, PixelFormat::NV12, 4, 4),
+               std::runtime_error);
+  EXPECT_THROW(ImageProcessing::createImageBuffer(nullptr, 0, PixelFormat::RGB, 4, 4),
+               std::runtime_error);
+
+  ImageBuffer buffer =
+      ImageProcessing::createImageBuffer(data.data(), data.size(), PixelFormat::RGB, 4, 4);
+  auto onRow = [](size_t, const uint8_t*) {};
+  ImageTransform rotated;
+  rotated.rotation = 45;
+  EXPECT_THROW(ImageProcessing::resample(buffer, rotated, 4, 4, onRow), std::runtime_error);
+  ImageTransform cropped;
+  cropped.cropX = 2;
+  cropped.cropWidth = 3;
+  EXPECT_THROW(ImageProcessing::resample(buffer, cropped, 4, 4, onRow), std::runtime_error);
+}
+
+} // namespace
@@ -0,0 +1,126 @@
+//
+//  InferenceStatsTest.cpp
+//  react-native-fast-tflite
+//
+
+#include "InferenceStats.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Every bucket is at most 1/16 of its lower bound wide.
+constexpr double kRelativeError = 1.0 / 16;
+
+TEST(LatencyHistogram, EmptySummaryIsZero) {
+  LatencyHistogram histogram;
+  LatencyHistogram::Summary summary = histogram.getSummary();
+  EXPECT_EQ(summary.count, 0u);
+  EXPECT_EQ(summary.mean, 0);
+  EXPECT_EQ(summary.p50, 0);
+  EXPECT_EQ(summary.max, 0);
+}
+
+TEST(LatencyHistogram, SmallValuesAreExact) {
+  LatencyHistogram histogram;
+  for (uint64_t microseconds = 1; microseconds <= 10; microseconds++) {
+    histogram.record(microseconds);
+  }
+  LatencyHistogram::Summary summary = histogram.getSummary();
+  EXPECT_EQ(summary.count, 10u);
+  EXPECT_DOUBLE_EQ(summary.mean, 0.0055);
+  EXPECT_DOUBLE_EQ(summary.p50, 0.005);
+  EXPECT_DOUBLE_EQ(summary.p95, 0.010);
+  EXPECT_DOUBLE_EQ(summary.max, 0.010);
+}
+
+TEST(LatencyHistogram, PercentilesAreWithinBucketWidth) {
+  LatencyHistogram histogram;
+  for (uint64_t microseconds = 1; microseconds <= 10000; microseconds++) {
+    histogram.record(microseconds);
+  }
+  LatencyHistogram::Summary summary = histogram.getSummary();
+  EXPECT_EQ(summary.count, 10000u);
+  EXPECT_DOUBLE_EQ(summary.mean, 5.0005);
+  EXPECT_NEAR(summary.p50, 5.0, 5.0 * kRelativeError);
+  EXPECT_NEAR(summary.p95, 9.5, 9.5 * kRelativeError);
+  EXPECT_NEAR(summary.p99, 9.9, 9.9 * kRelativeError);
+  EXPECT_DOUBLE_EQ(summary.max, 10.0);
+  // No percentile is reported above the largest value
+  EXPECT_LE(summary.p99, summary.max);
+}
+
+TEST(LatencyHistogram, KeepsMaxOfHugeValues) {
+  LatencyHistogram histogram;
+  constexpr uint64_t huge = uint64_t(1) << 40;
+  histogram.record(huge);
+  LatencyHistogram::Summary summary = histogram.getSummary();
+  EXPECT_DOUBLE_EQ(summary.max, static_cast<double>(huge) / 1000);
+  EXPECT_LE(summary.p50, summary.max);
+}
+
+TEST(LatencyHistogram, CountsConcurrentRecords) {
+  constexpr size_t threadCount = 4;
+  constexpr size_t recordsPerThread = 10000;
+  LatencyHistogram histogram;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < threadCount; i++) {
+    threads.emplace_back([&histogram, i]() {
+      for (size_t record = 0; record < recordsPerThread; record++) {
+        histogram.record(100 * (i + 1));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  LatencyHistogram::Summary summary = histogram.getSummary();
+  EXPECT_EQ(summary.count, threadCount * recordsPerThread);
+  EXPECT_DOUBLE_EQ(summary.mean, 0.25);
+  EXPECT_DOUBLE_EQ(summary.max, 0.4);
+}
+
+TEST(LatencyHistogram, ResetClearsAllValues) {
+  LatencyHistogram histogram;
+  histogram.record(1000);
+  histogram.reset();
+  EXPECT_EQ(histogram.getSummary().count, 0u);
+  histogram.record(5);
+  EXPECT_DOUBLE_EQ(histogram.getSummary().max, 0.005);
+}
+
+TEST(InferenceStats, RecordsEachPhaseOnItsOwn) {
+  InferenceStats stats;
+  stats.record(InferenceStats::Phase::Invoke, std::chrono::milliseconds(2));
+  // Negative durations (e.g. from a start time in the future) count as zero
+  stats.record(InferenceStats::Phase::Input, std::chrono::milliseconds(-1));
+  EXPECT_EQ(stats.get(InferenceStats::Phase::Invoke).getSummary().count, 1u);
+  EXPECT_DOUBLE_EQ(stats.get(InferenceStats::Phase::Invoke).getSummary().max, 2.0);
+  EXPECT_DOUBLE_EQ(stats.get(InferenceStats::Phase::Input).getSummary().max, 0.0);
+  EXPECT_EQ(stats.get(InferenceStats::Phase::Output).getSummary().count, 0u);
+
+  stats.reset();
+  EXPECT_EQ(stats.get(InferenceStats::Phase::Invoke).getSummary().count, 0u);
+}
+
+TEST(InferenceStats, TimerRecordsOnDestruction) {
+  InferenceStats stats;
+  {
+    InferenceStats::Timer timer(stats, InferenceStats::Phase::Output);
+    EXPECT_EQ(stats.get(InferenceStats::Phase::Output).getSummary().count, 0u);
+  }
+  EXPECT_EQ(stats.get(InferenceStats::Phase::Output).getSummary().count, 1u);
+}
+
+TEST(InferenceStats, NamesEveryPhase) {
+  for (size_t i = 0; i < InferenceStats::kPhaseCount; i++) {
+    EXPECT_NE(std::string(InferenceStats::getPhaseName(static_cast<InferenceStats::Phase>(i))),
+              "unknown");
+  }
+}
+
+} // namespace
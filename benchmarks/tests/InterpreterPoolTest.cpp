@@ -0,0 +1,144 @@
+//
+//  InterpreterPoolTest.cpp
+//  react-native-fast-tflite
+//
+//  The pool only hands out the Interpreters, so these tests use placeholder pointers that are
+//  never passed to TFLite.
+//
+
+#include "InterpreterPool.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::vector<std::shared_ptr<TfLiteInterpreter>> createPlaceholders(size_t count) {
+  std::vector<std::shared_ptr<TfLiteInterpreter>> interpreters;
+  for (size_t i = 0; i < count; i++) {
+    auto* pointer = reinterpret_cast<TfLiteInterpreter*>(static_cast<uintptr_t>(0x1000 + i));
+    interpreters.emplace_back(pointer, [](TfLiteInterpreter*) {});
+  }
+  return interpreters;
+}
+
+TEST(InterpreterPool, AsyncRunsUsePrimaryInterpreterLast) {
+  InterpreterPool pool(createPlaceholders(3));
+  auto first = pool.acquire();
+  auto second = pool.acquire();
+  EXPECT_EQ(first.index(), 2u);
+  EXPECT_EQ(second.index(), 1u);
+  EXPECT_EQ(first.get(), pool.at(2).get());
+
+  auto third = pool.acquire();
+  EXPECT_EQ(third.index(), 0u);
+}
+
+TEST(InterpreterPool, ReleasesInterpreterWithLease) {
+  InterpreterPool pool(createPlaceholders(2));
+  {
+    auto lease = pool.acquire();
+    EXPECT_EQ(lease.index(), 1u);
+  }
+  auto moved = pool.acquire();
+  EXPECT_EQ(moved.index(), 1u);
+  auto lease = std::move(moved);
+  // Only the moved-to lease releases the Interpreter
+  EXPECT_EQ(pool.acquire().index(), 0u);
+  EXPECT_EQ(lease.index(), 1u);
+}
+
+TEST(InterpreterPool, AcquireWaitsForFreeInterpreter) {
+  InterpreterPool pool(createPlaceholders(1));
+  auto lease = std::make_unique<InterpreterPool::Lease>(pool.acquire(0));
+
+  std::atomic<bool> acquired{false};
+  std::thread waiting([&]() {
+    auto other = pool.acquire();
+    acquired = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(acquired);
+
+  lease = nullptr;
+  waiting.join();
+  EXPECT_TRUE(acquired);
+}
+
+TEST(InterpreterPool, AcquireByIndexWaitsForThatInterpreter) {
+  InterpreterPool pool(createPlaceholders(2));
+  auto primary = std::make_unique<InterpreterPool::Lease>(pool.acquire(0));
+
+  std::atomic<bool> acquired{false};
+  std::thread waiting([&]() {
+    auto other = pool.acquire(0);
+    acquired = true;
+  });
+  // Another free Interpreter doesn't help `acquire(0)`
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(acquired);
+
+  primary = nullptr;
+  waiting.join();
+  EXPECT_TRUE(acquired);
+}
+
+TEST(InterpreterPool, AsyncRunsSkipReservedPrimaryInterpreter) {
+  InterpreterPool pool(createPlaceholders(2));
+  pool.reservePrimary();
+  auto lease = std::make_unique<InterpreterPool::Lease>(pool.acquire());
+  EXPECT_EQ(lease->index(), 1u);
+
+  std::atomic<bool> acquired{false};
+  std::thread waiting([&]() {
+    auto other = pool.acquire();
+    EXPECT_EQ(other.index(), 1u);
+    acquired = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(acquired);
+  // `runSync` can still use it
+  EXPECT_EQ(pool.acquire(0).index(), 0u);
+
+  lease = nullptr;
+  waiting.join();
+  EXPECT_TRUE(acquired);
+}
+
+TEST(InterpreterPool, SingleInterpreterCanNotBeReserved) {
+  InterpreterPool pool(createPlaceholders(1));
+  pool.reservePrimary();
+  auto lease = pool.acquire();
+  EXPECT_EQ(lease.index(), 0u);
+  EXPECT_TRUE(pool.isAcquiredForAsyncRun(0));
+}
+
+TEST(InterpreterPool, TracksAsyncRuns) {
+  InterpreterPool pool(createPlaceholders(2));
+  {
+    auto sync = pool.acquire(0);
+    auto async = pool.acquire();
+    EXPECT_FALSE(pool.isAcquiredForAsyncRun(0));
+    EXPECT_TRUE(pool.isAcquiredForAsyncRun(1));
+  }
+  EXPECT_FALSE(pool.isAcquiredForAsyncRun(1));
+}
+
+TEST(InterpreterPool, CancelSkipsSyncAndFreeInterpreters) {
+  InterpreterPool pool(createPlaceholders(2));
+  // Cancelling would pass the placeholder to TFLite, so nothing may be cancelled here.
+  auto sync = pool.acquire(0);
+  pool.cancelAsyncRuns();
+  {
+    auto async = pool.acquire();
+    EXPECT_EQ(async.index(), 1u);
+  }
+  // Released async leases are not cancelled anymore
+  pool.cancelAsyncRuns();
+}
+
+} // namespace
@@ -0,0 +1,123 @@
+//
+//  LoaderPoolTest.cpp
+//  react-native-fast-tflite
+//
+
+#include "LoaderPool.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Keeps a loader Thread busy until `release()` is called.
+class BlockingLoad {
+public:
+  LoaderPool::Job job() {
+    return [this](const LoaderPool::CancellationFlag& isCancelled) {
+      _isCancelled = isCancelled;
+      _started.set_value();
+      _released.wait();
+    };
+  }
+
+  void waitUntilStarted() { _started.get_future().wait(); }
+  void release() { _releasePromise.set_value(); }
+  bool isCancelled() const { return _isCancelled->load(); }
+
+private:
+  std::promise<void> _started;
+  std::promise<void> _releasePromise;
+  std::shared_future<void> _released = _releasePromise.get_future().share();
+  LoaderPool::CancellationFlag _isCancelled;
+};
+
+TEST(LoaderPool, StartsPendingLoadsByPriority) {
+  LoaderPool pool("Test Loader", 1);
+  BlockingLoad blocking;
+  pool.enqueue(0, 0, blocking.job(), []() {});
+  blocking.waitUntilStarted();
+
+  std::mutex mutex;
+  std::vector<uint64_t> order;
+  std::promise<void> done;
+  auto record = [&](uint64_t id) {
+    return [&, id](const LoaderPool::CancellationFlag&) {
+      std::unique_lock<std::mutex> lock(mutex);
+      order.push_back(id);
+      if (order.size() == 4) {
+        done.set_value();
+      }
+    };
+  };
+  pool.enqueue(1, 0, record(1), []() {});
+  pool.enqueue(2, 5, record(2), []() {});
+  pool.enqueue(3, 0, record(3), []() {});
+  pool.enqueue(4, -1, record(4), []() {});
+
+  blocking.release();
+  done.get_future().wait();
+  EXPECT_EQ(order, (std::vector<uint64_t>{2, 1, 3, 4}));
+}
+
+TEST(LoaderPool, CancelsPendingLoad) {
+  LoaderPool pool("Test Loader", 1);
+  BlockingLoad blocking;
+  pool.enqueue(0, 0, blocking.job(), []() {});
+  blocking.waitUntilStarted();
+
+  std::atomic<bool> didRun{false};
+  bool wasCancelled = false;
+  pool.enqueue(
+      1, 0, [&](const LoaderPool::CancellationFlag&) { didRun = true; },
+      [&]() { wasCancelled = true; });
+  EXPECT_TRUE(pool.cancel(1));
+  EXPECT_TRUE(wasCancelled);
+  // It is not pending anymore
+  EXPECT_FALSE(pool.cancel(1));
+
+  blocking.release();
+  std::promise<void> done;
+  pool.enqueue(2, 0, [&](const LoaderPool::CancellationFlag&) { done.set_value(); }, []() {});
+  done.get_future().wait();
+  EXPECT_FALSE(didRun);
+}
+
+TEST(LoaderPool, FlagsRunningLoadAsCancelled) {
+  LoaderPool pool("Test Loader", 1);
+  BlockingLoad blocking;
+  bool wasCancelled = false;
+  pool.enqueue(0, 0, blocking.job(), [&]() { wasCancelled = true; });
+  blocking.waitUntilStarted();
+
+  EXPECT_FALSE(blocking.isCancelled());
+  EXPECT_TRUE(pool.cancel(0));
+  EXPECT_TRUE(blocking.isCancelled());
+  // The running load has to stop on its own
+  EXPECT_FALSE(wasCancelled);
+  blocking.release();
+}
+
+TEST(LoaderPool, CancelReturnsFalseForUnknownLoad) {
+  LoaderPool pool("Test Loader", 1);
+  EXPECT_FALSE(pool.cancel(42));
+}
+
+TEST(LoaderPool, RaisingConcurrencyStartsPendingLoads) {
+  LoaderPool pool("Test Loader", 1);
+  BlockingLoad first;
+  BlockingLoad second;
+  pool.enqueue(0, 0, first.job(), []() {});
+  first.waitUntilStarted();
+  pool.enqueue(1, 0, second.job(), []() {});
+
+  pool.setMaxConcurrency(2);
+  // Both loads run at the same time now
+  second.waitUntilStarted();
+  first.release();
+  second.release();
+}
+
+} // namespace
@@ -0,0 +1,122 @@
+//
+//  ModelRegistryTest.cpp
+//  react-native-fast-tflite
+//
+//  The registry only caches the Models, so these tests use placeholder pointers that are never
+//  passed to TFLite.
+//
+
+#include "ModelRegistry.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+std::shared_ptr<TfLiteModel> createPlaceholder() {
+  auto* pointer = reinterpret_cast<TfLiteModel*>(static_cast<uintptr_t>(0x1000));
+  return std::shared_ptr<TfLiteModel>(pointer, [](TfLiteModel*) {});
+}
+
+TEST(ModelRegistry, ReusesLoadedModel) {
+  ModelRegistry registry;
+  int loads = 0;
+  auto load = [&]() {
+    loads++;
+    return createPlaceholder();
+  };
+
+  auto model = registry.getOrLoad("model", load);
+  EXPECT_EQ(registry.getOrLoad("model", load), model);
+  EXPECT_EQ(loads, 1);
+  // Other keys are loaded on their own
+  registry.getOrLoad("other", load);
+  EXPECT_EQ(loads, 2);
+}
+
+TEST(ModelRegistry, LoadsAgainOnceModelWasReleased) {
+  ModelRegistry registry;
+  int loads = 0;
+  auto load = [&]() {
+    loads++;
+    return createPlaceholder();
+  };
+
+  registry.getOrLoad("model", load);
+  // Nobody holds on to the first Model, so it is freed right away.
+  registry.getOrLoad("model", load);
+  EXPECT_EQ(loads, 2);
+}
+
+TEST(ModelRegistry, ConcurrentCallersShareOneLoad) {
+  ModelRegistry registry;
+  std::promise<void> started;
+  std::promise<void> finish;
+  std::atomic<int> loads{0};
+  auto load = [&]() {
+    loads++;
+    started.set_value();
+    finish.get_future().wait();
+    return createPlaceholder();
+  };
+
+  auto first = std::async(std::launch::async, [&]() { return registry.getOrLoad("model", load); });
+  started.get_future().wait();
+  auto second =
+      std::async(std::launch::async, [&]() { return registry.getOrLoad("model", load); });
+  finish.set_value();
+
+  auto model = first.get();
+  EXPECT_EQ(second.get(), model);
+  EXPECT_EQ(loads, 1);
+}
+
+TEST(ModelRegistry, RethrowsLoadErrorAndRetriesNextTime) {
+  ModelRegistry registry;
+  auto failingLoad = []() -> std::shared_ptr<TfLiteModel> {
+    throw std::runtime_error("failed");
+  };
+  EXPECT_THROW(registry.getOrLoad("model", failingLoad), std::runtime_error);
+
+  auto model = createPlaceholder();
+  EXPECT_EQ(registry.getOrLoad("model", [&]() { return model; }), model);
+}
+
+TEST(ModelRegistry, KeysRemoteURLsByURL) {
+  EXPECT_EQ(ModelRegistry::getKey("https://example.com/model.tflite"),
+            "https://example.com/model.tflite");
+  EXPECT_EQ(ModelRegistry::getKey("model_resource"), "model_resource");
+  // Files that don't exist can't be keyed by their contents
+  EXPECT_EQ(ModelRegistry::getKey("file:///does/not/exist.tflite"),
+            "file:///does/not/exist.tflite");
+}
+
+TEST(ModelRegistry, KeysLocalFilesByTheirSize) {
+  std::string path =
+      testing::TempDir() + "model-registry-" + std::to_string(getpid()) + ".tflite";
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  std::fputs("model", file);
+  std::fclose(file);
+
+  std::string url = "file://" + path;
+  std::string key = ModelRegistry::getKey(url);
+  EXPECT_EQ(key.rfind(url + "@", 0), 0u);
+  EXPECT_EQ(ModelRegistry::getKey(path).rfind(path + "@", 0), 0u);
+
+  // A changed file gets a new key
+  file = std::fopen(path.c_str(), "ab");
+  ASSERT_NE(file, nullptr);
+  std::fputs(" changed", file);
+  std::fclose(file);
+  EXPECT_NE(ModelRegistry::getKey(url), key);
+  std::remove(path.c_str());
+}
+
+} // namespace
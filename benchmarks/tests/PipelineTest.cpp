@@ -0,0 +1,111 @@
+//
+//  PipelineTest.cpp
+//  react-native-fast-tflite
+//
+//  Runs the stages the same way `TensorflowPlugin::runAsync` does, with placeholder Interpreters
+//  that are never passed to TFLite.
+//
+
+#include "Pipeline.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+std::vector<std::shared_ptr<TfLiteInterpreter>> createPlaceholders(size_t count) {
+  std::vector<std::shared_ptr<TfLiteInterpreter>> interpreters;
+  for (size_t i = 0; i < count; i++) {
+    auto* pointer = reinterpret_cast<TfLiteInterpreter*>(static_cast<uintptr_t>(0x1000 + i));
+    interpreters.emplace_back(pointer, [](TfLiteInterpreter*) {});
+  }
+  return interpreters;
+}
+
+// Everything the runs use, shared so a deadlocked run can't outlive it.
+struct PipelineRuns {
+  explicit PipelineRuns(size_t poolSize) : pool(createPlaceholders(poolSize)) {}
+
+  InterpreterPool pool;
+  Pipeline pipeline;
+  std::mutex mutex;
+  std::vector<uint64_t> invokeOrder;
+  std::vector<uint64_t> resultOrder;
+};
+
+void runPipelined(const std::shared_ptr<PipelineRuns>& runs, uint64_t sequence) {
+  {
+    auto interpreter = runs->pipeline.acquire(sequence, runs->pool);
+    EXPECT_NE(interpreter.index(), 0u);
+    runs->pipeline.invoke(sequence, [&]() {
+      std::unique_lock<std::mutex> lock(runs->mutex);
+      runs->invokeOrder.push_back(sequence);
+    });
+  }
+  runs->pipeline.finish(sequence, [&]() {
+    std::unique_lock<std::mutex> lock(runs->mutex);
+    runs->resultOrder.push_back(sequence);
+  });
+}
+
+TEST(Pipeline, RunsWithReservedPrimaryInterpreterDontDeadlock) {
+  constexpr size_t pipelineDepth = 3;
+  constexpr uint64_t runCount = 12;
+  auto runs = std::make_shared<PipelineRuns>(pipelineDepth);
+  // Like after `getInputBuffer(..)`, only `pipelineDepth - 1` Interpreters are left for the runs.
+  runs->pool.reservePrimary();
+
+  // Later runs reach their worker first, so they would take all free Interpreters and wait for
+  // the earlier runs to invoke.
+  std::vector<std::thread> threads;
+  std::vector<std::future<void>> finished;
+  for (uint64_t sequence = runCount; sequence-- > 0;) {
+    std::packaged_task<void()> run([runs, sequence]() { runPipelined(runs, sequence); });
+    finished.push_back(run.get_future());
+    threads.emplace_back(std::move(run));
+    std::this_thread::sleep_for(1ms);
+  }
+  auto deadline = std::chrono::steady_clock::now() + 5s;
+  for (auto& future : finished) {
+    if (future.wait_until(deadline) != std::future_status::ready) {
+      // The stuck Threads only use `runs`, which they keep alive.
+      for (auto& thread : threads) {
+        thread.detach();
+      }
+      FAIL() << "The pipelined runs deadlocked.";
+    }
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::vector<uint64_t> expected;
+  for (uint64_t sequence = 0; sequence < runCount; sequence++) {
+    expected.push_back(sequence);
+  }
+  EXPECT_EQ(runs->invokeOrder, expected);
+  EXPECT_EQ(runs->resultOrder, expected);
+}
+
+TEST(Pipeline, SkippedRunsPassAllStages) {
+  auto runs = std::make_shared<PipelineRuns>(2);
+  runs->pool.reservePrimary();
+  // Like a run that got a sequence number but could not be enqueued
+  runs->pipeline.skip(1);
+  runPipelined(runs, 0);
+  runPipelined(runs, 2);
+  runs->pipeline.skip(3);
+  runPipelined(runs, 4);
+
+  EXPECT_EQ(runs->invokeOrder, (std::vector<uint64_t>{0, 2, 4}));
+  EXPECT_EQ(runs->resultOrder, (std::vector<uint64_t>{0, 2, 4}));
+}
+
+} // namespace
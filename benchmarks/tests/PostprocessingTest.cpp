@@ -0,0 +1,176 @@
+//
+//  PostprocessingTest.cpp
+//  react-native-fast-tflite
+//
+//  Compares the top-K kernels against a plain sort and softmax reference.
+//
+
+#include "HostTensor.h"
+#include "Postprocessing.h"
+#include "TensorHelpers.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Pairs = std::vector<std::pair<size_t, float>>;
+
+Pairs toPairs(const float* output, size_t count) {
+  Pairs pairs;
+  for (size_t i = 0; i < count; i++) {
+    pairs.emplace_back(static_cast<size_t>(output[i * 2]), output[i * 2 + 1]);
+  }
+  return pairs;
+}
+
+Pairs topK(const std::vector<float>& scores, size_t k, bool softmax = false) {
+  std::vector<float> output(2 * std::min(k, scores.size()));
+  size_t count = Postprocessing::topK(scores.data(), scores.size(), k, softmax, output.data());
+  return toPairs(output.data(), count);
+}
+
+// All scores as `(index, score)` pairs sorted by descending score, lower indices first on ties.
+Pairs sortReference(const std::vector<float>& scores) {
+  std::vector<size_t> indices(scores.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  std::stable_sort(indices.begin(), indices.end(),
+                   [&](size_t left, size_t right) { return scores[left] > scores[right]; });
+  Pairs pairs;
+  for (size_t index : indices) {
+    pairs.emplace_back(index, scores[index]);
+  }
+  return pairs;
+}
+
+std::vector<float> softmaxReference(const std::vector<float>& scores) {
+  double maximum = *std::max_element(scores.begin(), scores.end());
+  double sum = 0;
+  for (float score : scores) {
+    sum += std::exp(score - maximum);
+  }
+  std::vector<float> probabilities;
+  for (float score : scores) {
+    probabilities.push_back(static_cast<float>(std::exp(score - maximum) / sum));
+  }
+  return probabilities;
+}
+
+template <typename Q>
+void expectQuantizedSoftmaxMatchesReference(const std::vector<Q>& values, float scale,
+                                            int32_t zeroPoint) {
+  std::vector<float> real;
+  for (Q value : values) {
+    real.push_back(static_cast<float>(static_cast<int32_t>(value) - zeroPoint) * scale);
+  }
+  Pairs expected = sortReference(softmaxReference(real));
+  constexpr size_t k = 5;
+  std::vector<float> output(2 * k);
+  ASSERT_EQ(
+      Postprocessing::topK(values.data(), values.size(), k, true, scale, zeroPoint, output.data()),
+      k);
+  Pairs actual = toPairs(output.data(), k);
+  for (size_t i = 0; i < k; i++) {
+    EXPECT_EQ(actual[i].first, expected[i].first) << "at " << i;
+    EXPECT_NEAR(actual[i].second, expected[i].second, 1e-5f) << "at " << i;
+  }
+}
+
+TEST(Postprocessing, SortsByDescendingScore) {
+  std::vector<float> scores = {0.1f, 2.5f, -1.0f, 0.7f, 3.0f, 0.0f};
+  EXPECT_EQ(topK(scores, 3), (Pairs{{4, 3.0f}, {1, 2.5f}, {3, 0.7f}}));
+  // k = 1 is an argmax
+  EXPECT_EQ(topK(scores, 1), (Pairs{{4, 3.0f}}));
+}
+
+TEST(Postprocessing, BreaksTiesByLowerIndex) {
+  std::vector<float> scores = {1.0f, 2.0f, 1.0f, 2.0f, 1.0f};
+  EXPECT_EQ(topK(scores, 3), (Pairs{{1, 2.0f}, {3, 2.0f}, {0, 1.0f}}));
+
+  std::vector<int8_t> quantized = {5, 5, 5, 5};
+  std::vector<float> output(4);
+  ASSERT_EQ(Postprocessing::topK(quantized.data(), quantized.size(), 2, false, 1.0f, 0,
+                                 output.data()),
+            2u);
+  EXPECT_EQ(toPairs(output.data(), 2), (Pairs{{0, 5.0f}, {1, 5.0f}}));
+}
+
+TEST(Postprocessing, ReturnsAllScoresIfKExceedsClassCount) {
+  std::vector<float> scores = {0.2f, 0.9f, 0.5f};
+  EXPECT_EQ(topK(scores, 10), sortReference(scores));
+  EXPECT_TRUE(topK({}, 3).empty());
+}
+
+TEST(Postprocessing, MatchesSortedReference) {
+  std::vector<float> scores;
+  for (size_t i = 0; i < 1001; i++) {
+    scores.push_back(static_cast<float>((i * 7919) % 1009) * 0.01f - 5.0f);
+  }
+  Pairs expected = sortReference(scores);
+  expected.resize(10);
+  EXPECT_EQ(topK(scores, 10), expected);
+}
+
+TEST(Postprocessing, SoftmaxMatchesReference) {
+  std::vector<float> scores = {1.0f, -2.0f, 4.5f, 0.3f, 4.4f, -7.0f, 2.2f};
+  Pairs expected = sortReference(softmaxReference(scores));
+  Pairs actual = topK(scores, scores.size(), true);
+  ASSERT_EQ(actual.size(), expected.size());
+  float sum = 0;
+  for (size_t i = 0; i < actual.size(); i++) {
+    EXPECT_EQ(actual[i].first, expected[i].first) << "at " << i;
+    EXPECT_NEAR(actual[i].second, expected[i].second, 1e-6f) << "at " << i;
+    sum += actual[i].second;
+  }
+  EXPECT_NEAR(sum, 1.0f, 1e-5f);
+}
+
+TEST(Postprocessing, QuantizedSoftmaxMatchesReference) {
+  // More classes than 8-bit values, so the histogram bins hold multiple scores
+  std::vector<int8_t> signedValues;
+  std::vector<uint8_t> unsignedValues;
+  for (size_t i = 0; i < 1001; i++) {
+    signedValues.push_back(static_cast<int8_t>((i * 37) % 256 - 128));
+    unsignedValues.push_back(static_cast<uint8_t>((i * 53) % 256));
+  }
+  {
+    SCOPED_TRACE("int8");
+    expectQuantizedSoftmaxMatchesReference(signedValues, 0.0625f, -10);
+  }
+  {
+    SCOPED_TRACE("uint8");
+    expectQuantizedSoftmaxMatchesReference(unsignedValues, 0.03f, 128);
+  }
+}
+
+TEST(Postprocessing, PostprocessesEveryRowOfBatchedTensors) {
+  constexpr size_t rows = 3;
+  constexpr size_t classes = 4;
+  HostTensor tensor(kTfLiteFloat32, std::vector<int>{rows, classes});
+  const float values[rows][classes] = {
+      {0.1f, 0.9f, 0.3f, 0.2f}, {0.8f, 0.1f, 0.1f, 0.7f}, {0.0f, 0.2f, 0.6f, 0.4f}};
+  for (size_t row = 0; row < rows; row++) {
+    std::copy_n(values[row], classes, tensor.data<float>() + row * classes);
+  }
+
+  OutputPostprocessing postprocessing;
+  postprocessing.topK = 2;
+  auto buffer = TensorHelpers::postprocessTensorData(tensor.get(), 0, rows * classes,
+                                                     postprocessing);
+  ASSERT_EQ(buffer->size(), rows * 2 * 2 * sizeof(float));
+  Pairs actual = toPairs(reinterpret_cast<const float*>(buffer->data()), rows * 2);
+  EXPECT_EQ(actual, (Pairs{{1, 0.9f}, {2, 0.3f}, {0, 0.8f}, {3, 0.7f}, {2, 0.6f}, {3, 0.4f}}));
+
+  // A single sample of the batch only returns its own row
+  buffer = TensorHelpers::postprocessTensorData(tensor.get(), classes, classes, postprocessing);
+  ASSERT_EQ(buffer->size(), 2 * 2 * sizeof(float));
+  actual = toPairs(reinterpret_cast<const float*>(buffer->data()), 2);
+  EXPECT_EQ(actual, (Pairs{{0, 0.8f}, {3, 0.7f}}));
+}
+
+} // namespace
@@ -0,0 +1,144 @@
+//
+//  PreprocessingTest.cpp
+//  react-native-fast-tflite
+//
+//  Compares the (partly vectorized) kernels against a plain per-value reference for every layout,
+//  with pixel counts that leave a scalar tail after the SIMD blocks.
+//
+
+#include "Preprocessing.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+constexpr size_t kPixelCounts[] = {1, 16, 117};
+
+std::vector<uint8_t> createPixels(size_t pixelCount, size_t channels) {
+  std::vector<uint8_t> pixels(pixelCount * channels);
+  for (size_t i = 0; i < pixels.size(); i++) {
+    pixels[i] = static_cast<uint8_t>((i * 37 + 11) % 256);
+  }
+  return pixels;
+}
+
+template <typename T> T referenceValue(float value) {
+  if constexpr (std::is_same_v<T, float>) {
+    return value;
+  } else {
+    long rounded = std::lrintf(value);
+    return static_cast<T>(std::clamp<long>(rounded, std::numeric_limits<T>::min(),
+                                           std::numeric_limits<T>::max()));
+  }
+}
+
+template <typename T>
+std::vector<T> transformReference(const std::vector<uint8_t>& pixels, size_t pixelCount,
+                                  const PixelTransform& transform) {
+  size_t channels = transform.channels;
+  std::vector<T> output(pixelCount * channels);
+  for (size_t pixel = 0; pixel < pixelCount; pixel++) {
+    for (size_t channel = 0; channel < channels; channel++) {
+      size_t source = transform.swapRedBlue && channel < 3 ? 2 - channel : channel;
+      float value = pixels[pixel * channels + source] * transform.scale[channel] +
+                    transform.bias[channel];
+      size_t target = transform.toNCHW ? channel * pixelCount + pixel : pixel * channels + channel;
+      output[target] = referenceValue<T>(value);
+    }
+  }
+  return output;
+}
+
+template <typename T>
+void expectMatchesReference(const InputPreprocessing& preprocessing, size_t channels,
+                            float quantizationScale = 1.0f, int32_t zeroPoint = 0) {
+  PixelTransform transform =
+      Preprocessing::createTransform(preprocessing, channels, quantizationScale, zeroPoint);
+  for (size_t pixelCount : kPixelCounts) {
+    SCOPED_TRACE(std::to_string(channels) + " channels, " + std::to_string(pixelCount) +
+                 " pixels, swapRedBlue " + std::to_string(preprocessing.swapRedBlue) +
+                 ", toNCHW " + std::to_string(preprocessing.toNCHW));
+    std::vector<uint8_t> pixels = createPixels(pixelCount, channels);
+    std::vector<T> expected = transformReference<T>(pixels, pixelCount, transform);
+    std::vector<T> output(expected.size());
+    Preprocessing::transformPixels(pixels.data(), output.data(), pixelCount, transform);
+    for (size_t i = 0; i < output.size(); i++) {
+      if constexpr (std::is_same_v<T, float>) {
+        ASSERT_FLOAT_EQ(output[i], expected[i]) << "at " << i;
+      } else {
+        // A fused multiply-add in either path can round a value that is right between two
+        // integers differently.
+        ASSERT_LE(std::abs(output[i] - expected[i]), 1) << "at " << i;
+      }
+    }
+  }
+}
+
+template <typename T>
+void expectAllLayoutsMatchReference(float quantizationScale, int32_t zeroPoint) {
+  for (size_t channels : {1, 2, 3, 4}) {
+    for (bool swapRedBlue : {false, true}) {
+      for (bool toNCHW : {false, true}) {
+        if (swapRedBlue && channels < 3) {
+          continue;
+        }
+        InputPreprocessing preprocessing;
+        preprocessing.mean = {127.5f};
+        preprocessing.std = {58.0f};
+        preprocessing.swapRedBlue = swapRedBlue;
+        preprocessing.toNCHW = toNCHW;
+        expectMatchesReference<T>(preprocessing, channels, quantizationScale, zeroPoint);
+      }
+    }
+  }
+}
+
+TEST(Preprocessing, FloatOutputsMatchReference) {
+  expectAllLayoutsMatchReference<float>(1.0f, 0);
+}
+
+TEST(Preprocessing, Int8OutputsMatchReference) {
+  // Some values are out of range, so saturation is covered as well.
+  expectAllLayoutsMatchReference<int8_t>(0.015f, -3);
+}
+
+TEST(Preprocessing, Uint8OutputsMatchReference) {
+  expectAllLayoutsMatchReference<uint8_t>(0.015f, 128);
+}
+
+TEST(Preprocessing, UsesPerChannelMeanAndStd) {
+  InputPreprocessing preprocessing;
+  preprocessing.mean = {0.0f, 100.0f, 200.0f};
+  preprocessing.std = {1.0f, 2.0f, 4.0f};
+  PixelTransform transform = Preprocessing::createTransform(preprocessing, 3);
+
+  const uint8_t pixel[] = {10, 120, 240};
+  float output[3];
+  Preprocessing::transformPixels(pixel, output, 1, transform);
+  EXPECT_FLOAT_EQ(output[0], 10.0f);
+  EXPECT_FLOAT_EQ(output[1], 10.0f);
+  EXPECT_FLOAT_EQ(output[2], 10.0f);
+}
+
+TEST(Preprocessing, RejectsInvalidOptions) {
+  InputPreprocessing preprocessing;
+  preprocessing.mean = {1.0f, 2.0f};
+  EXPECT_THROW(Preprocessing::createTransform(preprocessing, 3), std::runtime_error);
+
+  preprocessing.mean = {};
+  preprocessing.std = {0.0f};
+  EXPECT_THROW(Preprocessing::createTransform(preprocessing, 3), std::runtime_error);
+
+  preprocessing.std = {};
+  preprocessing.swapRedBlue = true;
+  EXPECT_THROW(Preprocessing::createTransform(preprocessing, 1), std::runtime_error);
+}
+
+} // namespace
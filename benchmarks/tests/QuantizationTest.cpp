@@ -0,0 +1,150 @@
+//
+//  QuantizationTest.cpp
+//  react-native-fast-tflite
+//
+//  Compares the (vectorized) kernels against a plain per-value reference, with value counts that
+//  leave a scalar tail after the SIMD blocks.
+//
+
+#include "Quantization.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t kValueCounts[] = {1, 16, 37};
+
+std::vector<float> createValues(size_t count) {
+  std::vector<float> values(count);
+  for (size_t i = 0; i < count; i++) {
+    // Covers negative values, values between two steps and values that saturate.
+    values[i] = (static_cast<float>(i % 23) - 11.0f) * 0.37f;
+  }
+  return values;
+}
+
+QuantizationParams createParams(std::vector<float> scales, std::vector<int32_t> zeroPoints,
+                                size_t innerSize = 1) {
+  QuantizationParams params;
+  params.scales = std::move(scales);
+  params.zeroPoints = std::move(zeroPoints);
+  params.innerSize = innerSize;
+  return params;
+}
+
+// The channel of the value at `element`, like the TFLite per-channel layout
+size_t getChannel(const QuantizationParams& params, size_t element) {
+  return (element / params.innerSize) % params.scales.size();
+}
+
+template <typename Q>
+Q quantizeReference(float value, float scale, int32_t zeroPoint) {
+  long quantized = std::lrintf(value * (1.0f / scale)) + zeroPoint;
+  return static_cast<Q>(std::clamp<long>(quantized, std::numeric_limits<Q>::min(),
+                                         std::numeric_limits<Q>::max()));
+}
+
+template <typename Q> void expectQuantizeMatchesReference(const QuantizationParams& params) {
+  for (size_t count : kValueCounts) {
+    SCOPED_TRACE(std::to_string(count) + " values");
+    std::vector<float> values = createValues(count);
+    std::vector<Q> output(count);
+    Quantization::quantize(values.data(), output.data(), count, 0, params);
+    for (size_t i = 0; i < count; i++) {
+      size_t channel = getChannel(params, i);
+      Q expected =
+          quantizeReference<Q>(values[i], params.scales[channel], params.zeroPoints[channel]);
+      ASSERT_EQ(output[i], expected) << "at " << i;
+    }
+  }
+}
+
+template <typename Q> void expectDequantizeMatchesReference(const QuantizationParams& params) {
+  for (size_t count : kValueCounts) {
+    SCOPED_TRACE(std::to_string(count) + " values");
+    std::vector<Q> values(count);
+    for (size_t i = 0; i < count; i++) {
+      values[i] = static_cast<Q>(std::numeric_limits<Q>::min() + i * 7);
+    }
+    std::vector<float> output(count);
+    Quantization::dequantize(values.data(), output.data(), count, 0, params);
+    for (size_t i = 0; i < count; i++) {
+      size_t channel = getChannel(params, i);
+      float expected =
+          static_cast<float>(values[i] - params.zeroPoints[channel]) * params.scales[channel];
+      ASSERT_FLOAT_EQ(output[i], expected) << "at " << i;
+    }
+  }
+}
+
+TEST(Quantization, QuantizesPerTensor) {
+  expectQuantizeMatchesReference<int8_t>(createParams({0.05f}, {-3}));
+  expectQuantizeMatchesReference<uint8_t>(createParams({0.05f}, {128}));
+}
+
+TEST(Quantization, DequantizesPerTensor) {
+  expectDequantizeMatchesReference<int8_t>(createParams({0.05f}, {-3}));
+  expectDequantizeMatchesReference<uint8_t>(createParams({0.05f}, {128}));
+}
+
+TEST(Quantization, QuantizesPerChannel) {
+  // Channels of 3 (and 20) consecutive values, so spans are both shorter and longer than a block
+  for (size_t innerSize : {3, 20}) {
+    SCOPED_TRACE("innerSize " + std::to_string(innerSize));
+    auto params = createParams({0.05f, 0.1f, 0.02f}, {-3, 0, 5}, innerSize);
+    expectQuantizeMatchesReference<int8_t>(params);
+    expectDequantizeMatchesReference<int8_t>(params);
+  }
+}
+
+TEST(Quantization, OffsetSelectsChannel) {
+  auto params = createParams({0.05f, 0.1f}, {0, 10}, 3);
+  std::vector<float> values = createValues(37);
+  std::vector<uint8_t> whole(values.size());
+  Quantization::quantize(values.data(), whole.data(), values.size(), 0, params);
+
+  // Quantizing the values in two parts gives the same result
+  constexpr size_t split = 7;
+  std::vector<uint8_t> parts(values.size());
+  Quantization::quantize(values.data(), parts.data(), split, 0, params);
+  Quantization::quantize(values.data() + split, parts.data() + split, values.size() - split, split,
+                         params);
+  EXPECT_EQ(parts, whole);
+}
+
+TEST(Quantization, SaturatesOutOfRangeValues) {
+  const float extremes[] = {1e9f, -1e9f, std::numeric_limits<float>::max(),
+                            std::numeric_limits<float>::lowest()};
+  // The first block goes through the SIMD path (if any), the tail through the scalar one.
+  std::vector<float> values(20, 0.0f);
+  std::copy(std::begin(extremes), std::end(extremes), values.begin());
+  std::copy(std::begin(extremes), std::end(extremes), values.begin() + 16);
+  // Adding a zero point must not overflow the saturated values either.
+  for (int32_t zeroPoint : {-100, 0, 100}) {
+    SCOPED_TRACE("zero point " + std::to_string(zeroPoint));
+    auto params = createParams({0.5f}, {zeroPoint});
+
+    std::vector<int8_t> signedOutput(values.size());
+    Quantization::quantize(values.data(), signedOutput.data(), values.size(), 0, params);
+    std::vector<uint8_t> unsignedOutput(values.size());
+    Quantization::quantize(values.data(), unsignedOutput.data(), values.size(), 0, params);
+    for (size_t start : {0, 16}) {
+      SCOPED_TRACE("at " + std::to_string(start));
+      EXPECT_EQ(signedOutput[start], 127);
+      EXPECT_EQ(signedOutput[start + 1], -128);
+      EXPECT_EQ(signedOutput[start + 2], 127);
+      EXPECT_EQ(signedOutput[start + 3], -128);
+      EXPECT_EQ(unsignedOutput[start], 255);
+      EXPECT_EQ(unsignedOutput[start + 1], 0);
+      EXPECT_EQ(unsignedOutput[start + 2], 255);
+      EXPECT_EQ(unsignedOutput[start + 3], 0);
+    }
+  }
+}
+
+} // namespace
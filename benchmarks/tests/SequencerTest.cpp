@@ -0,0 +1,63 @@
+//
+//  SequencerTest.cpp
+//  react-native-fast-tflite
+//
+
+#include "Sequencer.h"
+#include <gtest/gtest.h>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+TEST(Sequencer, RunsJobsInSequenceOrder) {
+  constexpr uint64_t jobCount = 8;
+  Sequencer sequencer;
+  std::mutex mutex;
+  std::vector<uint64_t> order;
+
+  // Start the jobs in reverse, so every job but the last has to wait for its turn.
+  std::vector<std::thread> threads;
+  for (uint64_t i = jobCount; i-- > 0;) {
+    threads.emplace_back([&, i]() {
+      sequencer.run(i, [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        order.push_back(i);
+      });
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(order.size(), jobCount);
+  for (uint64_t i = 0; i < jobCount; i++) {
+    EXPECT_EQ(order[i], i);
+  }
+}
+
+TEST(Sequencer, PassesOnWhenJobThrows) {
+  Sequencer sequencer;
+  EXPECT_THROW(sequencer.run(0, []() { throw std::runtime_error("failed"); }),
+               std::runtime_error);
+
+  bool didRun = false;
+  std::thread next([&]() { sequencer.run(1, [&]() { didRun = true; }); });
+  next.join();
+  EXPECT_TRUE(didRun);
+}
+
+TEST(Sequencer, PassesSkippedSequenceNumbers) {
+  Sequencer sequencer;
+  std::vector<uint64_t> order;
+  // Skipped before and after their turn came
+  sequencer.skip(1);
+  sequencer.run(0, [&]() { order.push_back(0); });
+  sequencer.skip(2);
+  sequencer.run(3, [&]() { order.push_back(3); });
+  EXPECT_EQ(order, (std::vector<uint64_t>{0, 3}));
+}
+
+} // namespace
@@ -0,0 +1,65 @@
+#include "Buffer.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Buffer Buffer::mapFileDescriptor(int fd, size_t offset, size_t length) {
+  // mmap offsets have to be page-aligned, but the model might start anywhere inside the file.
+  size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t alignedOffset = offset & ~(pageSize - 1);
+  size_t delta = offset - alignedOffset;
+
+  void* address = mmap(nullptr, length + delta, PROT_READ, MAP_PRIVATE, fd,
+                       static_cast<off_t>(alignedOffset));
+  int error = errno;
+  // The mapping stays valid after the file descriptor is closed.
+  close(fd);
+  if (address == MAP_FAILED) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Failed to memory-map model file! " +
+                             std::string(strerror(error)));
+  }
+
+  return Buffer{.data = static_cast<uint8_t*>(address) + delta,
+                .size = length,
+                .mappedAddress = address,
+                .mappedSize = length + delta};
+}
+
+Buffer Buffer::mapFile(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Failed to open model file \"" + path + "\"! " +
+                             std::string(strerror(errno)));
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+    [[unlikely]];
+    close(fd);
+    throw std::runtime_error("TFLite: Model file \"" + path + "\" is empty or not readable!");
+  }
+
+  return mapFileDescriptor(fd, 0, static_cast<size_t>(info.st_size));
+}
+
+void Buffer::release() {
+  if (mappedAddress != nullptr) {
+    munmap(mappedAddress, mappedSize);
+  } else if (data != nullptr) {
+    free(data);
+  }
+  data = nullptr;
+  size = 0;
+  mappedAddress = nullptr;
+  mappedSize = 0;
+}
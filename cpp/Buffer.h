@@ -0,0 +1,33 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+/**
+ A block of memory holding a Model's data.
+ The memory is either `malloc`ed (`data`), or memory-mapped from a file (`mappedAddress`).
+ */
+struct Buffer {
+  void* data;
+  size_t size;
+  // If the Buffer is memory-mapped, this is the page-aligned start of the mapping.
+  void* mappedAddress = nullptr;
+  size_t mappedSize = 0;
+
+  /**
+   Memory-map `length` bytes at `offset` of the given file descriptor (e.g. a region inside an APK).
+   Takes ownership of the file descriptor and closes it.
+   */
+  static Buffer mapFileDescriptor(int fd, size_t offset, size_t length);
+  /**
+   Memory-map the whole file at the given path.
+   */
+  static Buffer mapFile(const std::string& path);
+
+  /**
+   Frees or unmaps the memory held by this Buffer.
+   */
+  void release();
+};
+
+typedef std::function<Buffer(std::string)> FetchURLFunc;
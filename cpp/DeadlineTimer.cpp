@@ -0,0 +1,71 @@
+#include "DeadlineTimer.h"
+
+#include <pthread.h>
+
+DeadlineTimer::DeadlineTimer(std::string name) : _name(std::move(name)) {}
+
+DeadlineTimer::~DeadlineTimer() {
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _isRunning = false;
+    _callbacks.clear();
+    _deadlines.clear();
+  }
+  _condition.notify_all();
+
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+}
+
+uint64_t DeadlineTimer::schedule(TimePoint deadline, Callback callback) {
+  uint64_t id;
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_thread.joinable()) {
+      _thread = std::thread([this]() { loop(); });
+    }
+    id = _nextId++;
+    _callbacks.emplace(std::make_pair(deadline, id), std::move(callback));
+    _deadlines.emplace(id, deadline);
+  }
+  // The new deadline might be earlier than the one the Thread currently waits for.
+  _condition.notify_one();
+  return id;
+}
+
+void DeadlineTimer::cancel(uint64_t id) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  auto deadline = _deadlines.find(id);
+  if (deadline == _deadlines.end()) {
+    // Already called (or cancelled)
+    return;
+  }
+  _callbacks.erase(std::make_pair(deadline->second, id));
+  _deadlines.erase(deadline);
+}
+
+void DeadlineTimer::loop() {
+#ifdef __APPLE__
+  pthread_setname_np(_name.c_str());
+#else
+  pthread_setname_np(pthread_self(), _name.substr(0, 15).c_str());
+#endif
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (_isRunning) {
+    if (_callbacks.empty()) {
+      _condition.wait(lock);
+      continue;
+    }
+    auto next = _callbacks.begin();
+    TimePoint deadline = next->first.first;
+    if (std::chrono::steady_clock::now() < deadline) {
+      _condition.wait_until(lock, deadline);
+      continue;
+    }
+    next->second();
+    _deadlines.erase(next->first.second);
+    _callbacks.erase(next);
+  }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+/**
+ Calls callbacks on a single background Thread once their deadline passed. The Thread is only
+ started once the first callback is scheduled.
+ Callbacks run while the timer is locked, so they must be short and must not use the timer.
+ */
+class DeadlineTimer {
+public:
+  using Callback = std::function<void()>;
+  using TimePoint = std::chrono::steady_clock::time_point;
+
+  explicit DeadlineTimer(std::string name);
+  ~DeadlineTimer();
+
+  /**
+   Schedules `callback` to be called at `deadline`. Returns an id to cancel it with.
+   */
+  uint64_t schedule(TimePoint deadline, Callback callback);
+  /**
+   Cancels the callback with the given id. Once this returns, the callback is guaranteed to not be
+   running and to never be called.
+   */
+  void cancel(uint64_t id);
+
+private:
+  void loop();
+
+private:
+  std::string _name;
+  bool _isRunning = true;
+  uint64_t _nextId = 0;
+  // Sorted by deadline, then by id
+  std::map<std::pair<TimePoint, uint64_t>, Callback> _callbacks;
+  std::map<uint64_t, TimePoint> _deadlines;
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  std::thread _thread;
+};
@@ -0,0 +1,185 @@
+#include "Detection.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+float sigmoid(float value) {
+  return 1.0f / (1.0f + std::exp(-value));
+}
+
+/**
+ The raw score a (logit) score has to exceed to pass the threshold. This avoids computing the
+ sigmoid of every score, only the boxes that pass need it.
+ */
+float getRawThreshold(const DetectionOptions& options) {
+  if (!options.sigmoid) {
+    return options.scoreThreshold;
+  }
+  float threshold = std::clamp(options.scoreThreshold, 1e-6f, 1.0f - 1e-6f);
+  return std::log(threshold / (1.0f - threshold));
+}
+
+/**
+ Finds the best class of a box, returns false if no class passes the threshold.
+ */
+bool getBestClass(const float* scores, size_t classes, size_t stride,
+                  const DetectionOptions& options, float rawThreshold, size_t& classIndex,
+                  float& score) {
+  size_t firstClass = options.skipBackgroundClass ? 1 : 0;
+  float best = rawThreshold;
+  bool found = false;
+  for (size_t i = firstClass; i < classes; i++) {
+    float value = scores[i * stride];
+    if (value > best) {
+      best = value;
+      classIndex = i;
+      found = true;
+    }
+  }
+  score = options.sigmoid ? sigmoid(best) : best;
+  return found;
+}
+
+float getArea(const DetectedObject& box) {
+  return std::max(box.x2 - box.x1, 0.0f) * std::max(box.y2 - box.y1, 0.0f);
+}
+
+float getIntersectionOverUnion(const DetectedObject& a, const DetectedObject& b) {
+  float width = std::min(a.x2, b.x2) - std::max(a.x1, b.x1);
+  float height = std::min(a.y2, b.y2) - std::max(a.y1, b.y1);
+  if (width <= 0 || height <= 0) {
+    return 0;
+  }
+  float intersection = width * height;
+  return intersection / (getArea(a) + getArea(b) - intersection);
+}
+
+} // namespace
+
+std::vector<DetectedObject> Detection::decodeSSD(const float* boxes, const float* scores,
+                                                 size_t count, size_t classes,
+                                                 const DetectionOptions& options) {
+  bool hasAnchors = !options.anchors.empty();
+  if (hasAnchors && options.anchors.size() != count * 4) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Expected " + std::to_string(count * 4) +
+                             " anchor values (4 per box), but received " +
+                             std::to_string(options.anchors.size()) + "!");
+  }
+
+  float rawThreshold = getRawThreshold(options);
+  std::vector<DetectedObject> result;
+  for (size_t i = 0; i < count; i++) {
+    DetectedObject object;
+    if (!getBestClass(scores + i * classes, classes, 1, options, rawThreshold, object.classIndex,
+                      object.score)) {
+      continue;
+    }
+
+    // Only the boxes that pass the threshold are decoded
+    const float* box = boxes + i * 4;
+    if (hasAnchors) {
+      const float* anchor = options.anchors.data() + i * 4;
+      float centerY = box[0] / options.boxScales[0] * anchor[2] + anchor[0];
+      float centerX = box[1] / options.boxScales[1] * anchor[3] + anchor[1];
+      float height = std::exp(box[2] / options.boxScales[2]) * anchor[2];
+      float width = std::exp(box[3] / options.boxScales[3]) * anchor[3];
+      object.x1 = centerX - width / 2;
+      object.y1 = centerY - height / 2;
+      object.x2 = centerX + width / 2;
+      object.y2 = centerY + height / 2;
+    } else {
+      object.x1 = box[1];
+      object.y1 = box[0];
+      object.x2 = box[3];
+      object.y2 = box[2];
+    }
+    result.push_back(object);
+  }
+  return result;
+}
+
+std::vector<DetectedObject> Detection::decodeYOLO(const float* output, size_t count,
+                                                  size_t attributes, bool transposed,
+                                                  const DetectionOptions& options) {
+  size_t scoresOffset = options.objectness ? 5 : 4;
+  if (attributes <= scoresOffset) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: YOLO output has " + std::to_string(attributes) +
+                             " values per box, which is not enough for a box and class scores!");
+  }
+  size_t classes = attributes - scoresOffset;
+  // The distance between two values of the same box
+  size_t stride = transposed ? count : 1;
+
+  float rawThreshold = getRawThreshold(options);
+  std::vector<DetectedObject> result;
+  for (size_t i = 0; i < count; i++) {
+    const float* values = transposed ? output + i : output + i * attributes;
+    float objectness = 1.0f;
+    if (options.objectness) {
+      objectness = options.sigmoid ? sigmoid(values[4 * stride]) : values[4 * stride];
+      if (objectness <= options.scoreThreshold) {
+        // Class scores are at most 1, so this box can never pass the threshold.
+        continue;
+      }
+    }
+
+    DetectedObject object;
+    // With objectness, the class score alone may be below the threshold.
+    float classThreshold = options.objectness ? -INFINITY : rawThreshold;
+    if (!getBestClass(values + scoresOffset * stride, classes, stride, options, classThreshold,
+                      object.classIndex, object.score)) {
+      continue;
+    }
+    object.score *= objectness;
+    if (object.score <= options.scoreThreshold) {
+      continue;
+    }
+
+    float centerX = values[0];
+    float centerY = values[stride];
+    float width = values[2 * stride];
+    float height = values[3 * stride];
+    object.x1 = centerX - width / 2;
+    object.y1 = centerY - height / 2;
+    object.x2 = centerX + width / 2;
+    object.y2 = centerY + height / 2;
+    result.push_back(object);
+  }
+  return result;
+}
+
+std::vector<DetectedObject>
+Detection::nonMaximumSuppression(std::vector<DetectedObject> candidates,
+                                 const DetectionOptions& options) {
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const DetectedObject& a, const DetectedObject& b) {
+                     return a.score > b.score;
+                   });
+
+  std::vector<DetectedObject> result;
+  for (const DetectedObject& candidate : candidates) {
+    if (result.size() >= options.maxDetections) {
+      break;
+    }
+    bool isSuppressed = false;
+    for (const DetectedObject& kept : result) {
+      if (!options.classAgnostic && kept.classIndex != candidate.classIndex) {
+        continue;
+      }
+      if (getIntersectionOverUnion(kept, candidate) > options.iouThreshold) {
+        isSuppressed = true;
+        break;
+      }
+    }
+    if (!isSuppressed) {
+      result.push_back(candidate);
+    }
+  }
+  return result;
+}
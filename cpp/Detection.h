@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ How the raw outputs of an object detection Model are decoded into boxes.
+ */
+struct DetectionOptions {
+  enum Format {
+    // Separate boxes `[N, 4]` and class scores `[N, C]` outputs. With anchors, the boxes are
+    // encoded as `[ty, tx, th, tw]` relative to the anchor `[cy, cx, h, w]`, otherwise they are
+    // already decoded as `[y1, x1, y2, x2]`.
+    SSD,
+    // A single `[N, 4 + C]` (or transposed `[4 + C, N]`) output of `[cx, cy, w, h, ...scores]`,
+    // optionally with an objectness score before the class scores.
+    YOLO,
+  };
+
+  Format format = Format::SSD;
+  // The output tensors that hold the boxes and the scores. YOLO only uses `boxesOutput`.
+  size_t boxesOutput = 0;
+  size_t scoresOutput = 1;
+  // SSD anchors as `[cy, cx, h, w]` per box.
+  std::vector<float> anchors;
+  // SSD box encoding scales for `[y, x, h, w]`.
+  std::array<float, 4> boxScales = {10.0f, 10.0f, 5.0f, 5.0f};
+  float scoreThreshold = 0.5f;
+  float iouThreshold = 0.5f;
+  size_t maxDetections = 100;
+  // If true, overlapping boxes of different classes also suppress each other.
+  bool classAgnostic = false;
+  // If true, the scores are logits and a sigmoid is applied to them.
+  bool sigmoid = false;
+  // If true, YOLO outputs have an objectness score that is multiplied with the class scores.
+  bool objectness = false;
+  // If true, the first class is a background class that is never detected.
+  bool skipBackgroundClass = false;
+};
+
+struct DetectedObject {
+  float x1;
+  float y1;
+  float x2;
+  float y2;
+  float score;
+  size_t classIndex;
+};
+
+/**
+ Object detection decoding and non-maximum suppression kernels.
+ These don't depend on JSI or TFLite, so they can be benchmarked on any host.
+ */
+class Detection {
+public:
+  /**
+   Decodes `count` SSD boxes with `classes` scores each, keeping only the boxes above the score
+   threshold.
+   */
+  static std::vector<DetectedObject> decodeSSD(const float* boxes, const float* scores,
+                                               size_t count, size_t classes,
+                                               const DetectionOptions& options);
+  /**
+   Decodes `count` YOLO boxes with `attributes` values each, keeping only the boxes above the
+   score threshold. If `transposed`, the output is laid out as `[attributes, count]`.
+   */
+  static std::vector<DetectedObject> decodeYOLO(const float* output, size_t count,
+                                                size_t attributes, bool transposed,
+                                                const DetectionOptions& options);
+  /**
+   Removes boxes that overlap a higher scoring box (of the same class) by more than the IoU
+   threshold. The result is sorted by descending score and has at most `maxDetections` boxes.
+   */
+  static std::vector<DetectedObject> nonMaximumSuppression(std::vector<DetectedObject> candidates,
+                                                           const DetectionOptions& options);
+};
@@ -0,0 +1,106 @@
+#include "Float16.h"
+
+#include <cstring>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+uint32_t getBits(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+float fromBits(uint32_t bits) {
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+} // namespace
+
+float Float16::toFloat32(uint16_t value) {
+  uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+  uint32_t exponent = (value >> 10) & 0x1f;
+  uint32_t mantissa = value & 0x3ff;
+
+  if (exponent == 0x1f) {
+    // Infinity or NaN
+    return fromBits(sign | 0x7f800000 | (mantissa << 13));
+  }
+  if (exponent == 0) {
+    // Zero or subnormal, which is exactly `mantissa * 2^-24`
+    float magnitude = static_cast<float>(mantissa) * fromBits(0x33800000);
+    return fromBits(sign | getBits(magnitude));
+  }
+  return fromBits(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+uint16_t Float16::fromFloat32(float value) {
+  uint32_t bits = getBits(value);
+  auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+  uint32_t magnitude = bits & 0x7fffffff;
+
+  if (magnitude >= 0x7f800000) {
+    // Infinity stays infinity, NaN stays a (quiet) NaN
+    return sign | (magnitude > 0x7f800000 ? 0x7e00 : 0x7c00);
+  }
+  if (magnitude >= 0x477ff000) {
+    // Rounds to a value larger than the largest half (65504)
+    return sign | 0x7c00;
+  }
+  if (magnitude < 0x38800000) {
+    // Subnormal half (or zero): Let the FPU round by adding a value that shifts the mantissa
+    // into the lowest bits.
+    float rounded = fromBits(magnitude) + 0.5f;
+    return sign | static_cast<uint16_t>(getBits(rounded) - getBits(0.5f));
+  }
+
+  // Normal half: Rebias the exponent and round the 13 dropped mantissa bits to nearest even.
+  uint32_t isOdd = (magnitude >> 13) & 1;
+  magnitude += 0xc8000fff + isOdd;
+  return sign | static_cast<uint16_t>(magnitude >> 13);
+}
+
+void Float16::toFloat32(const uint16_t* input, float* output, size_t count) {
+  size_t index = 0;
+#if defined(__aarch64__)
+  for (; index + 8 <= count; index += 8) {
+    float16x8_t halves = vreinterpretq_f16_u16(vld1q_u16(input + index));
+    vst1q_f32(output + index, vcvt_f32_f16(vget_low_f16(halves)));
+    vst1q_f32(output + index + 4, vcvt_high_f32_f16(halves));
+  }
+#elif defined(__F16C__)
+  for (; index + 8 <= count; index += 8) {
+    __m128i halves = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + index));
+    _mm256_storeu_ps(output + index, _mm256_cvtph_ps(halves));
+  }
+#endif
+  for (; index < count; index++) {
+    output[index] = toFloat32(input[index]);
+  }
+}
+
+void Float16::fromFloat32(const float* input, uint16_t* output, size_t count) {
+  size_t index = 0;
+#if defined(__aarch64__)
+  for (; index + 8 <= count; index += 8) {
+    float16x4_t low = vcvt_f16_f32(vld1q_f32(input + index));
+    float16x8_t halves = vcvt_high_f16_f32(low, vld1q_f32(input + index + 4));
+    vst1q_u16(output + index, vreinterpretq_u16_f16(halves));
+  }
+#elif defined(__F16C__)
+  for (; index + 8 <= count; index += 8) {
+    __m128i halves = _mm256_cvtps_ph(_mm256_loadu_ps(input + index), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + index), halves);
+  }
+#endif
+  for (; index < count; index++) {
+    output[index] = fromFloat32(input[index]);
+  }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ Vectorized (F16C/NEON) conversion between IEEE 754 half-precision floats (stored as raw 16-bit
+ values) and 32-bit floats.
+ These don't depend on JSI or TFLite, so they can be benchmarked on any host.
+ */
+class Float16 {
+public:
+  static void toFloat32(const uint16_t* input, float* output, size_t count);
+  /**
+   Rounds to the nearest half-precision value (ties to even), out-of-range values become infinity.
+   */
+  static void fromFloat32(const float* input, uint16_t* output, size_t count);
+
+  static float toFloat32(uint16_t value);
+  static uint16_t fromFloat32(float value);
+};
@@ -0,0 +1,261 @@
+#include "ImageProcessing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Bilinear weights are 8-bit fixed point, so all interpolation happens in 32-bit integers.
+constexpr uint32_t kWeightOne = 256;
+
+/**
+ The two neighbouring source pixels (along one axis) of an output pixel, and the weight of the
+ second one.
+ */
+struct Tap {
+  uint32_t index0;
+  uint32_t index1;
+  uint32_t weight;
+};
+
+/**
+ Computes the taps along one axis. `reversed` walks the crop backwards (for rotating and
+ mirroring), `divisor` is 2 for subsampled chroma planes.
+ */
+std::vector<Tap> createTaps(size_t outputSize, bool reversed, float cropStart, float cropSize,
+                            size_t planeSize, float divisor) {
+  std::vector<Tap> taps(outputSize);
+  for (size_t i = 0; i < outputSize; i++) {
+    float position = (static_cast<float>(i) + 0.5f) / static_cast<float>(outputSize);
+    if (reversed) {
+      position = 1.0f - position;
+    }
+    // Pixel centers are at +0.5
+    float coordinate = (cropStart + position * cropSize) / divisor - 0.5f;
+    coordinate = std::clamp(coordinate, 0.0f, static_cast<float>(planeSize - 1));
+    auto index0 = static_cast<uint32_t>(coordinate);
+    taps[i].index0 = index0;
+    taps[i].index1 = std::min(index0 + 1, static_cast<uint32_t>(planeSize - 1));
+    taps[i].weight = static_cast<uint32_t>(std::lround((coordinate - index0) * kWeightOne));
+  }
+  return taps;
+}
+
+inline uint32_t interpolate(uint32_t topLeft, uint32_t topRight, uint32_t bottomLeft,
+                            uint32_t bottomRight, uint32_t weightX, uint32_t weightY) {
+  uint32_t top = topLeft * (kWeightOne - weightX) + topRight * weightX;
+  uint32_t bottom = bottomLeft * (kWeightOne - weightX) + bottomRight * weightX;
+  return (top * (kWeightOne - weightY) + bottom * weightY + (1 << 15)) >> 16;
+}
+
+inline uint8_t clampToByte(int32_t value) {
+  return static_cast<uint8_t>(std::clamp(value, 0, 255));
+}
+
+/**
+ Full-range BT.601 (JFIF) YUV to RGB, in 16-bit fixed point.
+ */
+inline void convertYUVToRGB(int32_t y, int32_t u, int32_t v, uint8_t* rgb) {
+  int32_t d = u - 128;
+  int32_t e = v - 128;
+  rgb[0] = clampToByte(y + ((91881 * e + (1 << 15)) >> 16));
+  rgb[1] = clampToByte(y - ((22554 * d + 46802 * e + (1 << 15)) >> 16));
+  rgb[2] = clampToByte(y + ((116130 * d + (1 << 15)) >> 16));
+}
+
+/**
+ Calls `sample(xIndex, yIndex, rgb)` for every output pixel and hands every finished row over.
+ With a rotation of 90 or 270 degrees, the output's x axis walks along the source's y axis.
+ */
+template <typename Sampler>
+void resampleRows(size_t outputWidth, size_t outputHeight, bool swapAxes, Sampler&& sample,
+                  const std::function<void(size_t row, const uint8_t* pixels)>& onRow) {
+  std::vector<uint8_t> row(outputWidth * 3);
+  for (size_t outputY = 0; outputY < outputHeight; outputY++) {
+    for (size_t outputX = 0; outputX < outputWidth; outputX++) {
+      size_t xIndex = swapAxes ? outputY : outputX;
+      size_t yIndex = swapAxes ? outputX : outputY;
+      sample(xIndex, yIndex, row.data() + outputX * 3);
+    }
+    onRow(outputY, row.data());
+  }
+}
+
+size_t getBytesPerPixel(PixelFormat format) {
+  switch (format) {
+    case PixelFormat::RGB:
+      return 3;
+    case PixelFormat::RGBA:
+    case PixelFormat::BGRA:
+      return 4;
+    default:
+      return 1;
+  }
+}
+
+void validatePlane(const char* name, size_t offset, size_t bytesPerRow, size_t rowLength,
+                   size_t rows, size_t byteLength) {
+  if (bytesPerRow < rowLength || offset + (rows - 1) * bytesPerRow + rowLength > byteLength) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: The image's " + std::string(name) + " plane (offset " +
+                             std::to_string(offset) + ", " + std::to_string(bytesPerRow) +
+                             " bytes per row, " + std::to_string(rows) +
+                             " rows) does not fit into its " + std::to_string(byteLength) +
+                             " bytes!");
+  }
+}
+
+} // namespace
+
+ImageBuffer ImageProcessing::createImageBuffer(const uint8_t* data, size_t byteLength,
+                                               PixelFormat format, size_t width, size_t height,
+                                               size_t bytesPerRow, size_t uvOffset,
+                                               size_t uvBytesPerRow, size_t vOffset) {
+  if (data == nullptr || width == 0 || height == 0) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: The image is empty!");
+  }
+
+  ImageBuffer image;
+  image.format = format;
+  image.width = width;
+  image.height = height;
+
+  size_t rowLength = width * getBytesPerPixel(format);
+  image.planes[0] = data;
+  image.bytesPerRow[0] = bytesPerRow != 0 ? bytesPerRow : rowLength;
+  validatePlane("first", 0, image.bytesPerRow[0], rowLength, height, byteLength);
+
+  size_t chromaWidth = (width + 1) / 2;
+  size_t chromaHeight = (height + 1) / 2;
+  if (uvOffset == 0) {
+    uvOffset = image.bytesPerRow[0] * height;
+  }
+  switch (format) {
+    case PixelFormat::NV12:
+    case PixelFormat::NV21:
+      image.planes[1] = data + uvOffset;
+      image.bytesPerRow[1] = uvBytesPerRow != 0 ? uvBytesPerRow : chromaWidth * 2;
+      validatePlane("chroma", uvOffset, image.bytesPerRow[1], chromaWidth * 2, chromaHeight,
+                    byteLength);
+      break;
+    case PixelFormat::I420:
+      image.bytesPerRow[1] = uvBytesPerRow != 0 ? uvBytesPerRow : chromaWidth;
+      image.bytesPerRow[2] = image.bytesPerRow[1];
+      if (vOffset == 0) {
+        vOffset = uvOffset + image.bytesPerRow[1] * chromaHeight;
+      }
+      image.planes[1] = data + uvOffset;
+      image.planes[2] = data + vOffset;
+      validatePlane("U", uvOffset, image.bytesPerRow[1], chromaWidth, chromaHeight, byteLength);
+      validatePlane("V", vOffset, image.bytesPerRow[2], chromaWidth, chromaHeight, byteLength);
+      break;
+    default:
+      break;
+  }
+  return image;
+}
+
+void ImageProcessing::resample(
+    const ImageBuffer& image, const ImageTransform& transform, size_t outputWidth,
+    size_t outputHeight, const std::function<void(size_t row, const uint8_t* pixels)>& onRow) {
+  int rotation = ((transform.rotation % 360) + 360) % 360;
+  if (rotation % 90 != 0) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Invalid image rotation " +
+                             std::to_string(transform.rotation) +
+                             "! Only 0, 90, 180 and 270 degrees are supported.");
+  }
+
+  float cropWidth = transform.cropWidth > 0 ? transform.cropWidth : image.width - transform.cropX;
+  float cropHeight =
+      transform.cropHeight > 0 ? transform.cropHeight : image.height - transform.cropY;
+  if (transform.cropX < 0 || transform.cropY < 0 || cropWidth <= 0 || cropHeight <= 0 ||
+      transform.cropX + cropWidth > image.width || transform.cropY + cropHeight > image.height) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: The crop region is outside of the " +
+                             std::to_string(image.width) + "x" + std::to_string(image.height) +
+                             " image!");
+  }
+
+  // Which output axis walks along which source axis, and in which direction.
+  bool swapAxes = rotation == 90 || rotation == 270;
+  bool mirror = transform.mirror;
+  bool reverseX = rotation == 0 ? mirror : rotation == 180 ? !mirror : rotation == 270;
+  bool reverseY = rotation == 0 ? false : rotation == 90 ? !mirror : rotation == 180 || mirror;
+  size_t xTapCount = swapAxes ? outputHeight : outputWidth;
+  size_t yTapCount = swapAxes ? outputWidth : outputHeight;
+  auto createXTaps = [&](size_t planeWidth, float divisor) {
+    return createTaps(xTapCount, reverseX, transform.cropX, cropWidth, planeWidth, divisor);
+  };
+  auto createYTaps = [&](size_t planeHeight, float divisor) {
+    return createTaps(yTapCount, reverseY, transform.cropY, cropHeight, planeHeight, divisor);
+  };
+
+  std::vector<Tap> xTaps = createXTaps(image.width, 1);
+  std::vector<Tap> yTaps = createYTaps(image.height, 1);
+
+  switch (image.format) {
+    case PixelFormat::RGB:
+    case PixelFormat::RGBA:
+    case PixelFormat::BGRA: {
+      size_t bytesPerPixel = getBytesPerPixel(image.format);
+      bool isBGR = image.format == PixelFormat::BGRA;
+      const uint8_t* plane = image.planes[0];
+      size_t bytesPerRow = image.bytesPerRow[0];
+      auto sample = [&](size_t xIndex, size_t yIndex, uint8_t* rgb) {
+        const Tap& x = xTaps[xIndex];
+        const Tap& y = yTaps[yIndex];
+        const uint8_t* top = plane + y.index0 * bytesPerRow;
+        const uint8_t* bottom = plane + y.index1 * bytesPerRow;
+        size_t left = x.index0 * bytesPerPixel;
+        size_t right = x.index1 * bytesPerPixel;
+        for (size_t channel = 0; channel < 3; channel++) {
+          size_t source = isBGR ? 2 - channel : channel;
+          rgb[channel] = interpolate(top[left + source], top[right + source],
+                                     bottom[left + source], bottom[right + source], x.weight,
+                                     y.weight);
+        }
+      };
+      resampleRows(outputWidth, outputHeight, swapAxes, sample, onRow);
+      break;
+    }
+    case PixelFormat::NV12:
+    case PixelFormat::NV21:
+    case PixelFormat::I420: {
+      std::vector<Tap> chromaXTaps = createXTaps((image.width + 1) / 2, 2);
+      std::vector<Tap> chromaYTaps = createYTaps((image.height + 1) / 2, 2);
+      bool isPlanar = image.format == PixelFormat::I420;
+      bool isVFirst = image.format == PixelFormat::NV21;
+      // For semi-planar formats, U and V are interleaved in the same plane.
+      size_t chromaStep = isPlanar ? 1 : 2;
+      const uint8_t* uPlane = image.planes[1] + (isVFirst ? 1 : 0);
+      const uint8_t* vPlane = isPlanar ? image.planes[2] : image.planes[1] + (isVFirst ? 0 : 1);
+      size_t uBytesPerRow = image.bytesPerRow[1];
+      size_t vBytesPerRow = isPlanar ? image.bytesPerRow[2] : image.bytesPerRow[1];
+      const uint8_t* yPlane = image.planes[0];
+      size_t yBytesPerRow = image.bytesPerRow[0];
+
+      auto samplePlane = [](const uint8_t* plane, size_t bytesPerRow, size_t step, const Tap& x,
+                            const Tap& y) {
+        const uint8_t* top = plane + y.index0 * bytesPerRow;
+        const uint8_t* bottom = plane + y.index1 * bytesPerRow;
+        return interpolate(top[x.index0 * step], top[x.index1 * step], bottom[x.index0 * step],
+                           bottom[x.index1 * step], x.weight, y.weight);
+      };
+      auto sample = [&](size_t xIndex, size_t yIndex, uint8_t* rgb) {
+        const Tap& chromaX = chromaXTaps[xIndex];
+        const Tap& chromaY = chromaYTaps[yIndex];
+        uint32_t luma = samplePlane(yPlane, yBytesPerRow, 1, xTaps[xIndex], yTaps[yIndex]);
+        uint32_t u = samplePlane(uPlane, uBytesPerRow, chromaStep, chromaX, chromaY);
+        uint32_t v = samplePlane(vPlane, vBytesPerRow, chromaStep, chromaX, chromaY);
+        convertYUVToRGB(luma, u, v, rgb);
+      };
+      resampleRows(outputWidth, outputHeight, swapAxes, sample, onRow);
+      break;
+    }
+  }
+}
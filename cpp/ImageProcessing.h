@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+enum class PixelFormat { RGB, RGBA, BGRA, NV12, NV21, I420 };
+
+/**
+ A camera frame or image in one of the supported pixel formats. The planes are not owned.
+ */
+struct ImageBuffer {
+  PixelFormat format = PixelFormat::RGB;
+  size_t width = 0;
+  size_t height = 0;
+  // The (interleaved) RGB(A) or the Y plane, followed by the interleaved UV (NV12) or VU (NV21)
+  // plane, or the separate U and V planes (I420).
+  const uint8_t* planes[3] = {};
+  size_t bytesPerRow[3] = {};
+};
+
+/**
+ Where and how an image is sampled into the input tensor.
+ */
+struct ImageTransform {
+  // The region of the image to use, in pixels. A width or height of 0 uses the whole image.
+  float cropX = 0;
+  float cropY = 0;
+  float cropWidth = 0;
+  float cropHeight = 0;
+  // Clockwise rotation in degrees (0, 90, 180 or 270), applied after cropping.
+  int rotation = 0;
+  // Flips the image horizontally, applied after rotating.
+  bool mirror = false;
+};
+
+/**
+ An image input of a run, with where and how it is sampled into the input tensor.
+ */
+struct ImageInput {
+  ImageBuffer buffer;
+  ImageTransform transform;
+};
+
+/**
+ Converts YUV or RGB(A) images into RGB pixels while cropping, resizing (bilinear), rotating and
+ mirroring them in one pass. Rows are produced one at a time, so no full-frame intermediate
+ buffer is needed.
+ These don't depend on JSI or TFLite, so they can be benchmarked on any host.
+ */
+class ImageProcessing {
+public:
+  /**
+   Creates an ImageBuffer for the given memory and validates that all planes fit into it.
+   Strides of 0 use the tightly packed default, chroma offsets of 0 expect the planes right after
+   each other.
+   */
+  static ImageBuffer createImageBuffer(const uint8_t* data, size_t byteLength, PixelFormat format,
+                                       size_t width, size_t height, size_t bytesPerRow = 0,
+                                       size_t uvOffset = 0, size_t uvBytesPerRow = 0,
+                                       size_t vOffset = 0);
+
+  /**
+   Samples the image into `outputWidth` x `outputHeight` interleaved RGB pixels. `onRow` is called
+   for every output row with `outputWidth * 3` bytes, which are only valid during the call.
+   */
+  static void resample(const ImageBuffer& image, const ImageTransform& transform,
+                       size_t outputWidth, size_t outputHeight,
+                       const std::function<void(size_t row, const uint8_t* pixels)>& onRow);
+};
@@ -0,0 +1,115 @@
+#include "InferenceStats.h"
+
+#include <algorithm>
+#include <cmath>
+
+size_t LatencyHistogram::getBucketIndex(uint64_t microseconds) {
+  if (microseconds < kSubBucketCount) {
+    // Small values get one bucket each
+    return microseconds;
+  }
+  size_t highestBit = 63 - __builtin_clzll(microseconds);
+  if (highestBit >= kMaxBits) {
+    [[unlikely]];
+    return kBucketCount - 1;
+  }
+  size_t shift = highestBit - kSubBucketBits;
+  // The bits right below the highest bit pick the sub-bucket
+  size_t subBucket = (microseconds >> shift) & (kSubBucketCount - 1);
+  return kSubBucketCount * (shift + 1) + subBucket;
+}
+
+double LatencyHistogram::getBucketMidpoint(size_t index) {
+  if (index < kSubBucketCount) {
+    return static_cast<double>(index);
+  }
+  size_t shift = index / kSubBucketCount - 1;
+  size_t subBucket = index % kSubBucketCount;
+  double lowerBound = std::ldexp(static_cast<double>(kSubBucketCount + subBucket), shift);
+  double width = std::ldexp(1.0, shift);
+  return lowerBound + width / 2;
+}
+
+void LatencyHistogram::record(uint64_t microseconds) {
+  _buckets[getBucketIndex(microseconds)].fetch_add(1, std::memory_order_relaxed);
+  _count.fetch_add(1, std::memory_order_relaxed);
+  _sum.fetch_add(microseconds, std::memory_order_relaxed);
+  uint64_t max = _max.load(std::memory_order_relaxed);
+  while (microseconds > max &&
+         !_max.compare_exchange_weak(max, microseconds, std::memory_order_relaxed)) {
+  }
+}
+
+double LatencyHistogram::getPercentile(double percentile, uint64_t count) const {
+  auto rank = static_cast<uint64_t>(std::ceil(percentile * static_cast<double>(count)));
+  rank = std::max<uint64_t>(rank, 1);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBucketCount; i++) {
+    seen += _buckets[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      return getBucketMidpoint(i);
+    }
+  }
+  return getBucketMidpoint(kBucketCount - 1);
+}
+
+LatencyHistogram::Summary LatencyHistogram::getSummary() const {
+  Summary summary;
+  summary.count = _count.load(std::memory_order_relaxed);
+  if (summary.count == 0) {
+    return summary;
+  }
+
+  constexpr double microsecondsPerMillisecond = 1000.0;
+  double max = static_cast<double>(_max.load(std::memory_order_relaxed));
+  // A bucket's midpoint can be larger than the largest value that was recorded in it.
+  auto getMilliseconds = [&](double percentile) {
+    return std::min(getPercentile(percentile, summary.count), max) / microsecondsPerMillisecond;
+  };
+  summary.mean = static_cast<double>(_sum.load(std::memory_order_relaxed)) /
+                 static_cast<double>(summary.count) / microsecondsPerMillisecond;
+  summary.p50 = getMilliseconds(0.5);
+  summary.p95 = getMilliseconds(0.95);
+  summary.p99 = getMilliseconds(0.99);
+  summary.max = max / microsecondsPerMillisecond;
+  return summary;
+}
+
+void LatencyHistogram::reset() {
+  for (auto& bucket : _buckets) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  _count.store(0, std::memory_order_relaxed);
+  _sum.store(0, std::memory_order_relaxed);
+  _max.store(0, std::memory_order_relaxed);
+}
+
+void InferenceStats::record(Phase phase, std::chrono::steady_clock::duration duration) {
+  auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+  microseconds = std::max<decltype(microseconds)>(microseconds, 0);
+  _histograms[static_cast<size_t>(phase)].record(static_cast<uint64_t>(microseconds));
+}
+
+void InferenceStats::recordSince(Phase phase, std::chrono::steady_clock::time_point start) {
+  record(phase, std::chrono::steady_clock::now() - start);
+}
+
+void InferenceStats::reset() {
+  for (auto& histogram : _histograms) {
+    histogram.reset();
+  }
+}
+
+const char* InferenceStats::getPhaseName(Phase phase) {
+  switch (phase) {
+    case Phase::QueueWait:
+      return "queueWait";
+    case Phase::Input:
+      return "input";
+    case Phase::Invoke:
+      return "invoke";
+    case Phase::Output:
+      return "output";
+  }
+  return "unknown";
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ A latency histogram with log-linear buckets (16 per power of two, so every bucket is at most
+ ~6% wide) over microseconds. Recording only uses relaxed atomic counters, so it can be called
+ from any Thread without locking.
+ */
+class LatencyHistogram {
+public:
+  // Latencies in milliseconds, percentiles are accurate to the width of their bucket.
+  struct Summary {
+    uint64_t count = 0;
+    double mean = 0;
+    double p50 = 0;
+    double p95 = 0;
+    double p99 = 0;
+    double max = 0;
+  };
+
+  void record(uint64_t microseconds);
+  /**
+   Computes the percentiles from the current counters. Values that are recorded concurrently may
+   or may not be included.
+   */
+  Summary getSummary() const;
+  void reset();
+
+private:
+  static constexpr size_t kSubBucketBits = 4;
+  static constexpr size_t kSubBucketCount = 1 << kSubBucketBits;
+  // Covers up to 2^36 microseconds (~19 hours), larger values are counted in the last bucket.
+  static constexpr size_t kMaxBits = 36;
+  static constexpr size_t kBucketCount = kSubBucketCount * (kMaxBits - kSubBucketBits + 1);
+
+  static size_t getBucketIndex(uint64_t microseconds);
+  static double getBucketMidpoint(size_t index);
+  double getPercentile(double percentile, uint64_t count) const;
+
+private:
+  std::array<std::atomic<uint64_t>, kBucketCount> _buckets{};
+  std::atomic<uint64_t> _count{0};
+  std::atomic<uint64_t> _sum{0};
+  std::atomic<uint64_t> _max{0};
+};
+
+/**
+ Where the time of every run goes: Waiting in the queue, copying (and converting) the inputs,
+ invoking the Model and copying (and converting) the outputs.
+ */
+class InferenceStats {
+public:
+  enum class Phase { QueueWait, Input, Invoke, Output };
+  static constexpr size_t kPhaseCount = 4;
+
+  /**
+   Records the time from its creation until it is destroyed.
+   */
+  class Timer {
+  public:
+    Timer(InferenceStats& stats, Phase phase)
+        : _stats(stats), _phase(phase), _start(std::chrono::steady_clock::now()) {}
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+    ~Timer() {
+      _stats.record(_phase, std::chrono::steady_clock::now() - _start);
+    }
+
+  private:
+    InferenceStats& _stats;
+    Phase _phase;
+    std::chrono::steady_clock::time_point _start;
+  };
+
+public:
+  void record(Phase phase, std::chrono::steady_clock::duration duration);
+  /**
+   Records the time between `start` and now.
+   */
+  void recordSince(Phase phase, std::chrono::steady_clock::time_point start);
+
+  const LatencyHistogram& get(Phase phase) const {
+    return _histograms[static_cast<size_t>(phase)];
+  }
+  void reset();
+
+  static const char* getPhaseName(Phase phase);
+
+private:
+  std::array<LatencyHistogram, kPhaseCount> _histograms;
+};
@@ -0,0 +1,70 @@
+#include "InterpreterPool.h"
+
+#include <utility>
+
+#if defined(ANDROID) || defined(FAST_TFLITE_HOST)
+#include <tflite/c/c_api_experimental.h>
+#endif
+
+InterpreterPool::Lease::~Lease() {
+  if (_pool != nullptr) {
+    _pool->release(_index);
+  }
+}
+
+InterpreterPool::InterpreterPool(std::vector<std::shared_ptr<TfLiteInterpreter>> interpreters)
+    : _interpreters(std::move(interpreters)), _isBusy(_interpreters.size(), false),
+      _isAsync(_interpreters.size(), false) {}
+
+InterpreterPool::Lease InterpreterPool::acquire() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true) {
+    size_t first = _isPrimaryReserved && _interpreters.size() > 1 ? 1 : 0;
+    // Prefer the last free Interpreter so the primary one stays free for `runSync`
+    for (size_t i = _interpreters.size(); i > first; i--) {
+      if (!_isBusy[i - 1]) {
+        _isBusy[i - 1] = true;
+        _isAsync[i - 1] = true;
+        return Lease(this, i - 1);
+      }
+    }
+    _condition.wait(lock);
+  }
+}
+
+InterpreterPool::Lease InterpreterPool::acquire(size_t index) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _condition.wait(lock, [&]() { return !_isBusy[index]; });
+  _isBusy[index] = true;
+  return Lease(this, index);
+}
+
+void InterpreterPool::release(size_t index) {
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _isBusy[index] = false;
+    _isAsync[index] = false;
+  }
+  _condition.notify_all();
+}
+
+void InterpreterPool::cancelAsyncRuns() {
+  // Holding the lock makes sure the Interpreter can't be released and acquired by `runSync` while
+  // we cancel it.
+  std::unique_lock<std::mutex> lock(_mutex);
+  for (size_t i = 0; i < _interpreters.size(); i++) {
+    if (_isAsync[i]) {
+      TfLiteInterpreterCancel(_interpreters[i].get());
+    }
+  }
+}
+
+void InterpreterPool::reservePrimary() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _isPrimaryReserved = true;
+}
+
+bool InterpreterPool::isAcquiredForAsyncRun(size_t index) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  return _isAsync[index];
+}
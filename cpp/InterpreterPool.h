@@ -0,0 +1,98 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(ANDROID) || defined(FAST_TFLITE_HOST)
+#include <tflite/c/c_api.h>
+#else
+#include <TensorFlowLiteC/TensorFlowLiteC.h>
+#endif
+
+/**
+ A fixed set of Interpreters created from the same Model, which can be used from multiple Threads.
+ An Interpreter can only be used by one Thread at a time, so it has to be acquired first.
+ */
+class InterpreterPool {
+public:
+  /**
+   Exclusive access to one Interpreter of the pool. Releases the Interpreter when destroyed.
+   */
+  class Lease {
+  public:
+    Lease(InterpreterPool* pool, size_t index) : _pool(pool), _index(index) {}
+    Lease(Lease&& other) noexcept : _pool(other._pool), _index(other._index) {
+      other._pool = nullptr;
+    }
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+    ~Lease();
+
+    TfLiteInterpreter* get() const {
+      return _pool->_interpreters[_index].get();
+    }
+    size_t index() const {
+      return _index;
+    }
+
+  private:
+    InterpreterPool* _pool;
+    size_t _index;
+  };
+
+public:
+  explicit InterpreterPool(std::vector<std::shared_ptr<TfLiteInterpreter>> interpreters);
+
+  /**
+   Waits until any Interpreter is free and acquires it for an async run.
+   The primary Interpreter (index 0) is only used if all others are busy, so `runSync` can use it,
+   and never if it is reserved (see `reservePrimary()`).
+   */
+  Lease acquire();
+  /**
+   Waits until the Interpreter at the given index is free and acquires it.
+   Its invocations are never interrupted by `cancelAsyncRuns()`.
+   */
+  Lease acquire(size_t index);
+
+  /**
+   Interrupts the running invocations of all Interpreters that are currently acquired for an async
+   run (with `acquire()`). Invocations that start afterwards are not affected.
+   */
+  void cancelAsyncRuns();
+
+  /**
+   Stops async runs from using the primary Interpreter, e.g. because JS holds TypedArrays that point
+   to its tensors. Has no effect if the pool only has one Interpreter.
+   */
+  void reservePrimary();
+  /**
+   Whether the Interpreter at the given index is currently acquired for an async run.
+   */
+  bool isAcquiredForAsyncRun(size_t index);
+
+  size_t size() const {
+    return _interpreters.size();
+  }
+  /**
+   Get the Interpreter at the given index without acquiring it.
+   Only use this for things that don't change while running, e.g. reading tensor metadata.
+   */
+  const std::shared_ptr<TfLiteInterpreter>& at(size_t index) const {
+    return _interpreters[index];
+  }
+
+private:
+  void release(size_t index);
+
+private:
+  std::vector<std::shared_ptr<TfLiteInterpreter>> _interpreters;
+  std::vector<bool> _isBusy;
+  // Whether the Interpreter is acquired for an async run, which `cancelAsyncRuns()` interrupts.
+  std::vector<bool> _isAsync;
+  bool _isPrimaryReserved = false;
+  std::mutex _mutex;
+  std::condition_variable _condition;
+};
@@ -0,0 +1,116 @@
+#include "LoaderPool.h"
+
+#include <algorithm>
+#include <pthread.h>
+#include <utility>
+
+LoaderPool::LoaderPool(std::string name, size_t maxConcurrency)
+    : _name(std::move(name)), _maxConcurrency(std::max(maxConcurrency, static_cast<size_t>(1))) {
+  for (size_t i = 0; i < _maxConcurrency; i++) {
+    _threads.emplace_back([this]() { loop(); });
+  }
+}
+
+LoaderPool::~LoaderPool() {
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _isRunning = false;
+    _queue.clear();
+    for (auto& load : _running) {
+      load.isCancelled->store(true);
+    }
+  }
+  _condition.notify_all();
+
+  for (auto& thread : _threads) {
+    thread.join();
+  }
+}
+
+void LoaderPool::enqueue(uint64_t id, int priority, Job job, CancelledCallback onCancelled) {
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto position = std::find_if(_queue.begin(), _queue.end(),
+                                 [priority](const Load& load) { return load.priority < priority; });
+    _queue.insert(position, Load{.id = id,
+                                 .priority = priority,
+                                 .job = std::move(job),
+                                 .onCancelled = std::move(onCancelled),
+                                 .isCancelled = std::make_shared<std::atomic<bool>>(false)});
+  }
+  _condition.notify_one();
+}
+
+bool LoaderPool::cancel(uint64_t id) {
+  CancelledCallback onCancelled;
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto isLoad = [id](const Load& load) { return load.id == id; };
+    auto pending = std::find_if(_queue.begin(), _queue.end(), isLoad);
+    if (pending != _queue.end()) {
+      onCancelled = std::move(pending->onCancelled);
+      _queue.erase(pending);
+    } else {
+      auto running = std::find_if(_running.begin(), _running.end(), isLoad);
+      if (running == _running.end()) {
+        return false;
+      }
+      running->isCancelled->store(true);
+      return true;
+    }
+  }
+  // Called outside of the lock, the callback might enqueue or cancel other loads.
+  onCancelled();
+  return true;
+}
+
+void LoaderPool::setMaxConcurrency(size_t maxConcurrency) {
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _maxConcurrency = std::max(maxConcurrency, static_cast<size_t>(1));
+    while (_threads.size() < _maxConcurrency) {
+      _threads.emplace_back([this]() { loop(); });
+    }
+  }
+  _condition.notify_all();
+}
+
+void LoaderPool::loop() {
+#ifdef __APPLE__
+  pthread_setname_np(_name.c_str());
+#else
+  pthread_setname_np(pthread_self(), _name.substr(0, 15).c_str());
+#endif
+
+  while (true) {
+    Job job;
+    CancellationFlag isCancelled;
+    uint64_t id;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      // Threads above the current limit stay idle until it is raised again.
+      _condition.wait(lock, [this]() {
+        return !_isRunning || (!_queue.empty() && _running.size() < _maxConcurrency);
+      });
+      if (!_isRunning) {
+        return;
+      }
+      Load load = std::move(_queue.front());
+      _queue.pop_front();
+      job = std::move(load.job);
+      isCancelled = load.isCancelled;
+      id = load.id;
+      _running.push_back(std::move(load));
+    }
+
+    job(isCancelled);
+
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _running.erase(std::find_if(_running.begin(), _running.end(),
+                                  [id](const Load& load) { return load.id == id; }));
+    }
+    // A slot is free again, another Thread might be waiting for it.
+    _condition.notify_one();
+  }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ Runs Model loads on a few dedicated Threads, at most `maxConcurrency` at a time. Pending loads
+ start in order of their priority (higher first), loads with the same priority in the order they
+ were enqueued.
+ Loads are identified by the id the caller passes in, and can be cancelled with that id. Like
+ ThreadPool, it must not be destroyed from one of its own jobs.
+ */
+class LoaderPool {
+public:
+  // Set once the load was cancelled while it was running. Loads check it between their steps.
+  using CancellationFlag = std::shared_ptr<std::atomic<bool>>;
+  using Job = std::function<void(const CancellationFlag& isCancelled)>;
+  // Called instead of the job if it was cancelled before it started.
+  using CancelledCallback = std::function<void()>;
+
+  LoaderPool(std::string name, size_t maxConcurrency);
+  ~LoaderPool();
+
+  void enqueue(uint64_t id, int priority, Job job, CancelledCallback onCancelled);
+  /**
+   Cancels the load with the given id. A pending load is removed from the queue and its
+   `onCancelled` callback is called, a running load gets its CancellationFlag set.
+   Returns `false` if there is no such load (anymore).
+   */
+  bool cancel(uint64_t id);
+  /**
+   Changes how many loads can run at the same time (at least 1). Running loads are not affected.
+   */
+  void setMaxConcurrency(size_t maxConcurrency);
+
+private:
+  struct Load {
+    uint64_t id;
+    int priority;
+    Job job;
+    CancelledCallback onCancelled;
+    CancellationFlag isCancelled;
+  };
+
+  void loop();
+
+private:
+  std::string _name;
+  size_t _maxConcurrency;
+  bool _isRunning = true;
+  // Sorted by descending priority
+  std::deque<Load> _queue;
+  // The loads that are currently running, so they can be cancelled
+  std::vector<Load> _running;
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  std::vector<std::thread> _threads;
+};
@@ -0,0 +1,80 @@
+#include "ModelRegistry.h"
+
+#include <sys/stat.h>
+
+ModelRegistry& ModelRegistry::shared() {
+  static ModelRegistry registry;
+  return registry;
+}
+
+std::string ModelRegistry::getKey(const std::string& url) {
+  std::string path = url;
+  const std::string filePrefix = "file://";
+  if (path.rfind(filePrefix, 0) == 0) {
+    path = path.substr(filePrefix.size());
+  }
+  if (path.empty() || path[0] != '/') {
+    // Not a local file (bundled resource or remote URL), the URL identifies the Model.
+    return url;
+  }
+
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0) {
+    return url;
+  }
+  return url + "@" + std::to_string(static_cast<long long>(info.st_mtime)) + ":" +
+         std::to_string(static_cast<long long>(info.st_size));
+}
+
+std::shared_ptr<TfLiteModel> ModelRegistry::getOrLoad(const std::string& key,
+                                                      const LoadFunc& load) {
+  std::unique_lock<std::mutex> lock(_mutex);
+
+  auto loaded = _models.find(key);
+  if (loaded != _models.end()) {
+    if (auto model = loaded->second.lock()) {
+      return model;
+    }
+  }
+
+  auto pending = _pendingLoads.find(key);
+  if (pending != _pendingLoads.end()) {
+    // Someone else is already loading this Model, wait for it.
+    auto future = pending->second;
+    lock.unlock();
+    return future.get();
+  }
+
+  std::promise<std::shared_ptr<TfLiteModel>> promise;
+  _pendingLoads[key] = promise.get_future().share();
+  lock.unlock();
+
+  std::shared_ptr<TfLiteModel> model;
+  try {
+    model = load();
+  } catch (...) {
+    lock.lock();
+    _pendingLoads.erase(key);
+    lock.unlock();
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+
+  lock.lock();
+  removeExpiredModels();
+  _models[key] = model;
+  _pendingLoads.erase(key);
+  lock.unlock();
+  promise.set_value(model);
+  return model;
+}
+
+void ModelRegistry::removeExpiredModels() {
+  for (auto it = _models.begin(); it != _models.end();) {
+    if (it->second.expired()) {
+      it = _models.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#if defined(ANDROID) || defined(FAST_TFLITE_HOST)
+#include <tflite/c/c_api.h>
+#else
+#include <TensorFlowLiteC/TensorFlowLiteC.h>
+#endif
+
+/**
+ A process-wide cache of loaded Models, so the same Model is only fetched and loaded once even if
+ multiple components use it. Models are ref-counted, once no Interpreter uses a Model anymore it is
+ freed and the next load fetches it again.
+ */
+class ModelRegistry {
+public:
+  using LoadFunc = std::function<std::shared_ptr<TfLiteModel>()>;
+
+  static ModelRegistry& shared();
+
+  /**
+   Get the key to cache the Model at the given URL with. For local files this includes the file's
+   modification time and size, so changed files are loaded again.
+   */
+  static std::string getKey(const std::string& url);
+
+  /**
+   Get the Model for the given key if it is still loaded, or load it using `load`.
+   If the same Model is currently being loaded on another Thread, this waits for that load instead
+   of loading it again. Errors thrown by `load` are rethrown to all waiting callers.
+   */
+  std::shared_ptr<TfLiteModel> getOrLoad(const std::string& key, const LoadFunc& load);
+
+private:
+  void removeExpiredModels();
+
+private:
+  std::mutex _mutex;
+  std::unordered_map<std::string, std::weak_ptr<TfLiteModel>> _models;
+  std::unordered_map<std::string, std::shared_future<std::shared_ptr<TfLiteModel>>> _pendingLoads;
+};
@@ -0,0 +1,24 @@
+#include "Pipeline.h"
+
+#include <optional>
+#include <utility>
+
+InterpreterPool::Lease Pipeline::acquire(uint64_t sequence, InterpreterPool& pool) {
+  std::optional<InterpreterPool::Lease> lease;
+  _acquireSequencer.run(sequence, [&]() { lease.emplace(pool.acquire()); });
+  return std::move(*lease);
+}
+
+void Pipeline::invoke(uint64_t sequence, const std::function<void()>& func) {
+  _invokeSequencer.run(sequence, func);
+}
+
+void Pipeline::finish(uint64_t sequence, const std::function<void()>& func) {
+  _resultSequencer.run(sequence, func);
+}
+
+void Pipeline::skip(uint64_t sequence) {
+  _acquireSequencer.skip(sequence);
+  _invokeSequencer.skip(sequence);
+  _resultSequencer.skip(sequence);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "InterpreterPool.h"
+#include "Sequencer.h"
+#include <cstdint>
+#include <functional>
+
+/**
+ The stages of pipelined async runs. Every run has a sequence number (starting at 0) and passes
+ all stages in that order: It acquires an Interpreter, copies its inputs, invokes it and copies
+ its outputs while other runs are in other stages, and hands its result over.
+ Every sequence number has to pass every stage exactly once, otherwise all later runs wait forever.
+ */
+class Pipeline {
+public:
+  /**
+   Acquires an Interpreter for an async run, after all runs with a lower sequence number acquired
+   theirs. A run that waits for its turn to invoke always holds an Interpreter, so earlier runs
+   can't starve even if fewer Interpreters than worker Threads are usable.
+   */
+  InterpreterPool::Lease acquire(uint64_t sequence, InterpreterPool& pool);
+  /**
+   Calls `func` after all runs with a lower sequence number invoked their Interpreter.
+   */
+  void invoke(uint64_t sequence, const std::function<void()>& func);
+  /**
+   Calls `func` after all runs with a lower sequence number handed over their result.
+   */
+  void finish(uint64_t sequence, const std::function<void()>& func);
+  /**
+   Lets a run that will never start pass all stages, so later runs don't wait for it.
+   */
+  void skip(uint64_t sequence);
+
+private:
+  Sequencer _acquireSequencer;
+  Sequencer _invokeSequencer;
+  Sequencer _resultSequencer;
+};
@@ -0,0 +1,102 @@
+#include "Postprocessing.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+template <typename T> float dequantize(T value, float scale, int32_t zeroPoint) {
+  if constexpr (std::is_same_v<T, float>) {
+    return value;
+  } else {
+    return static_cast<float>(static_cast<int32_t>(value) - zeroPoint) * scale;
+  }
+}
+
+/**
+ The softmax denominator, `sum(exp(score - maximum))` over all scores.
+ */
+template <typename T>
+float sumExponentials(const T* values, size_t count, float scale, int32_t zeroPoint,
+                      float maximum) {
+  float sum = 0;
+  if constexpr (sizeof(T) == 1) {
+    // 8-bit scores only have 256 possible values, so every exp() is only computed once.
+    std::array<size_t, 256> histogram{};
+    for (size_t i = 0; i < count; i++) {
+      histogram[static_cast<uint8_t>(values[i])]++;
+    }
+    for (size_t bin = 0; bin < histogram.size(); bin++) {
+      if (histogram[bin] > 0) {
+        T value = static_cast<T>(static_cast<uint8_t>(bin));
+        sum += histogram[bin] * std::exp(dequantize(value, scale, zeroPoint) - maximum);
+      }
+    }
+  } else {
+    for (size_t i = 0; i < count; i++) {
+      sum += std::exp(dequantize(values[i], scale, zeroPoint) - maximum);
+    }
+  }
+  return sum;
+}
+
+template <typename T>
+size_t topK(const T* values, size_t count, size_t k, bool softmax, float scale, int32_t zeroPoint,
+            float* output) {
+  k = std::min(k, count);
+  if (k == 0) {
+    return 0;
+  }
+
+  // A heap of the best `k` scores so far, with the worst of them at the front. For quantized
+  // scores, the raw values have the same order as the real values (the scale is positive).
+  using Entry = std::pair<T, size_t>;
+  auto isBetter = [](const Entry& left, const Entry& right) {
+    return left.first > right.first || (left.first == right.first && left.second < right.second);
+  };
+  std::vector<Entry> heap;
+  heap.reserve(k);
+  for (size_t i = 0; i < count; i++) {
+    if (heap.size() < k) {
+      heap.emplace_back(values[i], i);
+      std::push_heap(heap.begin(), heap.end(), isBetter);
+    } else if (values[i] > heap.front().first) {
+      std::pop_heap(heap.begin(), heap.end(), isBetter);
+      heap.back() = Entry(values[i], i);
+      std::push_heap(heap.begin(), heap.end(), isBetter);
+    }
+  }
+  // Best score first
+  std::sort_heap(heap.begin(), heap.end(), isBetter);
+
+  float maximum = dequantize(heap.front().first, scale, zeroPoint);
+  float sum = softmax ? sumExponentials(values, count, scale, zeroPoint, maximum) : 1.0f;
+  for (size_t i = 0; i < k; i++) {
+    float score = dequantize(heap[i].first, scale, zeroPoint);
+    output[i * 2] = static_cast<float>(heap[i].second);
+    output[i * 2 + 1] = softmax ? std::exp(score - maximum) / sum : score;
+  }
+  return k;
+}
+
+} // namespace
+
+size_t Postprocessing::topK(const float* scores, size_t count, size_t k, bool softmax,
+                            float* output) {
+  return ::topK(scores, count, k, softmax, 1.0f, 0, output);
+}
+
+size_t Postprocessing::topK(const int8_t* scores, size_t count, size_t k, bool softmax,
+                            float scale, int32_t zeroPoint, float* output) {
+  return ::topK(scores, count, k, softmax, scale, zeroPoint, output);
+}
+
+size_t Postprocessing::topK(const uint8_t* scores, size_t count, size_t k, bool softmax,
+                            float scale, int32_t zeroPoint, float* output) {
+  return ::topK(scores, count, k, softmax, scale, zeroPoint, output);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ Post-processing that is applied to an output tensor right after the Model ran, so only the
+ (much smaller) result has to be copied to JS.
+ */
+struct OutputPostprocessing {
+  // The amount of highest scores to return for every row (the last dimension) of the tensor.
+  // 1 is an argmax.
+  size_t topK = 1;
+  // If true, the returned scores are softmax probabilities of the whole row instead of raw logits.
+  bool softmax = false;
+};
+
+/**
+ Classification post-processing kernels.
+ These don't depend on JSI or TFLite, so they can be benchmarked on any host.
+ */
+class Postprocessing {
+public:
+  /**
+   Finds the `k` highest of `count` scores and writes them into `output` as `(index, score)`
+   pairs, sorted by descending score. Quantized scores are dequantized as
+   `scale * (value - zeroPoint)`. `output` needs space for `2 * min(k, count)` values, the amount
+   of pairs is returned.
+   */
+  static size_t topK(const float* scores, size_t count, size_t k, bool softmax, float* output);
+  static size_t topK(const int8_t* scores, size_t count, size_t k, bool softmax, float scale,
+                     int32_t zeroPoint, float* output);
+  static size_t topK(const uint8_t* scores, size_t count, size_t k, bool softmax, float scale,
+                     int32_t zeroPoint, float* output);
+};
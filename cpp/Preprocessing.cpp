@@ -0,0 +1,338 @@
+#include "Preprocessing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// The interleaved SIMD kernel repeats its per-channel constants every 12 values (3 vectors of 4),
+// so it works for every channel count that divides 12.
+constexpr size_t kPatternLength = 12;
+
+template <typename T> T saturate(float value);
+template <> float saturate<float>(float value) {
+  return value;
+}
+template <> int8_t saturate<int8_t>(float value) {
+  return static_cast<int8_t>(std::clamp(std::lrintf(value), -128l, 127l));
+}
+template <> uint8_t saturate<uint8_t>(float value) {
+  return static_cast<uint8_t>(std::clamp(std::lrintf(value), 0l, 255l));
+}
+
+size_t getSourceChannel(const PixelTransform& transform, size_t channel) {
+  return transform.swapRedBlue && channel < 3 ? 2 - channel : channel;
+}
+
+size_t getPlaneStride(const PixelTransform& transform, size_t pixelCount) {
+  return transform.planeStride != 0 ? transform.planeStride : pixelCount;
+}
+
+template <typename T>
+void transformPixelsScalar(const uint8_t* input, T* output, size_t startPixel, size_t pixelCount,
+                           const PixelTransform& transform) {
+  size_t channels = transform.channels;
+  size_t planeStride = getPlaneStride(transform, pixelCount);
+  for (size_t pixel = startPixel; pixel < pixelCount; pixel++) {
+    for (size_t channel = 0; channel < channels; channel++) {
+      float value = input[pixel * channels + getSourceChannel(transform, channel)];
+      value = value * transform.scale[channel] + transform.bias[channel];
+      size_t target = transform.toNCHW ? channel * planeStride + pixel : pixel * channels + channel;
+      output[target] = saturate<T>(value);
+    }
+  }
+}
+
+#if defined(__ARM_NEON)
+
+void widen(uint8x16_t bytes, float32x4_t result[4]) {
+  uint16x8_t low = vmovl_u8(vget_low_u8(bytes));
+  uint16x8_t high = vmovl_u8(vget_high_u8(bytes));
+  result[0] = vcvtq_f32_u32(vmovl_u16(vget_low_u16(low)));
+  result[1] = vcvtq_f32_u32(vmovl_u16(vget_high_u16(low)));
+  result[2] = vcvtq_f32_u32(vmovl_u16(vget_low_u16(high)));
+  result[3] = vcvtq_f32_u32(vmovl_u16(vget_high_u16(high)));
+}
+
+void widen(const uint8_t* input, float32x4_t result[4]) {
+  widen(vld1q_u8(input), result);
+}
+
+/**
+ Interleaved RGB input with swapped channels and/or NCHW output, 16 pixels at a time.
+ Returns the amount of pixels that were transformed.
+ */
+size_t transformRGBFloat(const uint8_t* input, float* output, size_t pixelCount,
+                         const PixelTransform& transform) {
+  float32x4_t scale[3];
+  float32x4_t bias[3];
+  for (size_t channel = 0; channel < 3; channel++) {
+    scale[channel] = vdupq_n_f32(transform.scale[channel]);
+    bias[channel] = vdupq_n_f32(transform.bias[channel]);
+  }
+
+  size_t planeStride = getPlaneStride(transform, pixelCount);
+  size_t pixel = 0;
+  for (; pixel + 16 <= pixelCount; pixel += 16) {
+    uint8x16x3_t rgb = vld3q_u8(input + pixel * 3);
+    float32x4_t values[3][4];
+    for (size_t channel = 0; channel < 3; channel++) {
+      widen(rgb.val[getSourceChannel(transform, channel)], values[channel]);
+      for (size_t i = 0; i < 4; i++) {
+        values[channel][i] = vmlaq_f32(bias[channel], values[channel][i], scale[channel]);
+      }
+    }
+
+    for (size_t i = 0; i < 4; i++) {
+      if (transform.toNCHW) {
+        for (size_t channel = 0; channel < 3; channel++) {
+          vst1q_f32(output + channel * planeStride + pixel + i * 4, values[channel][i]);
+        }
+      } else {
+        float32x4x3_t interleaved = {{values[0][i], values[1][i], values[2][i]}};
+        vst3q_f32(output + (pixel + i * 4) * 3, interleaved);
+      }
+    }
+  }
+  return pixel;
+}
+
+#elif defined(__SSE2__)
+
+void widen(const uint8_t* input, __m128 result[4]) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+  __m128i low = _mm_unpacklo_epi8(bytes, zero);
+  __m128i high = _mm_unpackhi_epi8(bytes, zero);
+  result[0] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero));
+  result[1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero));
+  result[2] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero));
+  result[3] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero));
+}
+
+#endif
+
+#if defined(__ARM_NEON) || defined(__SSE2__)
+
+#if defined(__ARM_NEON)
+using Vector = float32x4_t;
+
+Vector loadVector(const float* input) {
+  return vld1q_f32(input);
+}
+Vector multiplyAdd(Vector value, Vector scale, Vector bias) {
+  return vmlaq_f32(bias, value, scale);
+}
+#else
+using Vector = __m128;
+
+Vector loadVector(const float* input) {
+  return _mm_loadu_ps(input);
+}
+Vector multiplyAdd(Vector value, Vector scale, Vector bias) {
+  return _mm_add_ps(_mm_mul_ps(value, scale), bias);
+}
+#endif
+
+// Whether `storeValues` can store T. Rounding to the nearest integer (like `lrintf`) needs ARMv8,
+// so ARMv7 only stores floats.
+#if defined(__ARM_NEON) && !defined(__aarch64__)
+template <typename T> constexpr bool kCanStoreValues = std::is_same_v<T, float>;
+#else
+template <typename T>
+constexpr bool kCanStoreValues =
+    std::is_same_v<T, float> || std::is_same_v<T, int8_t> || std::is_same_v<T, uint8_t>;
+#endif
+
+/**
+ Stores 16 values, integers are rounded to the nearest integer and saturated like `saturate<T>`.
+ */
+void storeValues(float* output, const Vector values[4]) {
+  for (size_t i = 0; i < 4; i++) {
+#if defined(__ARM_NEON)
+    vst1q_f32(output + i * 4, values[i]);
+#else
+    _mm_storeu_ps(output + i * 4, values[i]);
+#endif
+  }
+}
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+
+int16x8_t roundToInt16(Vector low, Vector high) {
+  return vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(low)), vqmovn_s32(vcvtnq_s32_f32(high)));
+}
+void storeValues(int8_t* output, const Vector values[4]) {
+  int16x8_t low = roundToInt16(values[0], values[1]);
+  int16x8_t high = roundToInt16(values[2], values[3]);
+  vst1q_s8(output, vcombine_s8(vqmovn_s16(low), vqmovn_s16(high)));
+}
+void storeValues(uint8_t* output, const Vector values[4]) {
+  int16x8_t low = roundToInt16(values[0], values[1]);
+  int16x8_t high = roundToInt16(values[2], values[3]);
+  vst1q_u8(output, vcombine_u8(vqmovun_s16(low), vqmovun_s16(high)));
+}
+
+#elif defined(__SSE2__)
+
+__m128i roundToInt16(Vector low, Vector high) {
+  return _mm_packs_epi32(_mm_cvtps_epi32(low), _mm_cvtps_epi32(high));
+}
+void storeValues(int8_t* output, const Vector values[4]) {
+  __m128i low = roundToInt16(values[0], values[1]);
+  __m128i high = roundToInt16(values[2], values[3]);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_packs_epi16(low, high));
+}
+void storeValues(uint8_t* output, const Vector values[4]) {
+  __m128i low = roundToInt16(values[0], values[1]);
+  __m128i high = roundToInt16(values[2], values[3]);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_packus_epi16(low, high));
+}
+
+#endif
+
+/**
+ Interleaved input and output without channel reordering, 48 values (4 patterns) at a time.
+ Returns the amount of values that were transformed.
+ */
+template <typename T>
+size_t transformInterleaved(const uint8_t* input, T* output, size_t count,
+                            const float* scalePattern, const float* biasPattern) {
+  Vector scale[3];
+  Vector bias[3];
+  for (size_t i = 0; i < 3; i++) {
+    scale[i] = loadVector(scalePattern + i * 4);
+    bias[i] = loadVector(biasPattern + i * 4);
+  }
+
+  size_t index = 0;
+  for (; index + kPatternLength * 4 <= count; index += kPatternLength * 4) {
+    for (size_t chunk = 0; chunk < 3; chunk++) {
+      Vector values[4];
+      widen(input + index + chunk * 16, values);
+      for (size_t i = 0; i < 4; i++) {
+        // Every chunk holds 4 vectors, the pattern repeats every 3 vectors.
+        size_t vector = chunk * 4 + i;
+        values[i] = multiplyAdd(values[i], scale[vector % 3], bias[vector % 3]);
+      }
+      storeValues(output + index + chunk * 16, values);
+    }
+  }
+  return index;
+}
+
+#endif
+
+/**
+ Transforms as many pixels as possible with SIMD, returns the amount of pixels that were
+ transformed.
+ */
+template <typename T>
+size_t transformPixelsSimd(const uint8_t* input, T* output, size_t pixelCount,
+                           const PixelTransform& transform) {
+#if defined(__ARM_NEON) || defined(__SSE2__)
+  if constexpr (kCanStoreValues<T>) {
+    size_t channels = transform.channels;
+    if (!transform.swapRedBlue && !transform.toNCHW && kPatternLength % channels == 0) {
+      float scalePattern[kPatternLength];
+      float biasPattern[kPatternLength];
+      for (size_t i = 0; i < kPatternLength; i++) {
+        scalePattern[i] = transform.scale[i % channels];
+        biasPattern[i] = transform.bias[i % channels];
+      }
+      size_t count = transformInterleaved(input, output, pixelCount * channels, scalePattern,
+                                          biasPattern);
+      return count / channels;
+    }
+  }
+#endif
+#if defined(__ARM_NEON)
+  if constexpr (std::is_same_v<T, float>) {
+    if (transform.channels == 3) {
+      return transformRGBFloat(input, output, pixelCount, transform);
+    }
+  }
+#endif
+  return 0;
+}
+
+template <typename T>
+void transformPixels(const uint8_t* input, T* output, size_t pixelCount,
+                     const PixelTransform& transform) {
+  size_t startPixel = transformPixelsSimd(input, output, pixelCount, transform);
+  // The remaining pixels, and the layouts that have no SIMD kernel
+  transformPixelsScalar(input, output, startPixel, pixelCount, transform);
+}
+
+float getChannelValue(const std::vector<float>& values, size_t channel, float defaultValue) {
+  if (values.empty()) {
+    return defaultValue;
+  }
+  return values.size() == 1 ? values[0] : values[channel];
+}
+
+} // namespace
+
+PixelTransform Preprocessing::createTransform(const InputPreprocessing& preprocessing,
+                                              size_t channels, float quantizationScale,
+                                              int32_t zeroPoint) {
+  if (channels == 0) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Input tensor has no channels to preprocess!");
+  }
+  for (const auto* values : {&preprocessing.mean, &preprocessing.std}) {
+    if (values->size() > 1 && values->size() != channels) {
+      [[unlikely]];
+      throw std::runtime_error("TFLite: Expected 1 or " + std::to_string(channels) +
+                               " mean/std values, but received " +
+                               std::to_string(values->size()) + "!");
+    }
+  }
+  if (preprocessing.swapRedBlue && channels < 3) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Cannot swap red and blue of an input with " +
+                             std::to_string(channels) + " channels!");
+  }
+
+  PixelTransform transform;
+  transform.channels = channels;
+  transform.swapRedBlue = preprocessing.swapRedBlue;
+  transform.toNCHW = preprocessing.toNCHW;
+  for (size_t channel = 0; channel < channels; channel++) {
+    float mean = getChannelValue(preprocessing.mean, channel, 0.0f);
+    float std = getChannelValue(preprocessing.std, channel, 1.0f);
+    if (std == 0.0f) {
+      [[unlikely]];
+      throw std::runtime_error("TFLite: std must not be 0!");
+    }
+    // ((value - mean) / std) / quantizationScale + zeroPoint
+    float scale = 1.0f / (std * quantizationScale);
+    transform.scale.push_back(scale);
+    transform.bias.push_back(-mean * scale + static_cast<float>(zeroPoint));
+  }
+  return transform;
+}
+
+void Preprocessing::transformPixels(const uint8_t* input, float* output, size_t pixelCount,
+                                    const PixelTransform& transform) {
+  ::transformPixels(input, output, pixelCount, transform);
+}
+
+void Preprocessing::transformPixels(const uint8_t* input, int8_t* output, size_t pixelCount,
+                                    const PixelTransform& transform) {
+  ::transformPixels(input, output, pixelCount, transform);
+}
+
+void Preprocessing::transformPixels(const uint8_t* input, uint8_t* output, size_t pixelCount,
+                                    const PixelTransform& transform) {
+  ::transformPixels(input, output, pixelCount, transform);
+}
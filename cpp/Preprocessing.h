@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ Preprocessing that is applied to an 8-bit (e.g. RGB) input buffer while it is written into the
+ input tensor.
+ */
+struct InputPreprocessing {
+  // Per-channel mean and standard deviation, applied as `(value - mean) / std`. A single value is
+  // used for all channels.
+  std::vector<float> mean;
+  std::vector<float> std;
+  // Reverses the order of the first three channels (RGB <-> BGR).
+  bool swapRedBlue = false;
+  // Transposes the interleaved (NHWC) input into a planar (NCHW) tensor.
+  bool toNCHW = false;
+};
+
+/**
+ The per-pixel work of an InputPreprocessing, resolved for a specific tensor.
+ Every output value is `input * scale[c] + bias[c]`, where `c` is the output channel.
+ */
+struct PixelTransform {
+  size_t channels;
+  std::vector<float> scale;
+  std::vector<float> bias;
+  bool swapRedBlue = false;
+  bool toNCHW = false;
+  // In NCHW mode, the distance between two planes in values. 0 uses the amount of pixels that are
+  // transformed at once, so a whole image is transformed in one call.
+  size_t planeStride = 0;
+};
+
+/**
+ Kernels that convert interleaved 8-bit pixels straight into tensor memory. These don't depend on
+ JSI or TFLite, so they can be benchmarked and tested on any host.
+
+ Interleaved (NHWC) outputs without swapped channels are vectorized with NEON and SSE2, integer
+ outputs only on ARMv8 and x86. Swapped channels and NCHW outputs of RGB pixels are only
+ vectorized for float outputs with NEON, everything else runs a scalar loop.
+ */
+class Preprocessing {
+public:
+  /**
+   Create a PixelTransform for the given preprocessing and channel count. Integer outputs are
+   quantized as `round(value / quantizationScale) + zeroPoint`, float outputs use a scale of 1 and
+   a zero point of 0.
+   */
+  static PixelTransform createTransform(const InputPreprocessing& preprocessing, size_t channels,
+                                        float quantizationScale = 1.0f, int32_t zeroPoint = 0);
+
+  /**
+   Transforms `pixelCount` interleaved pixels of `transform.channels` bytes each.
+   In NCHW mode, `output` points into the first plane and the planes are `transform.planeStride`
+   (or `pixelCount`) values apart.
+   */
+  static void transformPixels(const uint8_t* input, float* output, size_t pixelCount,
+                              const PixelTransform& transform);
+  static void transformPixels(const uint8_t* input, int8_t* output, size_t pixelCount,
+                              const PixelTransform& transform);
+  static void transformPixels(const uint8_t* input, uint8_t* output, size_t pixelCount,
+                              const PixelTransform& transform);
+};
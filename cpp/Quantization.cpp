@@ -0,0 +1,263 @@
+#include "Quantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Rounding to nearest (`vcvtnq_s32_f32`) is only available on ARMv8, older ARM CPUs use the
+// scalar loops.
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Every SIMD iteration converts 16 values, so one 128-bit register of 8-bit values.
+constexpr size_t kBlockSize = 16;
+
+template <typename Q> Q saturate(long value) {
+  return static_cast<Q>(std::clamp(value, static_cast<long>(std::numeric_limits<Q>::min()),
+                                   static_cast<long>(std::numeric_limits<Q>::max())));
+}
+
+#if defined(__aarch64__)
+
+void widen(const int8_t* input, int32x4_t result[4]) {
+  int8x16_t bytes = vld1q_s8(input);
+  int16x8_t low = vmovl_s8(vget_low_s8(bytes));
+  int16x8_t high = vmovl_s8(vget_high_s8(bytes));
+  result[0] = vmovl_s16(vget_low_s16(low));
+  result[1] = vmovl_s16(vget_high_s16(low));
+  result[2] = vmovl_s16(vget_low_s16(high));
+  result[3] = vmovl_s16(vget_high_s16(high));
+}
+
+void widen(const uint8_t* input, int32x4_t result[4]) {
+  uint8x16_t bytes = vld1q_u8(input);
+  int16x8_t low = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(bytes)));
+  int16x8_t high = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(bytes)));
+  result[0] = vmovl_s16(vget_low_s16(low));
+  result[1] = vmovl_s16(vget_high_s16(low));
+  result[2] = vmovl_s16(vget_low_s16(high));
+  result[3] = vmovl_s16(vget_high_s16(high));
+}
+
+void narrow(const int32x4_t values[4], int8_t* output) {
+  int16x8_t low = vcombine_s16(vqmovn_s32(values[0]), vqmovn_s32(values[1]));
+  int16x8_t high = vcombine_s16(vqmovn_s32(values[2]), vqmovn_s32(values[3]));
+  vst1q_s8(output, vcombine_s8(vqmovn_s16(low), vqmovn_s16(high)));
+}
+
+void narrow(const int32x4_t values[4], uint8_t* output) {
+  int16x8_t low = vcombine_s16(vqmovn_s32(values[0]), vqmovn_s32(values[1]));
+  int16x8_t high = vcombine_s16(vqmovn_s32(values[2]), vqmovn_s32(values[3]));
+  vst1q_u8(output, vcombine_u8(vqmovun_s16(low), vqmovun_s16(high)));
+}
+
+template <typename Q>
+size_t quantizeBlocks(const float* input, Q* output, size_t count, float scale,
+                      int32_t zeroPoint) {
+  float32x4_t inverseScale = vdupq_n_f32(1.0f / scale);
+  // Out-of-range floats would convert to INT_MAX and overflow when adding the zero point, so they
+  // are clamped to a range that still saturates correctly when narrowing.
+  float32x4_t minimum = vdupq_n_f32(-65536.0f);
+  float32x4_t maximum = vdupq_n_f32(65536.0f);
+  int32x4_t zero = vdupq_n_s32(zeroPoint);
+  size_t index = 0;
+  for (; index + kBlockSize <= count; index += kBlockSize) {
+    int32x4_t values[4];
+    for (size_t i = 0; i < 4; i++) {
+      float32x4_t scaled = vmulq_f32(vld1q_f32(input + index + i * 4), inverseScale);
+      scaled = vminq_f32(vmaxq_f32(scaled, minimum), maximum);
+      values[i] = vaddq_s32(vcvtnq_s32_f32(scaled), zero);
+    }
+    narrow(values, output + index);
+  }
+  return index;
+}
+
+template <typename Q>
+size_t dequantizeBlocks(const Q* input, float* output, size_t count, float scale,
+                        int32_t zeroPoint) {
+  int32x4_t zero = vdupq_n_s32(zeroPoint);
+  size_t index = 0;
+  for (; index + kBlockSize <= count; index += kBlockSize) {
+    int32x4_t values[4];
+    widen(input + index, values);
+    for (size_t i = 0; i < 4; i++) {
+      float32x4_t real = vcvtq_f32_s32(vsubq_s32(values[i], zero));
+      vst1q_f32(output + index + i * 4, vmulq_n_f32(real, scale));
+    }
+  }
+  return index;
+}
+
+#elif defined(__SSE2__)
+
+void widen(const int8_t* input, __m128i result[4]) {
+  __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+  // Interleaving a value with itself and shifting it back down sign-extends it.
+  __m128i low = _mm_srai_epi16(_mm_unpacklo_epi8(bytes, bytes), 8);
+  __m128i high = _mm_srai_epi16(_mm_unpackhi_epi8(bytes, bytes), 8);
+  result[0] = _mm_srai_epi32(_mm_unpacklo_epi16(low, low), 16);
+  result[1] = _mm_srai_epi32(_mm_unpackhi_epi16(low, low), 16);
+  result[2] = _mm_srai_epi32(_mm_unpacklo_epi16(high, high), 16);
+  result[3] = _mm_srai_epi32(_mm_unpackhi_epi16(high, high), 16);
+}
+
+void widen(const uint8_t* input, __m128i result[4]) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input));
+  __m128i low = _mm_unpacklo_epi8(bytes, zero);
+  __m128i high = _mm_unpackhi_epi8(bytes, zero);
+  result[0] = _mm_unpacklo_epi16(low, zero);
+  result[1] = _mm_unpackhi_epi16(low, zero);
+  result[2] = _mm_unpacklo_epi16(high, zero);
+  result[3] = _mm_unpackhi_epi16(high, zero);
+}
+
+void narrow(const __m128i values[4], int8_t* output) {
+  __m128i low = _mm_packs_epi32(values[0], values[1]);
+  __m128i high = _mm_packs_epi32(values[2], values[3]);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_packs_epi16(low, high));
+}
+
+void narrow(const __m128i values[4], uint8_t* output) {
+  __m128i low = _mm_packs_epi32(values[0], values[1]);
+  __m128i high = _mm_packs_epi32(values[2], values[3]);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_packus_epi16(low, high));
+}
+
+template <typename Q>
+size_t quantizeBlocks(const float* input, Q* output, size_t count, float scale,
+                      int32_t zeroPoint) {
+  __m128 inverseScale = _mm_set1_ps(1.0f / scale);
+  // Out-of-range floats would convert to INT_MIN, so they are clamped to a range that still
+  // saturates correctly when packing.
+  __m128 minimum = _mm_set1_ps(-65536.0f);
+  __m128 maximum = _mm_set1_ps(65536.0f);
+  __m128i zero = _mm_set1_epi32(zeroPoint);
+  size_t index = 0;
+  for (; index + kBlockSize <= count; index += kBlockSize) {
+    __m128i values[4];
+    for (size_t i = 0; i < 4; i++) {
+      __m128 scaled = _mm_mul_ps(_mm_loadu_ps(input + index + i * 4), inverseScale);
+      scaled = _mm_min_ps(_mm_max_ps(scaled, minimum), maximum);
+      values[i] = _mm_add_epi32(_mm_cvtps_epi32(scaled), zero);
+    }
+    narrow(values, output + index);
+  }
+  return index;
+}
+
+template <typename Q>
+size_t dequantizeBlocks(const Q* input, float* output, size_t count, float scale,
+                        int32_t zeroPoint) {
+  __m128 scales = _mm_set1_ps(scale);
+  __m128i zero = _mm_set1_epi32(zeroPoint);
+  size_t index = 0;
+  for (; index + kBlockSize <= count; index += kBlockSize) {
+    __m128i values[4];
+    widen(input + index, values);
+    for (size_t i = 0; i < 4; i++) {
+      __m128 real = _mm_cvtepi32_ps(_mm_sub_epi32(values[i], zero));
+      _mm_storeu_ps(output + index + i * 4, _mm_mul_ps(real, scales));
+    }
+  }
+  return index;
+}
+
+#else
+
+template <typename Q> size_t quantizeBlocks(const float*, Q*, size_t, float, int32_t) {
+  return 0;
+}
+
+template <typename Q> size_t dequantizeBlocks(const Q*, float*, size_t, float, int32_t) {
+  return 0;
+}
+
+#endif
+
+template <typename Q>
+void quantizeSpan(const float* input, Q* output, size_t count, float scale, int32_t zeroPoint) {
+  size_t index = quantizeBlocks(input, output, count, scale, zeroPoint);
+  float inverseScale = 1.0f / scale;
+  for (; index < count; index++) {
+    // Like in the SIMD path, values that are far out of range (or infinite) are clamped before
+    // rounding, `lrintf` is undefined for them.
+    float scaled = std::clamp(input[index] * inverseScale, -65536.0f, 65536.0f);
+    output[index] = saturate<Q>(std::lrintf(scaled) + zeroPoint);
+  }
+}
+
+template <typename Q>
+void dequantizeSpan(const Q* input, float* output, size_t count, float scale, int32_t zeroPoint) {
+  size_t index = dequantizeBlocks(input, output, count, scale, zeroPoint);
+  for (; index < count; index++) {
+    output[index] = static_cast<float>(input[index] - zeroPoint) * scale;
+  }
+}
+
+/**
+ Splits the values into spans that share the same channel and calls `func(index, count, scale,
+ zeroPoint)` for each of them.
+ */
+template <typename Func>
+void forEachSpan(size_t count, size_t offset, const QuantizationParams& params, Func&& func) {
+  size_t channels = params.scales.size();
+  if (channels == 1) {
+    func(0, count, params.scales[0], params.zeroPoints[0]);
+    return;
+  }
+
+  size_t innerSize = std::max(params.innerSize, static_cast<size_t>(1));
+  size_t index = 0;
+  while (index < count) {
+    size_t element = offset + index;
+    size_t channel = (element / innerSize) % channels;
+    size_t spanLength = std::min(innerSize - element % innerSize, count - index);
+    func(index, spanLength, params.scales[channel], params.zeroPoints[channel]);
+    index += spanLength;
+  }
+}
+
+template <typename Q>
+void quantize(const float* input, Q* output, size_t count, size_t offset,
+              const QuantizationParams& params) {
+  forEachSpan(count, offset, params, [&](size_t index, size_t length, float scale, int32_t zero) {
+    quantizeSpan(input + index, output + index, length, scale, zero);
+  });
+}
+
+template <typename Q>
+void dequantize(const Q* input, float* output, size_t count, size_t offset,
+                const QuantizationParams& params) {
+  forEachSpan(count, offset, params, [&](size_t index, size_t length, float scale, int32_t zero) {
+    dequantizeSpan(input + index, output + index, length, scale, zero);
+  });
+}
+
+} // namespace
+
+void Quantization::quantize(const float* input, int8_t* output, size_t count, size_t offset,
+                            const QuantizationParams& params) {
+  ::quantize(input, output, count, offset, params);
+}
+
+void Quantization::quantize(const float* input, uint8_t* output, size_t count, size_t offset,
+                            const QuantizationParams& params) {
+  ::quantize(input, output, count, offset, params);
+}
+
+void Quantization::dequantize(const int8_t* input, float* output, size_t count, size_t offset,
+                              const QuantizationParams& params) {
+  ::dequantize(input, output, count, offset, params);
+}
+
+void Quantization::dequantize(const uint8_t* input, float* output, size_t count, size_t offset,
+                              const QuantizationParams& params) {
+  ::dequantize(input, output, count, offset, params);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ Affine quantization parameters of a tensor, `real = scale * (quantized - zeroPoint)`.
+ */
+struct QuantizationParams {
+  // One value for per-tensor quantization, or one value per channel for per-channel quantization.
+  std::vector<float> scales;
+  std::vector<int32_t> zeroPoints;
+  // The amount of consecutive values that share the same channel, i.e. the product of all
+  // dimensions after the quantized dimension.
+  size_t innerSize = 1;
+};
+
+/**
+ Vectorized (NEON/SSE2) kernels that convert between float values and quantized tensor memory.
+ These don't depend on JSI or TFLite, so they can be benchmarked on any host.
+
+ `offset` is the index of the first value within the tensor, which selects the channel of every
+ value for per-channel quantization.
+ */
+class Quantization {
+public:
+  static void quantize(const float* input, int8_t* output, size_t count, size_t offset,
+                       const QuantizationParams& params);
+  static void quantize(const float* input, uint8_t* output, size_t count, size_t offset,
+                       const QuantizationParams& params);
+
+  static void dequantize(const int8_t* input, float* output, size_t count, size_t offset,
+                         const QuantizationParams& params);
+  static void dequantize(const uint8_t* input, float* output, size_t count, size_t offset,
+                         const QuantizationParams& params);
+};
@@ -0,0 +1,37 @@
+#include "Sequencer.h"
+
+void Sequencer::run(uint64_t sequence, const std::function<void()>& func) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _condition.wait(lock, [&]() { return _next == sequence; });
+  lock.unlock();
+
+  try {
+    func();
+  } catch (...) {
+    pass();
+    throw;
+  }
+  pass();
+}
+
+void Sequencer::skip(uint64_t sequence) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _skipped.insert(sequence);
+  passSkipped();
+  lock.unlock();
+  _condition.notify_all();
+}
+
+void Sequencer::pass() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _next++;
+  passSkipped();
+  lock.unlock();
+  _condition.notify_all();
+}
+
+void Sequencer::passSkipped() {
+  while (_skipped.erase(_next) > 0) {
+    _next++;
+  }
+}
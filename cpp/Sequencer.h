@@ -0,0 +1,37 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+
+/**
+ Lets jobs running on multiple Threads pass a section one after another, in the order of their
+ sequence numbers (starting at 0). Every sequence number has to pass exactly once, otherwise all
+ later jobs wait forever.
+ */
+class Sequencer {
+public:
+  /**
+   Waits until all jobs with a lower sequence number passed, then calls `func`.
+   The next job may pass once `func` returns or throws.
+   */
+  void run(uint64_t sequence, const std::function<void()>& func);
+  /**
+   Lets the job with the given sequence number pass without calling anything, and without waiting
+   for its turn. Use this for jobs that got a sequence number but will never run.
+   */
+  void skip(uint64_t sequence);
+
+private:
+  void pass();
+  // Moves `_next` past all skipped sequence numbers. `_mutex` must be held.
+  void passSkipped();
+
+private:
+  uint64_t _next = 0;
+  std::unordered_set<uint64_t> _skipped;
+  std::mutex _mutex;
+  std::condition_variable _condition;
+};
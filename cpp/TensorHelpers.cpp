@@ -7,8 +7,10 @@
 //
 
 #include "TensorHelpers.h"
+#include <algorithm>
+#include <cstring>
 
-#ifdef ANDROID
+#if defined(ANDROID) || defined(FAST_TFLITE_HOST)
 #include <tflite/c/c_api.h>
 #else
 #include <TensorFlowLiteC/TensorFlowLiteC.h>
@@ -21,6 +23,8 @@ typedef double float64_t;
 
 std::string dataTypeToString(TfLiteType dataType) {
   switch (dataType) {
+    case kTfLiteFloat16:
+      return "float16";
     case kTfLiteFloat32:
       return "float32";
     case kTfLiteFloat64:
@@ -112,6 +116,9 @@ size_t TensorHelpers::getTFLTensorDataTypeSize(TfLiteType dataType) {
       return sizeof(uint32_t);
     case kTfLiteUInt16:
       return sizeof(uint16_t);
+    case kTfLiteFloat16:
+      // Half-precision floats are stored as raw 16-bit values
+      return sizeof(uint16_t);
     default:
       [[unlikely]];
       throw std::runtime_error("TFLite: Unsupported output data type! " +
@@ -127,38 +134,36 @@ int getTensorTotalLength(const TfLiteTensor* tensor) {
   }
 
   int size = 1;
-  for (size_t i = 0; i < dimensions; i++) {
+  for (int i = 0; i < dimensions; i++) {
     size *= TfLiteTensorDim(tensor, i);
   }
   return size;
 }
 
-TypedArrayBase TensorHelpers::createJSBufferForTensor(jsi::Runtime& runtime,
-                                                      const TfLiteTensor* tensor) {
-  int size = getTensorTotalLength(tensor);
-
-  auto dataType = TfLiteTensorType(tensor);
+TypedArrayKind getTypedArrayKindForTFLDataType(TfLiteType dataType) {
   switch (dataType) {
     case kTfLiteFloat32:
-      return TypedArray<TypedArrayKind::Float32Array>(runtime, size);
+      return TypedArrayKind::Float32Array;
     case kTfLiteFloat64:
-      return TypedArray<TypedArrayKind::Float64Array>(runtime, size);
+      return TypedArrayKind::Float64Array;
     case kTfLiteInt8:
-      return TypedArray<TypedArrayKind::Int8Array>(runtime, size);
+      return TypedArrayKind::Int8Array;
     case kTfLiteInt16:
-      return TypedArray<TypedArrayKind::Int16Array>(runtime, size);
+      return TypedArrayKind::Int16Array;
     case kTfLiteInt32:
-      return TypedArray<TypedArrayKind::Int32Array>(runtime, size);
+      return TypedArrayKind::Int32Array;
     case kTfLiteUInt8:
-      return TypedArray<TypedArrayKind::Uint8Array>(runtime, size);
+      return TypedArrayKind::Uint8Array;
     case kTfLiteUInt16:
-      return TypedArray<TypedArrayKind::Uint16Array>(runtime, size);
+    case kTfLiteFloat16:
+      // There is no Float16Array in JS (yet), so float16 values are exposed as raw bits.
+      return TypedArrayKind::Uint16Array;
     case kTfLiteUInt32:
-      return TypedArray<TypedArrayKind::Uint32Array>(runtime, size);
+      return TypedArrayKind::Uint32Array;
     case kTfLiteInt64:
-      return TypedArray<TypedArrayKind::BigInt64Array>(runtime, size);
+      return TypedArrayKind::BigInt64Array;
     case kTfLiteUInt64:
-      return TypedArray<TypedArrayKind::BigUint64Array>(runtime, size);
+      return TypedArrayKind::BigUint64Array;
     default:
       [[unlikely]];
       throw std::runtime_error("TFLite: Unsupported tensor data type! " +
@@ -166,6 +171,179 @@ TypedArrayBase TensorHelpers::createJSBufferForTensor(jsi::Runtime& runtime,
   }
 }
 
+/**
+ A jsi::MutableBuffer that points directly into a TFLTensor's memory.
+ The `owner` keeps the Interpreter (and therefore the Tensor memory) alive.
+ */
+class TensorMemoryBuffer : public jsi::MutableBuffer {
+public:
+  TensorMemoryBuffer(void* data, size_t size, std::shared_ptr<void> owner)
+      : _data(static_cast<uint8_t*>(data)), _size(size), _owner(std::move(owner)) {}
+
+  size_t size() const override {
+    return _size;
+  }
+  uint8_t* data() override {
+    return _data;
+  }
+
+private:
+  uint8_t* _data;
+  size_t _size;
+  std::shared_ptr<void> _owner;
+};
+
+/**
+ A jsi::MutableBuffer that owns its memory, e.g. a copy of an output tensor made on another Thread.
+ */
+class OwningBuffer : public jsi::MutableBuffer {
+public:
+  explicit OwningBuffer(size_t size) : _data(size) {}
+
+  size_t size() const override {
+    return _data.size();
+  }
+  uint8_t* data() override {
+    return _data.data();
+  }
+
+private:
+  std::vector<uint8_t> _data;
+};
+
+TypedArrayBase TensorHelpers::createJSBufferForTensor(jsi::Runtime& runtime,
+                                                      const TfLiteTensor* tensor) {
+  int size = getTensorTotalLength(tensor);
+  TypedArrayKind kind = getTypedArrayKindForTFLDataType(TfLiteTensorType(tensor));
+  return TypedArrayBase(runtime, size, kind);
+}
+
+TypedArrayBase TensorHelpers::createJSBufferForTensor(jsi::Runtime& runtime,
+                                                      const TfLiteTensor* tensor,
+                                                      TfLiteType dataType) {
+  int size = getTensorTotalLength(tensor);
+  TypedArrayKind kind = getTypedArrayKindForTFLDataType(dataType);
+  return TypedArrayBase(runtime, size, kind);
+}
+
+std::optional<QuantizationParams>
+TensorHelpers::getQuantizationParams(const TfLiteTensor* tensor) {
+  TfLiteType dataType = TfLiteTensorType(tensor);
+  if (dataType != kTfLiteInt8 && dataType != kTfLiteUInt8) {
+    return std::nullopt;
+  }
+
+  QuantizationParams params;
+  const TfLiteQuantization& quantization = tensor->quantization;
+  if (quantization.type == kTfLiteAffineQuantization && quantization.params != nullptr) {
+    auto affine = static_cast<const TfLiteAffineQuantization*>(quantization.params);
+    if (affine->scale != nullptr && affine->scale->size > 1) {
+      // Per-channel quantization
+      int channels = affine->scale->size;
+      for (int i = 0; i < channels; i++) {
+        params.scales.push_back(affine->scale->data[i]);
+        bool hasZeroPoint = affine->zero_point != nullptr && affine->zero_point->size > i;
+        params.zeroPoints.push_back(hasZeroPoint ? affine->zero_point->data[i] : 0);
+      }
+      for (int i = affine->quantized_dimension + 1; i < TfLiteTensorNumDims(tensor); i++) {
+        params.innerSize *= TfLiteTensorDim(tensor, i);
+      }
+      return params;
+    }
+  }
+
+  TfLiteQuantizationParams perTensor = TfLiteTensorQuantizationParams(tensor);
+  if (perTensor.scale == 0) {
+    return std::nullopt;
+  }
+  params.scales.push_back(perTensor.scale);
+  params.zeroPoints.push_back(perTensor.zero_point);
+  return params;
+}
+
+bool TensorHelpers::canConvertToFloat32(const TfLiteTensor* tensor) {
+  return TfLiteTensorType(tensor) == kTfLiteFloat16 || getQuantizationParams(tensor).has_value();
+}
+
+/**
+ Converts `count` float16 or quantized values of the Tensor starting at `elementOffset` to float32.
+ */
+void convertTensorDataToFloat32(const TfLiteTensor* tensor, size_t elementOffset, size_t count,
+                                float* output) {
+  const void* data = TfLiteTensorData(tensor);
+  TfLiteType dataType = TfLiteTensorType(tensor);
+  if (dataType == kTfLiteFloat16) {
+    Float16::toFloat32(static_cast<const uint16_t*>(data) + elementOffset, output, count);
+    return;
+  }
+  auto quantization = TensorHelpers::getQuantizationParams(tensor);
+  if (!quantization.has_value()) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Tensor \"" + std::string(TfLiteTensorName(tensor)) +
+                             "\" has type " + dataTypeToString(dataType) +
+                             ", but only float16 and quantized tensors can be converted to "
+                             "float32!");
+  }
+  if (dataType == kTfLiteInt8) {
+    Quantization::dequantize(static_cast<const int8_t*>(data) + elementOffset, output, count,
+                             elementOffset, *quantization);
+  } else {
+    Quantization::dequantize(static_cast<const uint8_t*>(data) + elementOffset, output, count,
+                             elementOffset, *quantization);
+  }
+}
+
+/**
+ Converts `count` float32 values to float16 or quantizes them into the Tensor starting at
+ `elementOffset`.
+ */
+void convertFloat32ToTensorData(const float* input, TfLiteTensor* tensor, size_t elementOffset,
+                                size_t count) {
+  void* data = TfLiteTensorData(tensor);
+  TfLiteType dataType = TfLiteTensorType(tensor);
+  if (dataType == kTfLiteFloat16) {
+    Float16::fromFloat32(input, static_cast<uint16_t*>(data) + elementOffset, count);
+    return;
+  }
+  auto quantization = TensorHelpers::getQuantizationParams(tensor);
+  if (!quantization.has_value()) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Tensor \"" + std::string(TfLiteTensorName(tensor)) +
+                             "\" has type " + dataTypeToString(dataType) +
+                             ", but only float16 and quantized tensors can be converted from "
+                             "float32!");
+  }
+  if (dataType == kTfLiteInt8) {
+    Quantization::quantize(input, static_cast<int8_t*>(data) + elementOffset, count,
+                           elementOffset, *quantization);
+  } else {
+    Quantization::quantize(input, static_cast<uint8_t*>(data) + elementOffset, count,
+                           elementOffset, *quantization);
+  }
+}
+
+TypedArrayBase TensorHelpers::createJSBufferViewForTensor(jsi::Runtime& runtime,
+                                                          const TfLiteTensor* tensor,
+                                                          std::shared_ptr<void> owner) {
+  void* data = TfLiteTensorData(tensor);
+  if (data == nullptr) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Tensor \"" + std::string(TfLiteTensorName(tensor)) +
+                             "\" has not been allocated yet!");
+  }
+
+  auto memory =
+      std::make_shared<TensorMemoryBuffer>(data, TfLiteTensorByteSize(tensor), std::move(owner));
+  return createJSBufferForData(runtime, TfLiteTensorType(tensor), memory);
+}
+
+TypedArrayBase TensorHelpers::createJSBufferForData(jsi::Runtime& runtime, TfLiteType dataType,
+                                                    std::shared_ptr<jsi::MutableBuffer> data) {
+  TypedArrayKind kind = getTypedArrayKindForTFLDataType(dataType);
+  jsi::ArrayBuffer arrayBuffer(runtime, std::move(data));
+  return TypedArrayBase(runtime, arrayBuffer, kind);
+}
+
 void TensorHelpers::updateJSBufferFromTensor(jsi::Runtime& runtime, TypedArrayBase& jsBuffer,
                                              const TfLiteTensor* tensor) {
   auto name = std::string(TfLiteTensorName(tensor));
@@ -178,74 +356,34 @@ void TensorHelpers::updateJSBufferFromTensor(jsi::Runtime& runtime, TypedArrayBa
   }
 
   // count of bytes, may be larger than count of numbers (e.g. for float32)
-  int size = getTensorTotalLength(tensor) * getTFLTensorDataTypeSize(dataType);
+  size_t size = getTensorTotalLength(tensor) * getTFLTensorDataTypeSize(dataType);
 
-  switch (dataType) {
-    case kTfLiteFloat32:
-      getTypedArray(runtime, jsBuffer)
-          .as<TypedArrayKind::Float32Array>(runtime)
-          .updateUnsafe(runtime, (float32_t*)data, size);
-      break;
-    case kTfLiteFloat64:
-      getTypedArray(runtime, jsBuffer)
-          .as<TypedArrayKind::Float64Array>(runtime)
-          .updateUnsafe(runtime, (float64_t*)data, size);
-      break;
-    case kTfLiteInt8:
-      getTypedArray(runtime, jsBuffer)
-          .as<TypedArrayKind::Int8Array>(runtime)
-          .updateUnsafe(runtime, (int8_t*)data, size);
-      break;
-    case kTfLiteInt16:
-      getTypedArray(runtime, jsBuffer)
-          .as<TypedArrayKind::Int16Array>(runtime)
-          .updateUnsafe(runtime, (int16_t*)data, size);
-      break;
-    case kTfLiteInt32:
-      getTypedArray(runtime, jsBuffer)
-          .as<TypedArrayKind::Int32Array>(runtime)
-          .updateUnsafe(runtime, (int32_t*)data, size);
-      break;
-    case kTfLiteUInt8:
-      getTypedArray(runtime, jsBuffer)
-          .as<TypedArrayKind::Uint8Array>(runtime)
-          .updateUnsafe(runtime, (uint8_t*)data, size);
-      break;
-    case kTfLiteUInt16:
-      getTypedArray(runtime, jsBuffer)
-          .as<TypedArrayKind::Uint16Array>(runtime)
-          .updateUnsafe(runtime, (uint16_t*)data, size);
-      break;
-    case kTfLiteUInt32:
-      getTypedArray(runtime, jsBuffer)
-          .as<TypedArrayKind::Uint32Array>(runtime)
-          .updateUnsafe(runtime, (uint32_t*)data, size);
-      break;
-    case kTfLiteInt64:
-      getTypedArray(runtime, jsBuffer)
-          .as<TypedArrayKind::BigInt64Array>(runtime)
-          .updateUnsafe(runtime, (int64_t*)data, size);
-      break;
-    case kTfLiteUInt64:
-      getTypedArray(runtime, jsBuffer)
-          .as<TypedArrayKind::BigUint64Array>(runtime)
-          .updateUnsafe(runtime, (uint64_t*)data, size);
-      break;
-    default:
-      [[unlikely]];
-      throw jsi::JSError(runtime,
-                         "TFLite: Unsupported output data type! " + dataTypeToString(dataType));
+  TypedArrayInfo info = getTypedArrayInfo(runtime, jsBuffer);
+  if (info.kind != getTypedArrayKindForTFLDataType(dataType)) {
+    [[unlikely]];
+    throw jsi::JSError(runtime, "Object is not a TypedArray");
+  }
+  if (info.byteLength != size) {
+    [[unlikely]];
+    throw jsi::JSError(runtime, "TypedArray can only be updated with an array of the same size");
   }
+  memcpy(info.data, data, size);
 }
 
-void TensorHelpers::updateTensorFromJSBuffer(jsi::Runtime& runtime, TfLiteTensor* tensor,
-                                             TypedArrayBase& jsBuffer) {
+TensorData TensorHelpers::getJSBufferData(jsi::Runtime& runtime, const TfLiteTensor* tensor,
+                                          TypedArrayBase& jsBuffer) {
+  return getJSBufferData(tensor, getTypedArrayInfo(runtime, jsBuffer));
+}
+
+TensorData TensorHelpers::getJSBufferData([[maybe_unused]] const TfLiteTensor* tensor,
+                                          const TypedArrayInfo& jsBuffer) {
 #if DEBUG
   // Validate data-type
-  TypedArrayKind kind = jsBuffer.getKind(runtime);
-  TfLiteType receivedType = getTFLDataTypeForTypedArrayKind(kind);
+  TfLiteType receivedType = getTFLDataTypeForTypedArrayKind(jsBuffer.kind);
   TfLiteType expectedType = TfLiteTensorType(tensor);
-  if (receivedType != expectedType) {
+  // Raw float16 values are passed as a Uint16Array
+  bool isRawFloat16 = expectedType == kTfLiteFloat16 && receivedType == kTfLiteUInt16;
+  if (receivedType != expectedType && !isRawFloat16) {
     [[unlikely]];
     throw std::runtime_error("TFLite: Invalid input type! Model expected " +
                              dataTypeToString(expectedType) + ", but received " +
@@ -253,24 +391,480 @@ void TensorHelpers::updateTensorFromJSBuffer(jsi::Runtime& runtime, TfLiteTensor
   }
 #endif
 
-  std::string name = TfLiteTensorName(tensor);
-  jsi::ArrayBuffer buffer = jsBuffer.getBuffer(runtime);
+  uint8_t* data = jsBuffer.data;
+  size_t size = jsBuffer.byteLength;
 
 #if DEBUG
   // Validate size
-  int inputBufferSize = buffer.size(runtime);
-  int tensorSize = getTensorTotalLength(tensor) * getTFLTensorDataTypeSize(tensor->type);
-  if (tensorSize != inputBufferSize) {
+  size_t tensorSize = getTensorTotalLength(tensor) * getTFLTensorDataTypeSize(tensor->type);
+  if (tensorSize != size) {
     [[unlikely]];
-    throw std::runtime_error("TFLite: Input Buffer size (" + std::to_string(inputBufferSize) +
+    throw std::runtime_error("TFLite: Input Buffer size (" + std::to_string(size) +
                              ") does not match the Input Tensor's expected size (" +
                              std::to_string(tensorSize) +
                              ")! Make sure to resize the input values accordingly.");
   }
 #endif
 
-  TfLiteTensorCopyFromBuffer(tensor, buffer.data(runtime) + jsBuffer.byteOffset(runtime),
-                             buffer.size(runtime));
+  return TensorData{.data = data, .size = size};
+}
+
+TensorData TensorHelpers::getFloat32JSBufferData(const TfLiteTensor* tensor,
+                                                 const TypedArrayInfo& jsBuffer) {
+  if (jsBuffer.kind != TypedArrayKind::Float32Array) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Input tensor \"" + std::string(TfLiteTensorName(tensor)) +
+                             "\" is converted from floats, so its input value must be a "
+                             "Float32Array!");
+  }
+
+#if DEBUG
+  // Validate size
+  size_t expectedSize = getTensorTotalLength(tensor) * sizeof(float32_t);
+  if (expectedSize != jsBuffer.byteLength) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Input Buffer size (" + std::to_string(jsBuffer.byteLength) +
+                             ") does not match the Input Tensor's expected size (" +
+                             std::to_string(expectedSize) +
+                             ")! Make sure to resize the input values accordingly.");
+  }
+#endif
+
+  return TensorData{.data = jsBuffer.data, .size = jsBuffer.byteLength, .isFloat32 = true};
+}
+
+TensorData TensorHelpers::getPreprocessedJSBufferData(const TfLiteTensor* tensor,
+                                                      const TypedArrayInfo& jsBuffer) {
+  if (jsBuffer.kind != TypedArrayKind::Uint8Array &&
+      jsBuffer.kind != TypedArrayKind::Uint8ClampedArray) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Input tensor \"" + std::string(TfLiteTensorName(tensor)) +
+                             "\" is preprocessed, so its input value must be a Uint8Array!");
+  }
+
+#if DEBUG
+  // Validate size, every tensor element is created from one byte
+  size_t elementCount = getTensorTotalLength(tensor);
+  if (elementCount != jsBuffer.byteLength) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Input Buffer size (" + std::to_string(jsBuffer.byteLength) +
+                             ") does not match the Input Tensor's element count (" +
+                             std::to_string(elementCount) +
+                             ")! Make sure to resize the input values accordingly.");
+  }
+#endif
+
+  return TensorData{.data = jsBuffer.data, .size = jsBuffer.byteLength};
+}
+
+void TensorHelpers::updateTensorFromData(TfLiteTensor* tensor, const TensorData& data) {
+  if (data.data == TfLiteTensorData(tensor)) {
+    // The buffer is a view over the Tensor's memory (see `createJSBufferViewForTensor`),
+    // so the data is already in place.
+    return;
+  }
+
+  TfLiteStatus status = TfLiteTensorCopyFromBuffer(tensor, data.data, data.size);
+  if (status != kTfLiteOk) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Failed to copy " + std::to_string(data.size) +
+                             " bytes into input tensor \"" + TfLiteTensorName(tensor) +
+                             "\" (expected " + std::to_string(TfLiteTensorByteSize(tensor)) +
+                             " bytes)!");
+  }
+}
+
+void TensorHelpers::updateTensorFromData(TfLiteTensor* tensor, size_t offset,
+                                         const TensorData& data) {
+  size_t byteSize = TfLiteTensorByteSize(tensor);
+  if (offset + data.size > byteSize) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Failed to copy " + std::to_string(data.size) +
+                             " bytes at offset " + std::to_string(offset) +
+                             " into input tensor \"" + TfLiteTensorName(tensor) + "\" (" +
+                             std::to_string(byteSize) + " bytes)!");
+  }
+  uint8_t* target = static_cast<uint8_t*>(TfLiteTensorData(tensor)) + offset;
+  memcpy(target, data.data, data.size);
+}
+
+void TensorHelpers::updateTensorFromData(TfLiteTensor* tensor, size_t elementOffset,
+                                         const TensorData& data,
+                                         const InputPreprocessing& preprocessing) {
+  int dimensions = TfLiteTensorNumDims(tensor);
+  if (dimensions < 2) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Input tensor \"" + std::string(TfLiteTensorName(tensor)) +
+                             "\" has no channel dimension to preprocess!");
+  }
+  size_t channels = TfLiteTensorDim(tensor, preprocessing.toNCHW ? 1 : dimensions - 1);
+  size_t elementCount = getTensorTotalLength(tensor);
+  if (channels == 0 || data.size % channels != 0 || elementOffset + data.size > elementCount) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Failed to preprocess " + std::to_string(data.size) +
+                             " values at offset " + std::to_string(elementOffset) +
+                             " into input tensor \"" + TfLiteTensorName(tensor) + "\" (" +
+                             std::to_string(elementCount) + " values, " +
+                             std::to_string(channels) + " channels)!");
+  }
+  size_t pixelCount = data.size / channels;
+
+  TfLiteType dataType = TfLiteTensorType(tensor);
+  void* target = TfLiteTensorData(tensor);
+  switch (dataType) {
+    case kTfLiteFloat32: {
+      auto transform = Preprocessing::createTransform(preprocessing, channels);
+      Preprocessing::transformPixels(data.data, static_cast<float*>(target) + elementOffset,
+                                     pixelCount, transform);
+      break;
+    }
+    case kTfLiteInt8:
+    case kTfLiteUInt8: {
+      TfLiteQuantizationParams quantization = TfLiteTensorQuantizationParams(tensor);
+      float scale = quantization.scale != 0 ? quantization.scale : 1.0f;
+      auto transform =
+          Preprocessing::createTransform(preprocessing, channels, scale, quantization.zero_point);
+      if (dataType == kTfLiteInt8) {
+        Preprocessing::transformPixels(data.data, static_cast<int8_t*>(target) + elementOffset,
+                                       pixelCount, transform);
+      } else {
+        Preprocessing::transformPixels(data.data, static_cast<uint8_t*>(target) + elementOffset,
+                                       pixelCount, transform);
+      }
+      break;
+    }
+    default:
+      [[unlikely]];
+      throw std::runtime_error("TFLite: Input tensor \"" + std::string(TfLiteTensorName(tensor)) +
+                               "\" has type " + dataTypeToString(dataType) +
+                               ", but only float32, int8 and uint8 inputs can be preprocessed!");
+  }
+}
+
+void TensorHelpers::updateTensorFromFloat32Data(TfLiteTensor* tensor, size_t elementOffset,
+                                                const TensorData& data) {
+  size_t count = data.size / sizeof(float32_t);
+  size_t elementCount = getTensorTotalLength(tensor);
+  if (elementOffset + count > elementCount) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Failed to convert " + std::to_string(count) +
+                             " values at offset " + std::to_string(elementOffset) +
+                             " into input tensor \"" + TfLiteTensorName(tensor) + "\" (" +
+                             std::to_string(elementCount) + " values)!");
+  }
+
+  const float* input = reinterpret_cast<const float*>(data.data);
+  convertFloat32ToTensorData(input, tensor, elementOffset, count);
+}
+
+template <typename T>
+void resampleImageIntoTensor(T* output, const ImageInput& image, size_t width, size_t height,
+                             PixelTransform transform) {
+  size_t rowLength = transform.toNCHW ? width : width * 3;
+  if (transform.toNCHW) {
+    transform.planeStride = width * height;
+  }
+  ImageProcessing::resample(image.buffer, image.transform, width, height,
+                            [&](size_t row, const uint8_t* pixels) {
+                              Preprocessing::transformPixels(pixels, output + row * rowLength,
+                                                             width, transform);
+                            });
+}
+
+void TensorHelpers::updateTensorFromImage(TfLiteTensor* tensor, size_t elementOffset,
+                                          const ImageInput& image,
+                                          const InputPreprocessing* preprocessing) {
+  int dimensions = TfLiteTensorNumDims(tensor);
+  bool isNCHW = preprocessing != nullptr && preprocessing->toNCHW;
+  size_t channels = 0, height = 0, width = 0;
+  if (dimensions >= 3) {
+    channels = TfLiteTensorDim(tensor, isNCHW ? dimensions - 3 : dimensions - 1);
+    height = TfLiteTensorDim(tensor, isNCHW ? dimensions - 2 : dimensions - 3);
+    width = TfLiteTensorDim(tensor, isNCHW ? dimensions - 1 : dimensions - 2);
+  }
+  size_t elementCount = getTensorTotalLength(tensor);
+  if (channels != 3 || elementOffset + width * height * 3 > elementCount) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Input tensor \"" + std::string(TfLiteTensorName(tensor)) +
+                             "\" is not an RGB image tensor, images can only be sampled into " +
+                             (isNCHW ? "[N, 3, H, W]" : "[N, H, W, 3]") + " tensors!");
+  }
+
+  InputPreprocessing identity;
+  TfLiteType dataType = TfLiteTensorType(tensor);
+  void* target = TfLiteTensorData(tensor);
+  switch (dataType) {
+    case kTfLiteFloat32: {
+      auto transform = Preprocessing::createTransform(preprocessing ? *preprocessing : identity, 3);
+      resampleImageIntoTensor(static_cast<float*>(target) + elementOffset, image, width, height,
+                              transform);
+      break;
+    }
+    case kTfLiteInt8:
+    case kTfLiteUInt8: {
+      float scale = 1.0f;
+      int32_t zeroPoint = dataType == kTfLiteInt8 ? -128 : 0;
+      if (preprocessing != nullptr) {
+        // Normalized values are quantized, raw pixels are used as they are
+        TfLiteQuantizationParams quantization = TfLiteTensorQuantizationParams(tensor);
+        scale = quantization.scale != 0 ? quantization.scale : 1.0f;
+        zeroPoint = quantization.zero_point;
+      }
+      auto transform = Preprocessing::createTransform(preprocessing ? *preprocessing : identity, 3,
+                                                      scale, zeroPoint);
+      if (dataType == kTfLiteInt8) {
+        resampleImageIntoTensor(static_cast<int8_t*>(target) + elementOffset, image, width,
+                                height, transform);
+      } else {
+        resampleImageIntoTensor(static_cast<uint8_t*>(target) + elementOffset, image, width,
+                                height, transform);
+      }
+      break;
+    }
+    default:
+      [[unlikely]];
+      throw std::runtime_error("TFLite: Input tensor \"" + std::string(TfLiteTensorName(tensor)) +
+                               "\" has type " + dataTypeToString(dataType) +
+                               ", but images can only be sampled into float32, int8 and uint8 "
+                               "tensors!");
+  }
+}
+
+void TensorHelpers::updateTensorFromJSBuffer(jsi::Runtime& runtime, TfLiteTensor* tensor,
+                                             TypedArrayBase& jsBuffer) {
+  TensorData data = getJSBufferData(runtime, tensor, jsBuffer);
+  updateTensorFromData(tensor, data);
+}
+
+std::shared_ptr<jsi::MutableBuffer> TensorHelpers::copyTensorData(const TfLiteTensor* tensor) {
+  auto buffer = std::make_shared<OwningBuffer>(TfLiteTensorByteSize(tensor));
+  TfLiteStatus status = TfLiteTensorCopyToBuffer(tensor, buffer->data(), buffer->size());
+  if (status != kTfLiteOk) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Failed to copy data from output tensor \"" +
+                             std::string(TfLiteTensorName(tensor)) + "\"!");
+  }
+  return buffer;
+}
+
+std::shared_ptr<jsi::MutableBuffer>
+TensorHelpers::copyTensorData(const TfLiteTensor* tensor, size_t offset, size_t size) {
+  if (offset + size > TfLiteTensorByteSize(tensor)) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Failed to copy " + std::to_string(size) +
+                             " bytes at offset " + std::to_string(offset) +
+                             " from output tensor \"" + TfLiteTensorName(tensor) + "\"!");
+  }
+  auto buffer = std::make_shared<OwningBuffer>(size);
+  const uint8_t* source = static_cast<const uint8_t*>(TfLiteTensorData(tensor)) + offset;
+  memcpy(buffer->data(), source, size);
+  return buffer;
+}
+
+std::shared_ptr<jsi::MutableBuffer>
+TensorHelpers::copyTensorDataAsFloat32(const TfLiteTensor* tensor, size_t elementOffset,
+                                       size_t count) {
+  size_t elementCount = getTensorTotalLength(tensor);
+  const void* data = TfLiteTensorData(tensor);
+  if (data == nullptr || elementOffset + count > elementCount) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Failed to convert " + std::to_string(count) +
+                             " values at offset " + std::to_string(elementOffset) +
+                             " from output tensor \"" + TfLiteTensorName(tensor) + "\" (" +
+                             std::to_string(elementCount) + " values)!");
+  }
+
+  auto buffer = std::make_shared<OwningBuffer>(count * sizeof(float32_t));
+  convertTensorDataToFloat32(tensor, elementOffset, count,
+                             reinterpret_cast<float*>(buffer->data()));
+  return buffer;
+}
+
+std::shared_ptr<jsi::MutableBuffer>
+TensorHelpers::postprocessTensorData(const TfLiteTensor* tensor, size_t elementOffset,
+                                     size_t count, const OutputPostprocessing& postprocessing) {
+  int dimensions = TfLiteTensorNumDims(tensor);
+  size_t rowSize = dimensions > 0 ? TfLiteTensorDim(tensor, dimensions - 1) : 0;
+  size_t elementCount = getTensorTotalLength(tensor);
+  const void* data = TfLiteTensorData(tensor);
+  if (data == nullptr || rowSize == 0 || count % rowSize != 0 ||
+      elementOffset + count > elementCount) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Failed to post-process " + std::to_string(count) +
+                             " values at offset " + std::to_string(elementOffset) +
+                             " of output tensor \"" + TfLiteTensorName(tensor) + "\" (" +
+                             std::to_string(elementCount) + " values)!");
+  }
+
+  size_t rows = count / rowSize;
+  size_t k = std::min(postprocessing.topK, rowSize);
+  auto buffer = std::make_shared<OwningBuffer>(rows * k * 2 * sizeof(float32_t));
+  float* output = reinterpret_cast<float*>(buffer->data());
+
+  TfLiteType dataType = TfLiteTensorType(tensor);
+  TfLiteQuantizationParams quantization = TfLiteTensorQuantizationParams(tensor);
+  float scale = quantization.scale != 0 ? quantization.scale : 1.0f;
+  std::vector<float> rowStorage;
+  for (size_t row = 0; row < rows; row++) {
+    size_t offset = elementOffset + row * rowSize;
+    float* rowOutput = output + row * k * 2;
+    switch (dataType) {
+      case kTfLiteFloat32:
+        Postprocessing::topK(static_cast<const float*>(data) + offset, rowSize, k,
+                             postprocessing.softmax, rowOutput);
+        break;
+      case kTfLiteFloat16:
+        rowStorage.resize(rowSize);
+        Float16::toFloat32(static_cast<const uint16_t*>(data) + offset, rowStorage.data(),
+                           rowSize);
+        Postprocessing::topK(rowStorage.data(), rowSize, k, postprocessing.softmax, rowOutput);
+        break;
+      case kTfLiteInt8:
+        Postprocessing::topK(static_cast<const int8_t*>(data) + offset, rowSize, k,
+                             postprocessing.softmax, scale, quantization.zero_point, rowOutput);
+        break;
+      case kTfLiteUInt8:
+        Postprocessing::topK(static_cast<const uint8_t*>(data) + offset, rowSize, k,
+                             postprocessing.softmax, scale, quantization.zero_point, rowOutput);
+        break;
+      default:
+        [[unlikely]];
+        throw std::runtime_error("TFLite: Output tensor \"" +
+                                 std::string(TfLiteTensorName(tensor)) + "\" has type " +
+                                 dataTypeToString(dataType) +
+                                 ", but only float32, float16, int8 and uint8 outputs can "
+                                 "be post-processed!");
+    }
+  }
+  return buffer;
+}
+
+/**
+ Returns `count` float values of the Tensor starting at `offset`. Float16 and quantized values are
+ converted into `storage`.
+ */
+const float* getFloatTensorData(const TfLiteTensor* tensor, size_t offset, size_t count,
+                                std::vector<float>& storage) {
+  const void* data = TfLiteTensorData(tensor);
+  if (data == nullptr || offset + count > static_cast<size_t>(getTensorTotalLength(tensor))) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Failed to read " + std::to_string(count) +
+                             " values at offset " + std::to_string(offset) +
+                             " from output tensor \"" + TfLiteTensorName(tensor) + "\"!");
+  }
+
+  TfLiteType dataType = TfLiteTensorType(tensor);
+  if (dataType == kTfLiteFloat32) {
+    return static_cast<const float*>(data) + offset;
+  }
+  storage.resize(count);
+  convertTensorDataToFloat32(tensor, offset, count, storage.data());
+  return storage.data();
+}
+
+/**
+ The amount of values of one sample if the tensor holds a batch of `batchSize` samples.
+ */
+size_t getTensorSampleLength(const TfLiteTensor* tensor, size_t batchSize) {
+  size_t length = getTensorTotalLength(tensor);
+  if (batchSize == 0 || length % batchSize != 0) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Output tensor \"" + std::string(TfLiteTensorName(tensor)) +
+                             "\" is not batched!");
+  }
+  return length / batchSize;
+}
+
+std::shared_ptr<jsi::MutableBuffer>
+TensorHelpers::decodeDetections(const TfLiteTensor* boxesTensor, const TfLiteTensor* scoresTensor,
+                                size_t sample, size_t batchSize,
+                                const DetectionOptions& options) {
+  std::vector<DetectedObject> candidates;
+  switch (options.format) {
+    case DetectionOptions::SSD: {
+      size_t boxesLength = getTensorSampleLength(boxesTensor, batchSize);
+      size_t scoresLength = getTensorSampleLength(scoresTensor, batchSize);
+      size_t count = boxesLength / 4;
+      if (count == 0 || scoresLength % count != 0) {
+        [[unlikely]];
+        throw std::runtime_error("TFLite: SSD boxes (" + std::to_string(boxesLength) +
+                                 " values) and scores (" + std::to_string(scoresLength) +
+                                 " values) outputs do not match!");
+      }
+      std::vector<float> boxesStorage, scoresStorage;
+      const float* boxes =
+          getFloatTensorData(boxesTensor, sample * boxesLength, boxesLength, boxesStorage);
+      const float* scores =
+          getFloatTensorData(scoresTensor, sample * scoresLength, scoresLength, scoresStorage);
+      candidates = Detection::decodeSSD(boxes, scores, count, scoresLength / count, options);
+      break;
+    }
+    case DetectionOptions::YOLO: {
+      int dimensions = TfLiteTensorNumDims(boxesTensor);
+      if (dimensions < 2) {
+        [[unlikely]];
+        throw std::runtime_error("TFLite: YOLO output \"" +
+                                 std::string(TfLiteTensorName(boxesTensor)) +
+                                 "\" needs at least 2 dimensions!");
+      }
+      size_t rows = TfLiteTensorDim(boxesTensor, dimensions - 2);
+      size_t columns = TfLiteTensorDim(boxesTensor, dimensions - 1);
+      if (dimensions == 2) {
+        // Without a batch dimension, the samples of a batch are stacked along the rows.
+        rows /= batchSize;
+      }
+      // There are always a lot more boxes than values per box, e.g. [1, 84, 8400] (YOLOv8) or
+      // [1, 25200, 85] (YOLOv5).
+      bool transposed = rows < columns;
+      size_t length = getTensorSampleLength(boxesTensor, batchSize);
+      std::vector<float> storage;
+      const float* output = getFloatTensorData(boxesTensor, sample * length, length, storage);
+      candidates = Detection::decodeYOLO(output, std::max(rows, columns),
+                                         std::min(rows, columns), transposed, options);
+      break;
+    }
+  }
+
+  auto detections = Detection::nonMaximumSuppression(std::move(candidates), options);
+  constexpr size_t valuesPerDetection = 6;
+  auto buffer =
+      std::make_shared<OwningBuffer>(detections.size() * valuesPerDetection * sizeof(float32_t));
+  float* output = reinterpret_cast<float*>(buffer->data());
+  for (size_t i = 0; i < detections.size(); i++) {
+    const DetectedObject& detection = detections[i];
+    float* values = output + i * valuesPerDetection;
+    values[0] = detection.x1;
+    values[1] = detection.y1;
+    values[2] = detection.x2;
+    values[3] = detection.y2;
+    values[4] = detection.score;
+    values[5] = static_cast<float>(detection.classIndex);
+  }
+  return buffer;
+}
+
+void TensorHelpers::updateFloat32JSBufferFromTensor(jsi::Runtime& runtime,
+                                                    TypedArrayBase& jsBuffer,
+                                                    const TfLiteTensor* tensor) {
+  const void* data = TfLiteTensorData(tensor);
+  if (data == nullptr) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: Failed to get data from tensor \"" +
+                             std::string(TfLiteTensorName(tensor)) + "\"!");
+  }
+
+  size_t count = getTensorTotalLength(tensor);
+  TypedArrayInfo info = getTypedArrayInfo(runtime, jsBuffer);
+  if (info.kind != TypedArrayKind::Float32Array) {
+    [[unlikely]];
+    throw jsi::JSError(runtime, "Object is not a Float32Array");
+  }
+  if (info.byteLength != count * sizeof(float32_t)) {
+    [[unlikely]];
+    throw jsi::JSError(runtime, "TypedArray can only be updated with an array of the same size");
+  }
+
+  convertTensorDataToFloat32(tensor, 0, count, reinterpret_cast<float*>(info.data));
 }
 
 jsi::Object TensorHelpers::tensorToJSObject(jsi::Runtime& runtime, const TfLiteTensor* tensor) {
@@ -283,7 +877,7 @@ jsi::Object TensorHelpers::tensorToJSObject(jsi::Runtime& runtime, const TfLiteT
 
   int dimensions = TfLiteTensorNumDims(tensor);
   jsi::Array shapeArray(runtime, dimensions);
-  for (size_t i = 0; i < dimensions; i++) {
+  for (int i = 0; i < dimensions; i++) {
     int size = TfLiteTensorDim(tensor, i);
     shapeArray.setValueAtIndex(runtime, i, jsi::Value(size));
   }
@@ -8,10 +8,18 @@
 
 #pragma once
 
+#include "Detection.h"
+#include "Float16.h"
+#include "ImageProcessing.h"
+#include "Postprocessing.h"
+#include "Preprocessing.h"
+#include "Quantization.h"
 #include "jsi/TypedArray.h"
 #include <jsi/jsi.h>
+#include <memory>
+#include <optional>
 
-#ifdef ANDROID
+#if defined(ANDROID) || defined(FAST_TFLITE_HOST)
 #include <tflite/c/c_api.h>
 #else
 #include <TensorFlowLiteC/TensorFlowLiteC.h>
@@ -19,6 +27,19 @@
 
 using namespace facebook;
 
+/**
+ Raw pointer to the data of an input buffer.
+ */
+struct TensorData {
+  uint8_t* data;
+  size_t size;
+  // If true, `data` contains float32 values that are converted (quantized, or to float16) while
+  // copying them into the tensor.
+  bool isFloat32 = false;
+  // If set, the input is an image that is sampled into the tensor instead of `data`.
+  std::shared_ptr<const ImageInput> image = nullptr;
+};
+
 class TensorHelpers {
 public:
   /**
@@ -30,11 +51,141 @@ public:
    */
   static mrousavy::TypedArrayBase createJSBufferForTensor(jsi::Runtime& runtime,
                                                           const TfLiteTensor* tensor);
+  /**
+   Create a pre-allocated TypedArray of the given TFLTensorDataType with the TFLTensor's shape.
+   */
+  static mrousavy::TypedArrayBase createJSBufferForTensor(jsi::Runtime& runtime,
+                                                          const TfLiteTensor* tensor,
+                                                          TfLiteType dataType);
+  /**
+   Get the affine quantization params of an int8 or uint8 tensor, or `std::nullopt` if the tensor
+   is not quantized.
+   */
+  static std::optional<QuantizationParams> getQuantizationParams(const TfLiteTensor* tensor);
+  /**
+   Whether the tensor's values can be converted from and to float32, which is the case for
+   float16 and quantized tensors.
+   */
+  static bool canConvertToFloat32(const TfLiteTensor* tensor);
+  /**
+   Create a TypedArray that directly points to the given TFLTensor's memory, without copying.
+   The `owner` will be kept alive for as long as the TypedArray is alive.
+   */
+  static mrousavy::TypedArrayBase createJSBufferViewForTensor(jsi::Runtime& runtime,
+                                                              const TfLiteTensor* tensor,
+                                                              std::shared_ptr<void> owner);
+  /**
+   Create a TypedArray of the given TFLTensorDataType that points to the given buffer, without
+   copying.
+   */
+  static mrousavy::TypedArrayBase createJSBufferForData(jsi::Runtime& runtime,
+                                                        TfLiteType dataType,
+                                                        std::shared_ptr<jsi::MutableBuffer> data);
+  /**
+   Copies the Tensor's data into a new jsi::MutableBuffer.
+   This does not use the jsi::Runtime, so it can be called from any Thread.
+   */
+  static std::shared_ptr<jsi::MutableBuffer> copyTensorData(const TfLiteTensor* tensor);
+  /**
+   Copies `size` bytes starting at `offset` of the Tensor's data into a new jsi::MutableBuffer.
+   This does not use the jsi::Runtime, so it can be called from any Thread.
+   */
+  static std::shared_ptr<jsi::MutableBuffer> copyTensorData(const TfLiteTensor* tensor,
+                                                            size_t offset, size_t size);
+  /**
+   Runs the post-processing on `count` values starting at `elementOffset` of the Tensor's data,
+   for every row (the last dimension). The result is a new jsi::MutableBuffer of float32
+   `(index, score)` pairs, `topK` pairs per row.
+   This does not use the jsi::Runtime, so it can be called from any Thread.
+   */
+  static std::shared_ptr<jsi::MutableBuffer>
+  postprocessTensorData(const TfLiteTensor* tensor, size_t elementOffset, size_t count,
+                        const OutputPostprocessing& postprocessing);
+  /**
+   Decodes the raw outputs of an object detection Model for the given sample of a batch of
+   `batchSize` samples and runs non-maximum suppression. `scoresTensor` is only used for SSD
+   outputs. The result is a new jsi::MutableBuffer of float32 `[x1, y1, x2, y2, score, classIndex]`
+   values per detection. This does not use the jsi::Runtime, so it can be called from any Thread.
+   */
+  static std::shared_ptr<jsi::MutableBuffer> decodeDetections(const TfLiteTensor* boxesTensor,
+                                                              const TfLiteTensor* scoresTensor,
+                                                              size_t sample, size_t batchSize,
+                                                              const DetectionOptions& options);
   /**
    Copies the Tensor's data into a jsi::TypedArray and correctly casts to the given type.
    */
   static void updateJSBufferFromTensor(jsi::Runtime& runtime, mrousavy::TypedArrayBase& jsBuffer,
                                        const TfLiteTensor* outputTensor);
+  /**
+   Converts the float16 or quantized Tensor's data into a Float32Array.
+   */
+  static void updateFloat32JSBufferFromTensor(jsi::Runtime& runtime,
+                                              mrousavy::TypedArrayBase& jsBuffer,
+                                              const TfLiteTensor* outputTensor);
+  /**
+   Converts `count` values starting at `elementOffset` of the float16 or quantized Tensor's data
+   into a new jsi::MutableBuffer of float32 values.
+   This does not use the jsi::Runtime, so it can be called from any Thread.
+   */
+  static std::shared_ptr<jsi::MutableBuffer>
+  copyTensorDataAsFloat32(const TfLiteTensor* tensor, size_t elementOffset, size_t count);
+  /**
+   Validates the jsi::TypedArray against the given input tensor and returns a pointer to its data.
+   */
+  static TensorData getJSBufferData(jsi::Runtime& runtime, const TfLiteTensor* inputTensor,
+                                    mrousavy::TypedArrayBase& jsBuffer);
+  /**
+   Validates the TypedArray's info against the given input tensor and returns a pointer to its data.
+   */
+  static TensorData getJSBufferData(const TfLiteTensor* inputTensor,
+                                    const mrousavy::TypedArrayInfo& jsBuffer);
+  /**
+   Validates the TypedArray's info as the 8-bit pixels of a preprocessed input tensor (one byte
+   per tensor element) and returns a pointer to its data.
+   */
+  static TensorData getPreprocessedJSBufferData(const TfLiteTensor* inputTensor,
+                                                const mrousavy::TypedArrayInfo& jsBuffer);
+  /**
+   Validates the Float32Array's info as the values of a float16 or quantized input tensor and
+   returns a pointer to its data.
+   */
+  static TensorData getFloat32JSBufferData(const TfLiteTensor* inputTensor,
+                                           const mrousavy::TypedArrayInfo& jsBuffer);
+  /**
+   Copies the raw data into the given input tensor.
+   This does not use the jsi::Runtime, so it can be called from any Thread.
+   */
+  static void updateTensorFromData(TfLiteTensor* inputTensor, const TensorData& data);
+  /**
+   Copies the raw data into the given input tensor, starting at `offset` bytes.
+   This does not use the jsi::Runtime, so it can be called from any Thread.
+   */
+  static void updateTensorFromData(TfLiteTensor* inputTensor, size_t offset,
+                                   const TensorData& data);
+  /**
+   Normalizes the raw 8-bit pixels and writes them into the given input tensor, starting at
+   `elementOffset` values. Integer tensors are quantized with the tensor's quantization params.
+   This does not use the jsi::Runtime, so it can be called from any Thread.
+   */
+  static void updateTensorFromData(TfLiteTensor* inputTensor, size_t elementOffset,
+                                   const TensorData& data, const InputPreprocessing& preprocessing);
+  /**
+   Converts the float32 values to float16 or quantizes them and writes them into the given input
+   tensor, starting at `elementOffset` values.
+   This does not use the jsi::Runtime, so it can be called from any Thread.
+   */
+  static void updateTensorFromFloat32Data(TfLiteTensor* inputTensor, size_t elementOffset,
+                                          const TensorData& data);
+  /**
+   Samples the image into the given RGB input tensor (NHWC, or NCHW if the preprocessing converts
+   to NCHW), starting at `elementOffset` values, and normalizes it with the given preprocessing.
+   Without preprocessing, float32 and uint8 tensors receive the raw 0-255 values and int8 tensors
+   receive them shifted by -128.
+   This does not use the jsi::Runtime, so it can be called from any Thread.
+   */
+  static void updateTensorFromImage(TfLiteTensor* inputTensor, size_t elementOffset,
+                                    const ImageInput& image,
+                                    const InputPreprocessing* preprocessing);
   /**
    Copies the data from the jsi::TypedArray into the given input buffer.
    */
@@ -8,19 +8,33 @@
 
 #include "TensorflowPlugin.h"
 
+#include "InferenceStats.h"
+#include "InterpreterPool.h"
+#include "LoaderPool.h"
+#include "ModelRegistry.h"
+#include "Pipeline.h"
 #include "TensorHelpers.h"
+#include "ThreadPool.h"
 #include "jsi/Promise.h"
 #include "jsi/TypedArray.h"
+#include <algorithm>
 #include <chrono>
-#include <future>
+#include <cstring>
 #include <iostream>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <type_traits>
+#include <utility>
 
-#ifdef ANDROID
+#if defined(ANDROID) || defined(FAST_TFLITE_HOST)
 #include <tflite/c/c_api.h>
+#include <tflite/c/c_api_experimental.h>
+#include <tflite/delegates/xnnpack/xnnpack_delegate.h>
+#ifdef ANDROID
 #include <tflite/delegates/gpu/delegate.h>
 #include <tflite/delegates/nnapi/nnapi_delegate_c_api.h>
+#endif
 #else
 #include <TensorFlowLiteC/TensorFlowLiteC.h>
 
@@ -32,122 +46,262 @@
 using namespace facebook;
 using namespace mrousavy;
 
-void log(std::string string...) {
+// Maximum amount of `run(..)` calls that can wait for the worker Thread
+constexpr size_t kMaxPendingRuns = 16;
+// Maximum amount of different input shapes we keep Interpreters for
+constexpr size_t kMaxCachedShapes = 4;
+// Upper bound for the default CPU thread count, more threads rarely help on mobile CPUs
+constexpr int kMaxDefaultThreads = 4;
+// Default amount of Models that are loaded at the same time
+constexpr size_t kDefaultLoaderConcurrency = 2;
+
+// Whether the XNNPACK delegate options have the `weight_cache_file_path` field
+template <typename T, typename = void> struct HasWeightsCacheFilePath : std::false_type {};
+template <typename T>
+struct HasWeightsCacheFilePath<T, std::void_t<decltype(std::declval<T&>().weight_cache_file_path)>>
+    : std::true_type {};
+
+const std::string kRunCancelledMessage = "TFLite: The run was cancelled!";
+const std::string kRunDeadlineMessage = "TFLite: The run missed its deadline!";
+
+void log(std::string...) {
   // TODO: Figure out how to log to console
 }
 
+std::shared_ptr<TfLiteModel> TensorflowPlugin::createModel(Buffer buffer,
+                                                           const std::string& modelPath) {
+  TfLiteModel* model = TfLiteModelCreate(buffer.data, buffer.size);
+  if (model == nullptr) {
+    [[unlikely]];
+    buffer.release();
+    throw std::runtime_error("Failed to load model from \"" + modelPath + "\"!");
+  }
+
+  return std::shared_ptr<TfLiteModel>(model, [buffer](TfLiteModel* ptr) mutable {
+    TfLiteModelDelete(ptr);
+    // The Model's data has to outlive the Model
+    buffer.release();
+  });
+}
+
+int TensorflowPlugin::getNumThreads(const Options& options) {
+  if (options.numThreads > 0) {
+    return options.numThreads;
+  }
+  // Use half of the cores (roughly the performance cores), but at least one. Every Interpreter of
+  // the pool can run at the same time, so they share this budget instead of oversubscribing it.
+  int cores = static_cast<int>(std::thread::hardware_concurrency());
+  int budget = std::clamp(cores / 2, 1, kMaxDefaultThreads);
+  int interpreters = static_cast<int>(std::max(options.interpreterPoolSize, options.pipelineDepth));
+  return std::max(budget / interpreters, 1);
+}
+
+struct TensorflowPlugin::WeightsCache {
+  TfLiteXNNPackDelegateWeightsCache* cache;
+  // XNNPACK only looks up weights once the cache is finalized, which has to happen before the
+  // first run. Finalizing "softly" still lets later Interpreters (e.g. for other input shapes)
+  // use the weights that are already packed.
+  std::once_flag finalized;
+
+  explicit WeightsCache(TfLiteXNNPackDelegateWeightsCache* cache) : cache(cache) {}
+  ~WeightsCache() {
+    TfLiteXNNPackDelegateWeightsCacheDelete(cache);
+  }
+};
+
+/**
+ Sets the XNNPACK weights cache file, if this TFLite version has that option. Older versions pack
+ the weights on every load instead.
+ */
+template <typename XNNPackOptions>
+void setWeightsCacheFilePath(XNNPackOptions& options, const std::string& path) {
+  if constexpr (HasWeightsCacheFilePath<XNNPackOptions>::value) {
+    options.weight_cache_file_path = path.c_str();
+  }
+}
+
+std::shared_ptr<TensorflowPlugin::WeightsCache>
+TensorflowPlugin::createWeightsCache(const Options& options) {
+  if (options.delegate != Delegate::Default) {
+    return nullptr;
+  }
+  if (!options.weightsCachePath.empty() &&
+      HasWeightsCacheFilePath<TfLiteXNNPackDelegateOptions>::value) {
+    // Every Interpreter memory-maps the same file, so they share the packed weights already.
+    return nullptr;
+  }
+  TfLiteXNNPackDelegateWeightsCache* cache = TfLiteXNNPackDelegateWeightsCacheCreate();
+  if (cache == nullptr) {
+    [[unlikely]];
+    // Every Interpreter packs its own weights then.
+    return nullptr;
+  }
+  return std::make_shared<WeightsCache>(cache);
+}
+
+std::shared_ptr<TfLiteInterpreter>
+TensorflowPlugin::createInterpreter(std::shared_ptr<TfLiteModel> model, const Options& options,
+                                    const std::string& modelPath,
+                                    std::shared_ptr<WeightsCache> weightsCache) {
+  int numThreads = getNumThreads(options);
+  TfLiteDelegate* delegate = nullptr;
+  std::function<void(TfLiteDelegate*)> deleteDelegate;
+
+  switch (options.delegate) {
+    case TensorflowPlugin::Delegate::CoreML: {
+#if FAST_TFLITE_ENABLE_CORE_ML
+      TfLiteCoreMlDelegateOptions delegateOptions = {};
+      delegate = TfLiteCoreMlDelegateCreate(&delegateOptions);
+      deleteDelegate = TfLiteCoreMlDelegateDelete;
+      break;
+#else
+      throw std::runtime_error("CoreML Delegate is not enabled! Set $EnableCoreMLDelegate to true "
+                               "in Podfile and rebuild.");
+#endif
+    }
+    case TensorflowPlugin::Delegate::Metal: {
+      throw std::runtime_error("Metal Delegate is not supported!");
+    }
+#ifdef ANDROID
+    case TensorflowPlugin::Delegate::NnApi: {
+      TfLiteNnapiDelegateOptions delegateOptions = TfLiteNnapiDelegateOptionsDefault();
+      delegate = TfLiteNnapiDelegateCreate(&delegateOptions);
+      deleteDelegate = TfLiteNnapiDelegateDelete;
+      break;
+    }
+    case TensorflowPlugin::Delegate::AndroidGPU: {
+      TfLiteGpuDelegateOptionsV2 delegateOptions = TfLiteGpuDelegateOptionsV2Default();
+      delegate = TfLiteGpuDelegateV2Create(&delegateOptions);
+      deleteDelegate = TfLiteGpuDelegateV2Delete;
+      break;
+    }
+#else
+    case TensorflowPlugin::Delegate::NnApi: {
+      throw std::runtime_error("Nnapi Delegate is only supported on Android!");
+    }
+    case TensorflowPlugin::Delegate::AndroidGPU: {
+      throw std::runtime_error("Android-Gpu Delegate is only supported on Android!");
+    }
+#endif
+    default: {
+      // use XNNPACK CPU delegate.
+      TfLiteXNNPackDelegateOptions delegateOptions = TfLiteXNNPackDelegateOptionsDefault();
+      delegateOptions.num_threads = numThreads;
+      if (options.useFp16) {
+        delegateOptions.flags |= TFLITE_XNNPACK_DELEGATE_FLAG_FORCE_FP16;
+      }
+      if (!options.weightsCachePath.empty()) {
+        // XNNPACK packs the weights once and stores them in this file, later loads just map it.
+        setWeightsCacheFilePath(delegateOptions, options.weightsCachePath);
+      }
+      if (weightsCache != nullptr) {
+        delegateOptions.weights_cache = weightsCache->cache;
+      }
+      delegate = TfLiteXNNPackDelegateCreate(&delegateOptions);
+      deleteDelegate = TfLiteXNNPackDelegateDelete;
+      break;
+    }
+  }
+
+  // Create TensorFlow Interpreter
+  auto interpreterOptions = TfLiteInterpreterOptionsCreate();
+  // Used for all operations that are not handled by the delegate
+  TfLiteInterpreterOptionsSetNumThreads(interpreterOptions, numThreads);
+  // Allows `cancel()` and deadlines to stop a running invocation
+  TfLiteInterpreterOptionsEnableCancellation(interpreterOptions, true);
+  if (delegate != nullptr) {
+    TfLiteInterpreterOptionsAddDelegate(interpreterOptions, delegate);
+  }
+  auto interpreter = TfLiteInterpreterCreate(model.get(), interpreterOptions);
+  TfLiteInterpreterOptionsDelete(interpreterOptions);
+
+  if (interpreter == nullptr) {
+    [[unlikely]];
+    if (delegate != nullptr) {
+      deleteDelegate(delegate);
+    }
+    throw std::runtime_error("Failed to create TFLite interpreter from model \"" + modelPath +
+                             "\"!");
+  }
+
+  if (weightsCache != nullptr) {
+    // Creating the first Interpreter packed all weights into the cache.
+    std::call_once(weightsCache->finalized,
+                   [&]() { TfLiteXNNPackDelegateWeightsCacheFinalizeSoft(weightsCache->cache); });
+  }
+
+  return std::shared_ptr<TfLiteInterpreter>(
+      interpreter, [model, delegate, deleteDelegate, weightsCache](TfLiteInterpreter* ptr) {
+        TfLiteInterpreterDelete(ptr);
+        // The delegate has to outlive the Interpreter, and the weights cache the delegate
+        if (delegate != nullptr) {
+          deleteDelegate(delegate);
+        }
+      });
+}
+
 void TensorflowPlugin::installToRuntime(jsi::Runtime& runtime,
                                         std::shared_ptr<react::CallInvoker> callInvoker,
                                         FetchURLFunc fetchURL) {
+  auto promiseFactory = std::make_shared<PromiseFactory>(runtime);
+
+  // Drops the cached PropNameIDs and TypedArray constructors once this Runtime is destroyed.
+  auto invalidateCache = std::make_shared<InvalidateCacheOnDestroy>(runtime);
+  runtime.global().setProperty(runtime, "__tfliteTypedArrayCache",
+                               jsi::Object::createFromHostObject(runtime, invalidateCache));
+
+  // Loads run on their own Threads, so loading a few large Models never blocks inference or the
+  // JS Thread, and doesn't start an unbounded amount of Threads either.
+  auto loaderPool = std::make_shared<LoaderPool>("TFLite Loader", kDefaultLoaderConcurrency);
+  const std::string cancelledMessage = "TFLite: Loading the Model was cancelled!";
 
   auto func = jsi::Function::createFromHostFunction(
-      runtime, jsi::PropNameID::forAscii(runtime, "__loadTensorflowModel"), 1,
-      [=](jsi::Runtime& runtime, const jsi::Value& thisValue, const jsi::Value* arguments,
+      runtime, jsi::PropNameID::forAscii(runtime, "__loadTensorflowModel"), 3,
+      [=](jsi::Runtime& runtime, const jsi::Value&, const jsi::Value* arguments,
           size_t count) -> jsi::Value {
         auto start = std::chrono::steady_clock::now();
         auto modelPath = arguments[0].asString(runtime).utf8(runtime);
 
         log("Loading TensorFlow Lite Model from \"%s\"...", modelPath.c_str());
 
-        // TODO: Figure out how to use Metal/CoreML delegates
-        Delegate delegateType = Delegate::Default;
-        if (count > 1 && arguments[1].isString()) {
-          // user passed a custom delegate command
-          auto delegate = arguments[1].asString(runtime).utf8(runtime);
-          if (delegate == "core-ml") {
-            delegateType = Delegate::CoreML;
-          } else if (delegate == "metal") {
-            delegateType = Delegate::Metal;
-          } else if (delegate == "nnapi") {
-            delegateType = Delegate::NnApi;
-          } else if (delegate == "android-gpu") {
-            delegateType = Delegate::AndroidGPU;
-          } else {
-            delegateType = Delegate::Default;
-          }
+        Options options = count > 1 ? parseOptions(runtime, arguments[1]) : Options();
+        // The id JS can cancel this load with, or 0 if it can't be cancelled
+        uint64_t loadId = 0;
+        if (count > 2 && arguments[2].isNumber()) {
+          loadId = static_cast<uint64_t>(arguments[2].asNumber());
         }
 
-        auto promise = Promise::createPromise(runtime, [=, &runtime](
-                                                           std::shared_ptr<Promise> promise) {
-          // Launch async thread
-          std::async(std::launch::async, [=, &runtime]() {
+        auto promise = promiseFactory->createPromise(runtime, [=, &runtime](
+                                                                 std::shared_ptr<Promise> promise) {
+          auto load = [=, &runtime](const LoaderPool::CancellationFlag& isCancelled) {
             try {
-              // Fetch model from URL (JS bundle)
-              Buffer buffer = fetchURL(modelPath);
-
-              // Load Model into Tensorflow
-              auto model = TfLiteModelCreate(buffer.data, buffer.size);
-              if (model == nullptr) {
-                callInvoker->invokeAsync(
-                    [=]() { promise->reject("Failed to load model from \"" + modelPath + "\"!"); });
-                return;
-              }
-
-              // Create TensorFlow Interpreter
-              auto options = TfLiteInterpreterOptionsCreate();
-
-              switch (delegateType) {
-                case Delegate::CoreML: {
-#if FAST_TFLITE_ENABLE_CORE_ML
-                  TfLiteCoreMlDelegateOptions delegateOptions;
-                  auto delegate = TfLiteCoreMlDelegateCreate(&delegateOptions);
-                  TfLiteInterpreterOptionsAddDelegate(options, delegate);
-                  break;
-#else
-                      callInvoker->invokeAsync([=]() {
-                        promise->reject("CoreML Delegate is not enabled! Set $EnableCoreMLDelegate to true in Podfile and rebuild.");
-                      });
-                      return;
-#endif
-                }
-                case Delegate::Metal: {
-                  callInvoker->invokeAsync(
-                      [=]() { promise->reject("Metal Delegate is not supported!"); });
-                  return;
-                }
-#ifdef ANDROID
-                case Delegate::NnApi: {
-                  TfLiteNnapiDelegateOptions delegateOptions = TfLiteNnapiDelegateOptionsDefault();
-                  auto delegate = TfLiteNnapiDelegateCreate(&delegateOptions);
-                  TfLiteInterpreterOptionsAddDelegate(options, delegate);
-                  break;
-                }
-                case Delegate::AndroidGPU: {
-                  TfLiteGpuDelegateOptionsV2 delegateOptions = TfLiteGpuDelegateOptionsV2Default();
-                  auto delegate = TfLiteGpuDelegateV2Create(&delegateOptions);
-                  TfLiteInterpreterOptionsAddDelegate(options, delegate);
-                  break;
+              auto throwIfCancelled = [&]() {
+                if (isCancelled->load()) {
+                  throw std::runtime_error(cancelledMessage);
                 }
-#else
-                    case Delegate::NnApi: {
-                      callInvoker->invokeAsync([=]() { 
-                        promise->reject("Nnapi Delegate is only supported on Android!"); 
-                      });
-                    }
-                    case Delegate::AndroidGPU: {
-                      callInvoker->invokeAsync([=]() { 
-                        promise->reject("Android-Gpu Delegate is not supported on Android!"); 
-                      });
-                    }
-#endif
-                default: {
-                  // use default CPU delegate.
-                }
-              }
+              };
 
-              auto interpreter = TfLiteInterpreterCreate(model, options);
+              // Fetch model from URL (JS bundle) and load it into Tensorflow, unless it is
+              // already loaded. Other loads might wait for the same Model, so cancelling this load
+              // must not fail theirs - it is only checked once the shared load is done.
+              // `createModel` releases the Buffer if it fails.
+              auto model = ModelRegistry::shared().getOrLoad(
+                  ModelRegistry::getKey(modelPath),
+                  [&]() { return createModel(fetchURL(modelPath), modelPath); });
+              throwIfCancelled();
 
-              if (interpreter == nullptr) {
-                callInvoker->invokeAsync([=]() {
-                  promise->reject("Failed to create TFLite interpreter from model \"" + modelPath +
-                                  "\"!");
-                });
-                return;
-              }
+              // Create TensorFlow Interpreters, they all share the same Model and packed weights
+              auto weightsCache = createWeightsCache(options);
+              auto interpreterFactory = [=]() {
+                return createInterpreter(model, options, modelPath, weightsCache);
+              };
 
               // Initialize Model and allocate memory buffers
-              auto plugin = std::make_shared<TensorflowPlugin>(interpreter, buffer, delegateType,
-                                                               callInvoker);
+              auto plugin = std::make_shared<TensorflowPlugin>(interpreterFactory, options,
+                                                               callInvoker, promiseFactory);
+              throwIfCancelled();
+              plugin->warmUp(*isCancelled);
+              throwIfCancelled();
 
               callInvoker->invokeAsync([=, &runtime]() {
                 auto result = jsi::Object::createFromHostObject(runtime, plugin);
@@ -161,12 +315,335 @@ void TensorflowPlugin::installToRuntime(jsi::Runtime& runtime,
               std::string message = error.what();
               callInvoker->invokeAsync([=]() { promise->reject(message); });
             }
-          });
+          };
+          // Cancelled before it started. This is called on the JS Thread, from `cancel(..)`.
+          auto onCancelled = [=]() { promise->reject(cancelledMessage); };
+          loaderPool->enqueue(loadId, options.loadPriority, load, onCancelled);
         });
         return promise;
       });
 
   runtime.global().setProperty(runtime, "__loadTensorflowModel", func);
+
+  auto cancelFunc = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__cancelTensorflowModelLoad"), 1,
+      [=](jsi::Runtime&, const jsi::Value&, const jsi::Value* arguments, size_t) -> jsi::Value {
+        auto loadId = static_cast<uint64_t>(arguments[0].asNumber());
+        return jsi::Value(loaderPool->cancel(loadId));
+      });
+  runtime.global().setProperty(runtime, "__cancelTensorflowModelLoad", cancelFunc);
+
+  auto setConcurrencyFunc = jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forAscii(runtime, "__setTensorflowModelLoadConcurrency"), 1,
+      [=](jsi::Runtime&, const jsi::Value&, const jsi::Value* arguments, size_t) -> jsi::Value {
+        loaderPool->setMaxConcurrency(static_cast<size_t>(arguments[0].asNumber()));
+        return jsi::Value::undefined();
+      });
+  runtime.global().setProperty(runtime, "__setTensorflowModelLoadConcurrency", setConcurrencyFunc);
+}
+
+TensorflowPlugin::Delegate parseDelegate(const std::string& delegate) {
+  // TODO: Figure out how to use Metal/CoreML delegates
+  if (delegate == "core-ml") {
+    return TensorflowPlugin::Delegate::CoreML;
+  } else if (delegate == "metal") {
+    return TensorflowPlugin::Delegate::Metal;
+  } else if (delegate == "nnapi") {
+    return TensorflowPlugin::Delegate::NnApi;
+  } else if (delegate == "android-gpu") {
+    return TensorflowPlugin::Delegate::AndroidGPU;
+  } else {
+    return TensorflowPlugin::Delegate::Default;
+  }
+}
+
+std::vector<float> parseNumbers(jsi::Runtime& runtime, const jsi::Value& value) {
+  std::vector<float> result;
+  if (value.isNumber()) {
+    result.push_back(static_cast<float>(value.asNumber()));
+  } else if (value.isObject()) {
+    jsi::Array array = value.asObject(runtime).asArray(runtime);
+    size_t size = array.size(runtime);
+    result.reserve(size);
+    for (size_t i = 0; i < size; i++) {
+      result.push_back(static_cast<float>(array.getValueAtIndex(runtime, i).asNumber()));
+    }
+  }
+  return result;
+}
+
+std::optional<InputPreprocessing> parseInputPreprocessing(jsi::Runtime& runtime,
+                                                          const jsi::Value& value) {
+  if (!value.isObject()) {
+    // `null` or `undefined` - this input is copied as-is.
+    return std::nullopt;
+  }
+  jsi::Object object = value.asObject(runtime);
+  InputPreprocessing preprocessing;
+  preprocessing.mean = parseNumbers(runtime, object.getProperty(runtime, "mean"));
+  preprocessing.std = parseNumbers(runtime, object.getProperty(runtime, "std"));
+  jsi::Value swapRedBlue = object.getProperty(runtime, "swapRedBlue");
+  if (swapRedBlue.isBool()) {
+    preprocessing.swapRedBlue = swapRedBlue.getBool();
+  }
+  jsi::Value layout = object.getProperty(runtime, "layout");
+  if (layout.isString()) {
+    std::string layoutName = layout.asString(runtime).utf8(runtime);
+    if (layoutName == "nchw") {
+      preprocessing.toNCHW = true;
+    } else if (layoutName != "nhwc") {
+      [[unlikely]];
+      throw jsi::JSError(runtime, "TFLite: Unknown input layout \"" + layoutName + "\"!");
+    }
+  }
+  return preprocessing;
+}
+
+std::optional<OutputPostprocessing> parseOutputPostprocessing(jsi::Runtime& runtime,
+                                                            const jsi::Value& value) {
+  if (!value.isObject()) {
+    // `null` or `undefined` - this output is returned as-is.
+    return std::nullopt;
+  }
+  jsi::Object object = value.asObject(runtime);
+  OutputPostprocessing postprocessing;
+  jsi::Value topK = object.getProperty(runtime, "topK");
+  if (topK.isNumber()) {
+    postprocessing.topK = std::max(static_cast<size_t>(topK.asNumber()), static_cast<size_t>(1));
+  }
+  jsi::Value softmax = object.getProperty(runtime, "softmax");
+  if (softmax.isBool()) {
+    postprocessing.softmax = softmax.getBool();
+  }
+  return postprocessing;
+}
+
+DetectionOptions parseDetectionOptions(jsi::Runtime& runtime, const jsi::Object& object) {
+  DetectionOptions options;
+  jsi::Value format = object.getProperty(runtime, "format");
+  if (format.isString()) {
+    std::string formatName = format.asString(runtime).utf8(runtime);
+    if (formatName == "yolo") {
+      options.format = DetectionOptions::YOLO;
+    } else if (formatName != "ssd") {
+      [[unlikely]];
+      throw jsi::JSError(runtime, "TFLite: Unknown detection format \"" + formatName + "\"!");
+    }
+  }
+  jsi::Value boxesOutput = object.getProperty(runtime, "boxesOutput");
+  if (boxesOutput.isNumber()) {
+    options.boxesOutput = static_cast<size_t>(boxesOutput.asNumber());
+  }
+  jsi::Value scoresOutput = object.getProperty(runtime, "scoresOutput");
+  if (scoresOutput.isNumber()) {
+    options.scoresOutput = static_cast<size_t>(scoresOutput.asNumber());
+  }
+  options.anchors = parseNumbers(runtime, object.getProperty(runtime, "anchors"));
+  std::vector<float> boxScales = parseNumbers(runtime, object.getProperty(runtime, "boxScales"));
+  if (boxScales.size() == options.boxScales.size()) {
+    std::copy(boxScales.begin(), boxScales.end(), options.boxScales.begin());
+  }
+  jsi::Value scoreThreshold = object.getProperty(runtime, "scoreThreshold");
+  if (scoreThreshold.isNumber()) {
+    options.scoreThreshold = static_cast<float>(scoreThreshold.asNumber());
+  }
+  jsi::Value iouThreshold = object.getProperty(runtime, "iouThreshold");
+  if (iouThreshold.isNumber()) {
+    options.iouThreshold = static_cast<float>(iouThreshold.asNumber());
+  }
+  jsi::Value maxDetections = object.getProperty(runtime, "maxDetections");
+  if (maxDetections.isNumber()) {
+    options.maxDetections = static_cast<size_t>(maxDetections.asNumber());
+  }
+  jsi::Value classAgnostic = object.getProperty(runtime, "classAgnostic");
+  if (classAgnostic.isBool()) {
+    options.classAgnostic = classAgnostic.getBool();
+  }
+  jsi::Value sigmoid = object.getProperty(runtime, "sigmoid");
+  if (sigmoid.isBool()) {
+    options.sigmoid = sigmoid.getBool();
+  }
+  jsi::Value objectness = object.getProperty(runtime, "objectness");
+  if (objectness.isBool()) {
+    options.objectness = objectness.getBool();
+  }
+  jsi::Value skipBackgroundClass = object.getProperty(runtime, "skipBackgroundClass");
+  if (skipBackgroundClass.isBool()) {
+    options.skipBackgroundClass = skipBackgroundClass.getBool();
+  }
+  return options;
+}
+
+PixelFormat parsePixelFormat(jsi::Runtime& runtime, const std::string& format) {
+  if (format == "rgb") {
+    return PixelFormat::RGB;
+  } else if (format == "rgba") {
+    return PixelFormat::RGBA;
+  } else if (format == "bgra") {
+    return PixelFormat::BGRA;
+  } else if (format == "nv12") {
+    return PixelFormat::NV12;
+  } else if (format == "nv21") {
+    return PixelFormat::NV21;
+  } else if (format == "i420") {
+    return PixelFormat::I420;
+  }
+  [[unlikely]];
+  throw jsi::JSError(runtime, "TFLite: Unknown image format \"" + format + "\"!");
+}
+
+size_t getOptionalSize(jsi::Runtime& runtime, const jsi::Object& object, const char* name) {
+  jsi::Value value = object.getProperty(runtime, name);
+  return value.isNumber() ? static_cast<size_t>(value.asNumber()) : 0;
+}
+
+std::shared_ptr<ImageInput> parseImageInput(jsi::Runtime& runtime, const jsi::Object& object) {
+  jsi::Value dataValue = object.getProperty(runtime, "data");
+  if (!dataValue.isObject()) {
+    [[unlikely]];
+    throw jsi::JSError(runtime, "TFLite: Image input is missing its data!");
+  }
+  jsi::Object dataObject = dataValue.asObject(runtime);
+  uint8_t* data;
+  size_t byteLength;
+  if (dataObject.isArrayBuffer(runtime)) {
+    jsi::ArrayBuffer arrayBuffer = dataObject.getArrayBuffer(runtime);
+    data = arrayBuffer.data(runtime);
+    byteLength = arrayBuffer.size(runtime);
+  } else {
+    TypedArrayInfo info = getTypedArrayInfo(runtime, dataObject);
+    data = info.data;
+    byteLength = info.byteLength;
+  }
+
+  std::string format = object.getProperty(runtime, "format").asString(runtime).utf8(runtime);
+  auto image = std::make_shared<ImageInput>();
+  image->buffer = ImageProcessing::createImageBuffer(
+      data, byteLength, parsePixelFormat(runtime, format),
+      getOptionalSize(runtime, object, "width"), getOptionalSize(runtime, object, "height"),
+      getOptionalSize(runtime, object, "bytesPerRow"),
+      getOptionalSize(runtime, object, "uvOffset"),
+      getOptionalSize(runtime, object, "uvBytesPerRow"),
+      getOptionalSize(runtime, object, "vOffset"));
+
+  jsi::Value crop = object.getProperty(runtime, "crop");
+  if (crop.isObject()) {
+    jsi::Object cropObject = crop.asObject(runtime);
+    image->transform.cropX = cropObject.getProperty(runtime, "x").asNumber();
+    image->transform.cropY = cropObject.getProperty(runtime, "y").asNumber();
+    image->transform.cropWidth = cropObject.getProperty(runtime, "width").asNumber();
+    image->transform.cropHeight = cropObject.getProperty(runtime, "height").asNumber();
+  }
+  jsi::Value rotation = object.getProperty(runtime, "rotation");
+  if (rotation.isNumber()) {
+    image->transform.rotation = static_cast<int>(rotation.asNumber());
+  }
+  jsi::Value mirror = object.getProperty(runtime, "mirror");
+  if (mirror.isBool()) {
+    image->transform.mirror = mirror.getBool();
+  }
+  return image;
+}
+
+TensorflowPlugin::Options TensorflowPlugin::parseOptions(jsi::Runtime& runtime,
+                                                         const jsi::Value& value) {
+  Options options;
+  if (value.isString()) {
+    // user only passed a custom delegate
+    options.delegate = parseDelegate(value.asString(runtime).utf8(runtime));
+  } else if (value.isObject()) {
+    jsi::Object object = value.asObject(runtime);
+    jsi::Value delegate = object.getProperty(runtime, "delegate");
+    if (delegate.isString()) {
+      options.delegate = parseDelegate(delegate.asString(runtime).utf8(runtime));
+    }
+    jsi::Value loadPriority = object.getProperty(runtime, "loadPriority");
+    if (loadPriority.isNumber()) {
+      options.loadPriority = static_cast<int>(loadPriority.asNumber());
+    }
+    jsi::Value zeroCopyOutputs = object.getProperty(runtime, "zeroCopyOutputs");
+    if (zeroCopyOutputs.isBool()) {
+      options.zeroCopyOutputs = zeroCopyOutputs.getBool();
+    }
+    jsi::Value interpreterPoolSize = object.getProperty(runtime, "interpreterPoolSize");
+    if (interpreterPoolSize.isNumber()) {
+      options.interpreterPoolSize =
+          std::max(static_cast<size_t>(interpreterPoolSize.asNumber()), static_cast<size_t>(1));
+    }
+    jsi::Value batchWindowMs = object.getProperty(runtime, "batchWindowMs");
+    if (batchWindowMs.isNumber()) {
+      options.batchWindowMs = batchWindowMs.asNumber();
+    }
+    jsi::Value maxBatchSize = object.getProperty(runtime, "maxBatchSize");
+    if (maxBatchSize.isNumber()) {
+      options.maxBatchSize =
+          std::max(static_cast<size_t>(maxBatchSize.asNumber()), static_cast<size_t>(1));
+    }
+    jsi::Value pipelineDepth = object.getProperty(runtime, "pipelineDepth");
+    if (pipelineDepth.isNumber()) {
+      options.pipelineDepth =
+          std::max(static_cast<size_t>(pipelineDepth.asNumber()), static_cast<size_t>(1));
+    }
+    jsi::Value numThreads = object.getProperty(runtime, "numThreads");
+    if (numThreads.isNumber()) {
+      options.numThreads = static_cast<int>(numThreads.asNumber());
+    }
+    jsi::Value useFp16 = object.getProperty(runtime, "useFp16");
+    if (useFp16.isBool()) {
+      options.useFp16 = useFp16.getBool();
+    }
+    jsi::Value weightsCachePath = object.getProperty(runtime, "weightsCachePath");
+    if (weightsCachePath.isString()) {
+      std::string path = weightsCachePath.asString(runtime).utf8(runtime);
+      // Accept `file://` URLs as well as plain paths
+      const std::string filePrefix = "file://";
+      if (path.rfind(filePrefix, 0) == 0) {
+        path = path.substr(filePrefix.size());
+      }
+      options.weightsCachePath = path;
+    }
+    jsi::Value floatIO = object.getProperty(runtime, "floatIO");
+    if (floatIO.isBool()) {
+      options.floatIO = floatIO.getBool();
+    }
+    jsi::Value inputPreprocessing = object.getProperty(runtime, "inputPreprocessing");
+    if (inputPreprocessing.isObject()) {
+      jsi::Array array = inputPreprocessing.asObject(runtime).asArray(runtime);
+      for (size_t i = 0; i < array.size(runtime); i++) {
+        options.inputPreprocessing.push_back(
+            parseInputPreprocessing(runtime, array.getValueAtIndex(runtime, i)));
+      }
+    }
+    jsi::Value outputPostprocessing = object.getProperty(runtime, "outputPostprocessing");
+    if (outputPostprocessing.isObject()) {
+      jsi::Array array = outputPostprocessing.asObject(runtime).asArray(runtime);
+      for (size_t i = 0; i < array.size(runtime); i++) {
+        options.outputPostprocessing.push_back(
+            parseOutputPostprocessing(runtime, array.getValueAtIndex(runtime, i)));
+      }
+    }
+    jsi::Value detection = object.getProperty(runtime, "detection");
+    if (detection.isObject()) {
+      options.detection = parseDetectionOptions(runtime, detection.asObject(runtime));
+    }
+    jsi::Value warmupRuns = object.getProperty(runtime, "warmupRuns");
+    if (warmupRuns.isNumber()) {
+      options.warmupRuns = static_cast<size_t>(std::max(warmupRuns.asNumber(), 0.0));
+    }
+    jsi::Value warmupInputs = object.getProperty(runtime, "warmupInputs");
+    if (warmupInputs.isObject()) {
+      // Copied, since the warm-up runs on the loader Thread after this call returned.
+      jsi::Array array = warmupInputs.asObject(runtime).asArray(runtime);
+      auto inputs = std::make_shared<std::vector<std::vector<uint8_t>>>();
+      for (size_t i = 0; i < array.size(runtime); i++) {
+        TypedArrayInfo info =
+            getTypedArrayInfo(runtime, array.getValueAtIndex(runtime, i).asObject(runtime));
+        inputs->emplace_back(info.data, info.data + info.byteLength);
+      }
+      options.warmupInputs = inputs;
+    }
+  }
+  return options;
 }
 
 std::string tfLiteStatusToString(TfLiteStatus status) {
@@ -194,44 +671,227 @@ std::string tfLiteStatusToString(TfLiteStatus status) {
   }
 }
 
-TensorflowPlugin::TensorflowPlugin(TfLiteInterpreter* interpreter, Buffer model, Delegate delegate,
-                                   std::shared_ptr<react::CallInvoker> callInvoker)
-    : _interpreter(interpreter), _delegate(delegate), _model(model), _callInvoker(callInvoker) {
-  // Allocate memory for the model's input/output `TFLTensor`s.
-  TfLiteStatus status = TfLiteInterpreterAllocateTensors(_interpreter);
-  if (status != kTfLiteOk) {
-    [[unlikely]];
-    throw std::runtime_error(
-        "TFLite: Failed to allocate memory for input/output tensors! Status: " +
-        tfLiteStatusToString(status));
+/**
+ Rejects a run's Promise. Stopped runs get an error `code`, so JS can tell them apart from failures.
+ */
+void rejectRun(Promise& promise, const std::string& message) {
+  if (message == kRunCancelledMessage) {
+    promise.reject(message, "cancelled");
+  } else if (message == kRunDeadlineMessage) {
+    promise.reject(message, "deadline-exceeded");
+  } else {
+    promise.reject(message);
+  }
+}
+
+std::string getShapeSignature(const std::vector<std::vector<int>>& shapes) {
+  std::string signature;
+  for (const auto& shape : shapes) {
+    for (size_t i = 0; i < shape.size(); i++) {
+      if (i > 0) {
+        signature += "x";
+      }
+      signature += std::to_string(shape[i]);
+    }
+    signature += ";";
+  }
+  return signature;
+}
+
+TensorflowPlugin::TensorflowPlugin(InterpreterFactory createInterpreter, Options options,
+                                   std::shared_ptr<react::CallInvoker> callInvoker,
+                                   std::shared_ptr<PromiseFactory> promiseFactory)
+    : _createInterpreter(createInterpreter), _options(options), _callInvoker(callInvoker),
+      _promiseFactory(promiseFactory) {
+  if (_options.pipelineDepth > 1) {
+    // Every pipeline stage needs its own Interpreter.
+    _options.interpreterPoolSize = std::max(_options.interpreterPoolSize, _options.pipelineDepth);
   }
 
+  // Use the Model's original input shapes
+  auto state = createShapeState({});
+  _shapeStates[getShapeSignature({})] = state;
+  std::atomic_store(&_state, state);
+
+  // One worker Thread per Interpreter
+  _worker = std::make_unique<ThreadPool>("TFLite Inference", state->pool->size(), kMaxPendingRuns);
+
   log("Successfully created Tensorflow Plugin!");
 }
 
 TensorflowPlugin::~TensorflowPlugin() {
-  if (_model.data != nullptr) {
-    free(_model.data);
-    _model.data = nullptr;
-    _model.size = 0;
+  {
+    // Batch timers that fire from now on don't use the worker anymore.
+    std::unique_lock<std::mutex> lock(_pendingRunsMutex);
+    _pendingBatchId++;
+    _pendingRuns.clear();
+  }
+  // Wait for the currently running jobs to finish before we delete the Interpreters
+  _worker = nullptr;
+  std::atomic_store(&_state, std::shared_ptr<ShapeState>());
+  _shapeStates.clear();
+}
+
+std::vector<std::vector<int>> getInputShapes(TfLiteInterpreter* interpreter) {
+  int count = TfLiteInterpreterGetInputTensorCount(interpreter);
+  std::vector<std::vector<int>> shapes(count);
+  for (int i = 0; i < count; i++) {
+    const TfLiteTensor* tensor = TfLiteInterpreterGetInputTensor(interpreter, i);
+    for (int dim = 0; dim < TfLiteTensorNumDims(tensor); dim++) {
+      shapes[i].push_back(TfLiteTensorDim(tensor, dim));
+    }
+  }
+  return shapes;
+}
+
+size_t nextPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value) {
+    result *= 2;
   }
-  if (_interpreter != nullptr) {
-    TfLiteInterpreterDelete(_interpreter);
-    _interpreter = nullptr;
+  return result;
+}
+
+std::vector<std::shared_ptr<TfLiteInterpreter>>
+TensorflowPlugin::createInterpreters(const std::vector<std::vector<int>>& shapes, size_t count) {
+  std::vector<std::shared_ptr<TfLiteInterpreter>> interpreters;
+  for (size_t i = 0; i < count; i++) {
+    auto interpreter = _createInterpreter();
+
+    for (size_t input = 0; input < shapes.size(); input++) {
+      const auto& shape = shapes[input];
+      TfLiteStatus status = TfLiteInterpreterResizeInputTensor(
+          interpreter.get(), static_cast<int32_t>(input), shape.data(),
+          static_cast<int32_t>(shape.size()));
+      if (status != kTfLiteOk) {
+        [[unlikely]];
+        throw std::runtime_error("TFLite: Failed to resize input tensor " + std::to_string(input) +
+                                 "! Status: " + tfLiteStatusToString(status));
+      }
+    }
+
+    // Allocate memory for the model's input/output `TFLTensor`s.
+    TfLiteStatus status = TfLiteInterpreterAllocateTensors(interpreter.get());
+    if (status != kTfLiteOk) {
+      [[unlikely]];
+      throw std::runtime_error(
+          "TFLite: Failed to allocate memory for input/output tensors! Status: " +
+          tfLiteStatusToString(status));
+    }
+    interpreters.push_back(interpreter);
   }
+  return interpreters;
+}
+
+std::shared_ptr<TensorflowPlugin::ShapeState>
+TensorflowPlugin::createShapeState(const std::vector<std::vector<int>>& shapes) {
+  auto interpreters = createInterpreters(shapes, _options.interpreterPoolSize);
+
+  auto state = std::make_shared<ShapeState>();
+  state->interpreter = interpreters.front();
+  state->inputShapes = getInputShapes(state->interpreter.get());
+  state->pool = std::make_unique<InterpreterPool>(std::move(interpreters));
+  return state;
+}
+
+std::shared_ptr<TensorflowPlugin::ShapeState> TensorflowPlugin::getState() const {
+  return std::atomic_load(&_state);
+}
+
+void TensorflowPlugin::resizeInputs(const std::vector<std::vector<int>>& shapes) {
+  std::string signature = getShapeSignature(shapes);
+  std::unique_lock<std::mutex> lock(_shapeStatesMutex);
+  auto cached = _shapeStates.find(signature);
+  std::shared_ptr<ShapeState> state;
+  if (cached != _shapeStates.end()) {
+    // We already have Interpreters for these shapes, just switch to them.
+    state = cached->second;
+  } else {
+    state = createShapeState(shapes);
+
+    if (_shapeStates.size() >= kMaxCachedShapes) {
+      // Evict the least recently used shapes. Runs that still use it keep it alive until done.
+      auto leastRecentlyUsed = _shapeStates.begin();
+      for (auto it = _shapeStates.begin(); it != _shapeStates.end(); it++) {
+        if (it->second->lastUsed < leastRecentlyUsed->second->lastUsed) {
+          leastRecentlyUsed = it;
+        }
+      }
+      _shapeStates.erase(leastRecentlyUsed);
+    }
+
+    _shapeStates[signature] = state;
+  }
+  state->lastUsed = ++_shapeCounter;
+  std::atomic_store(&_state, state);
+}
+
+std::shared_ptr<InterpreterPool>
+TensorflowPlugin::getBatchPool(const std::vector<std::vector<int>>& shapes, size_t batchSize) {
+  // Stack the samples along the first (batch) dimension
+  std::vector<std::vector<int>> batchShapes = shapes;
+  for (size_t i = 0; i < batchShapes.size(); i++) {
+    if (batchShapes[i].empty()) {
+      [[unlikely]];
+      throw std::runtime_error("TFLite: Input tensor " + std::to_string(i) +
+                               " has no batch dimension!");
+    }
+    batchShapes[i][0] *= static_cast<int>(batchSize);
+  }
+
+  std::string signature = getShapeSignature(batchShapes);
+  std::unique_lock<std::mutex> lock(_batchStatesMutex);
+  auto cached = _batchStates.find(signature);
+  if (cached == _batchStates.end()) {
+    // Batched runs are throughput-bound, so one Interpreter per batch size is enough.
+    auto pool = std::make_shared<InterpreterPool>(createInterpreters(batchShapes, 1));
+
+    if (_batchStates.size() >= kMaxCachedShapes) {
+      auto leastRecentlyUsed = _batchStates.begin();
+      for (auto it = _batchStates.begin(); it != _batchStates.end(); it++) {
+        if (it->second.lastUsed < leastRecentlyUsed->second.lastUsed) {
+          leastRecentlyUsed = it;
+        }
+      }
+      _batchStates.erase(leastRecentlyUsed);
+    }
+    cached = _batchStates.emplace(signature, BatchState{.pool = pool}).first;
+  }
+  cached->second.lastUsed = ++_batchCounter;
+  return cached->second.pool;
 }
 
 std::shared_ptr<TypedArrayBase>
-TensorflowPlugin::getOutputArrayForTensor(jsi::Runtime& runtime, const TfLiteTensor* tensor) {
+TensorflowPlugin::getOutputArrayForTensor(jsi::Runtime& runtime, ShapeState& state,
+                                          const TfLiteTensor* tensor) {
+  auto name = std::string(TfLiteTensorName(tensor));
+  auto& outputBuffers = state.outputBuffers;
+  if (outputBuffers.find(name) == outputBuffers.end()) {
+    // With float IO, float16 and quantized outputs are converted into a Float32Array
+    TfLiteType dataType = isFloatIO(tensor) ? kTfLiteFloat32 : TfLiteTensorType(tensor);
+    outputBuffers[name] = std::make_shared<TypedArrayBase>(
+        TensorHelpers::createJSBufferForTensor(runtime, tensor, dataType));
+  }
+  return outputBuffers[name];
+}
+
+std::shared_ptr<TypedArrayBase> TensorflowPlugin::getTensorView(jsi::Runtime& runtime,
+                                                                const ShapeState& state,
+                                                                const TfLiteTensor* tensor,
+                                                                TensorViewCache& cache) {
   auto name = std::string(TfLiteTensorName(tensor));
-  if (_outputBuffers.find(name) == _outputBuffers.end()) {
-    _outputBuffers[name] =
-        std::make_shared<TypedArrayBase>(TensorHelpers::createJSBufferForTensor(runtime, tensor));
+  void* data = TfLiteTensorData(tensor);
+  auto cached = cache.find(name);
+  if (cached == cache.end() || cached->second.first != data) {
+    auto view = TensorHelpers::createJSBufferViewForTensor(runtime, tensor, state.interpreter);
+    cache[name] = std::make_pair(data, std::make_shared<TypedArrayBase>(std::move(view)));
   }
-  return _outputBuffers[name];
+  return cache[name].second;
 }
 
-void TensorflowPlugin::copyInputBuffers(jsi::Runtime& runtime, jsi::Object inputValues) {
+std::vector<TensorData> TensorflowPlugin::getInputData(jsi::Runtime& runtime,
+                                                       const ShapeState& state,
+                                                       const jsi::Object& inputValues) {
   // Input has to be array in input tensor size
 #if DEBUG
   if (!inputValues.isArray(runtime)) {
@@ -243,46 +903,741 @@ void TensorflowPlugin::copyInputBuffers(jsi::Runtime& runtime, jsi::Object input
 
   jsi::Array array = inputValues.asArray(runtime);
   size_t count = array.size(runtime);
-  if (count != TfLiteInterpreterGetInputTensorCount(_interpreter)) {
+  if (count != static_cast<size_t>(TfLiteInterpreterGetInputTensorCount(state.interpreter.get()))) {
     [[unlikely]];
     throw jsi::JSError(runtime,
                        "TFLite: Input Values have different size than there are input tensors!");
   }
 
+  std::vector<TensorData> inputs;
+  inputs.reserve(count);
   for (size_t i = 0; i < count; i++) {
-    TfLiteTensor* tensor = TfLiteInterpreterGetInputTensor(_interpreter, i);
+    TfLiteTensor* tensor = TfLiteInterpreterGetInputTensor(state.interpreter.get(), i);
     jsi::Object object = array.getValueAtIndex(runtime, i).asObject(runtime);
 
-#if DEBUG
-    if (!isTypedArray(runtime, object)) {
+    TypedArrayInfo inputBuffer;
+    try {
+      inputBuffer = getTypedArrayInfo(runtime, object);
+    } catch (std::runtime_error& error) {
+      if (object.hasProperty(runtime, "format")) {
+        // An image (e.g. a camera frame) that is sampled into the tensor natively
+        try {
+          inputs.push_back(TensorData{.data = nullptr,
+                                      .size = 0,
+                                      .image = parseImageInput(runtime, object)});
+        } catch (std::runtime_error& imageError) {
+          [[unlikely]];
+          throw jsi::JSError(runtime, imageError.what());
+        }
+        continue;
+      }
       [[unlikely]];
-      throw jsi::JSError(
-          runtime,
-          "TFLite: Input value is not a TypedArray! (Uint8Array, Uint16Array, Float32Array, etc.)");
+      throw jsi::JSError(runtime, "TFLite: Input value is not a TypedArray or an image! "
+                                  "(Uint8Array, Uint16Array, Float32Array, etc.)");
     }
-#endif
+    const InputPreprocessing* preprocessing = getInputPreprocessing(i);
+    if (preprocessing != nullptr) {
+      inputs.push_back(TensorHelpers::getPreprocessedJSBufferData(tensor, inputBuffer));
+    } else if (inputBuffer.kind == TypedArrayKind::Float32Array && isFloatIO(tensor)) {
+      inputs.push_back(TensorHelpers::getFloat32JSBufferData(tensor, inputBuffer));
+    } else {
+      inputs.push_back(TensorHelpers::getJSBufferData(tensor, inputBuffer));
+    }
+  }
+  return inputs;
+}
+
+const InputPreprocessing* TensorflowPlugin::getInputPreprocessing(size_t inputIndex) const {
+  if (inputIndex >= _options.inputPreprocessing.size() ||
+      !_options.inputPreprocessing[inputIndex].has_value()) {
+    return nullptr;
+  }
+  return &_options.inputPreprocessing[inputIndex].value();
+}
+
+const OutputPostprocessing* TensorflowPlugin::getOutputPostprocessing(size_t outputIndex) const {
+  if (outputIndex >= _options.outputPostprocessing.size() ||
+      !_options.outputPostprocessing[outputIndex].has_value()) {
+    return nullptr;
+  }
+  return &_options.outputPostprocessing[outputIndex].value();
+}
+
+bool TensorflowPlugin::isFloatIO(const TfLiteTensor* tensor) const {
+  return _options.floatIO && TensorHelpers::canConvertToFloat32(tensor);
+}
+
+void TensorflowPlugin::copyInputData(TfLiteInterpreter* interpreter,
+                                     const std::vector<TensorData>& inputs) {
+  InferenceStats::Timer timer(_stats, InferenceStats::Phase::Input);
+  for (size_t i = 0; i < inputs.size(); i++) {
+    TfLiteTensor* tensor = TfLiteInterpreterGetInputTensor(interpreter, i);
+    const InputPreprocessing* preprocessing = getInputPreprocessing(i);
+    if (inputs[i].image != nullptr) {
+      TensorHelpers::updateTensorFromImage(tensor, 0, *inputs[i].image, preprocessing);
+    } else if (preprocessing != nullptr) {
+      TensorHelpers::updateTensorFromData(tensor, 0, inputs[i], *preprocessing);
+    } else if (inputs[i].isFloat32) {
+      TensorHelpers::updateTensorFromFloat32Data(tensor, 0, inputs[i]);
+    } else {
+      TensorHelpers::updateTensorFromData(tensor, inputs[i]);
+    }
+  }
+}
+
+void TensorflowPlugin::copyInputBuffers(jsi::Runtime& runtime, const ShapeState& state,
+                                        jsi::Object inputValues) {
+  copyInputData(state.interpreter.get(), getInputData(runtime, state, inputValues));
+}
+
+std::shared_ptr<jsi::MutableBuffer>
+TensorflowPlugin::decodeDetections(TfLiteInterpreter* interpreter, size_t sample,
+                                   size_t batchSize) {
+  const DetectionOptions& options = _options.detection.value();
+  size_t outputTensorsCount = TfLiteInterpreterGetOutputTensorCount(interpreter);
+  bool usesScores = options.format == DetectionOptions::SSD;
+  if (options.boxesOutput >= outputTensorsCount ||
+      (usesScores && options.scoresOutput >= outputTensorsCount)) {
+    [[unlikely]];
+    throw std::runtime_error("TFLite: The detection outputs are out of range, the Model only has " +
+                             std::to_string(outputTensorsCount) + " outputs!");
+  }
+  const TfLiteTensor* boxes = TfLiteInterpreterGetOutputTensor(interpreter, options.boxesOutput);
+  const TfLiteTensor* scores =
+      usesScores ? TfLiteInterpreterGetOutputTensor(interpreter, options.scoresOutput) : nullptr;
+  return TensorHelpers::decodeDetections(boxes, scores, sample, batchSize, options);
+}
 
-    TypedArrayBase inputBuffer = getTypedArray(runtime, std::move(object));
-    TensorHelpers::updateTensorFromJSBuffer(runtime, tensor, inputBuffer);
+std::vector<TensorflowPlugin::OutputData>
+TensorflowPlugin::copyOutputData(TfLiteInterpreter* interpreter) {
+  // Decoding detections is output marshalling too, so it is measured as well.
+  InferenceStats::Timer timer(_stats, InferenceStats::Phase::Output);
+  if (_options.detection.has_value()) {
+    return {OutputData{.type = kTfLiteFloat32, .buffer = decodeDetections(interpreter, 0, 1)}};
+  }
+
+  int outputTensorsCount = TfLiteInterpreterGetOutputTensorCount(interpreter);
+  std::vector<OutputData> outputs;
+  outputs.reserve(outputTensorsCount);
+  for (int i = 0; i < outputTensorsCount; i++) {
+    const TfLiteTensor* outputTensor = TfLiteInterpreterGetOutputTensor(interpreter, i);
+    const OutputPostprocessing* postprocessing = getOutputPostprocessing(i);
+    size_t count = TfLiteTensorByteSize(outputTensor) /
+                   TensorHelpers::getTFLTensorDataTypeSize(TfLiteTensorType(outputTensor));
+    if (postprocessing != nullptr) {
+      outputs.push_back(OutputData{.type = kTfLiteFloat32,
+                                   .buffer = TensorHelpers::postprocessTensorData(
+                                       outputTensor, 0, count, *postprocessing)});
+    } else if (isFloatIO(outputTensor)) {
+      outputs.push_back(
+          OutputData{.type = kTfLiteFloat32,
+                     .buffer = TensorHelpers::copyTensorDataAsFloat32(outputTensor, 0, count)});
+    } else {
+      outputs.push_back(OutputData{.type = TfLiteTensorType(outputTensor),
+                                   .buffer = TensorHelpers::copyTensorData(outputTensor)});
+    }
+  }
+  return outputs;
+}
+
+jsi::Array TensorflowPlugin::createOutputArray(jsi::Runtime& runtime,
+                                               const std::vector<OutputData>& outputs) {
+  jsi::Array result(runtime, outputs.size());
+  for (size_t i = 0; i < outputs.size(); i++) {
+    auto outputBuffer =
+        TensorHelpers::createJSBufferForData(runtime, outputs[i].type, outputs[i].buffer);
+    result.setValueAtIndex(runtime, i, std::move(outputBuffer));
+  }
+  return result;
+}
+
+std::vector<std::vector<TensorflowPlugin::OutputData>>
+TensorflowPlugin::runBatch(const ShapeState& state,
+                           const std::vector<std::vector<TensorData>>& samples, size_t batchSize,
+                           const RunControl& control) {
+  auto pool = getBatchPool(state.inputShapes, batchSize);
+  auto interpreter = pool->acquire();
+
+  // 1. Pack all samples into the batched input tensors. If the batch is larger than the amount
+  // of samples, the remaining slots are just left as they are.
+  auto inputStart = std::chrono::steady_clock::now();
+  int inputTensorsCount = TfLiteInterpreterGetInputTensorCount(interpreter.get());
+  for (int i = 0; i < inputTensorsCount; i++) {
+    TfLiteTensor* tensor = TfLiteInterpreterGetInputTensor(interpreter.get(), i);
+    const InputPreprocessing* preprocessing = getInputPreprocessing(i);
+    size_t typeSize = TensorHelpers::getTFLTensorDataTypeSize(TfLiteTensorType(tensor));
+    size_t sampleCount = TfLiteTensorByteSize(tensor) / typeSize / batchSize;
+    for (size_t sample = 0; sample < samples.size(); sample++) {
+      const TensorData& data = samples[sample][i];
+      if (data.image != nullptr) {
+        TensorHelpers::updateTensorFromImage(tensor, sample * sampleCount, *data.image,
+                                             preprocessing);
+        continue;
+      }
+      // Preprocessed inputs have one byte per value, float IO inputs are float32 values.
+      size_t valueSize = typeSize;
+      if (preprocessing != nullptr) {
+        valueSize = 1;
+      } else if (data.isFloat32) {
+        valueSize = sizeof(float);
+      }
+      size_t sampleSize = sampleCount * valueSize;
+      if (data.size != sampleSize) {
+        [[unlikely]];
+        throw std::runtime_error("TFLite: Sample " + std::to_string(sample) + " has " +
+                                 std::to_string(data.size) + " bytes for input tensor " +
+                                 std::to_string(i) + ", expected " + std::to_string(sampleSize) +
+                                 " bytes!");
+      }
+      size_t offset = sample * sampleCount;
+      if (preprocessing != nullptr) {
+        TensorHelpers::updateTensorFromData(tensor, offset, data, *preprocessing);
+      } else if (data.isFloat32) {
+        TensorHelpers::updateTensorFromFloat32Data(tensor, offset, data);
+      } else {
+        TensorHelpers::updateTensorFromData(tensor, offset * typeSize, data);
+      }
+    }
+  }
+
+  _stats.recordSince(InferenceStats::Phase::Input, inputStart);
+
+  // 2. Run all samples at once
+  this->run(interpreter.get(), control);
+
+  // 3. Split the batched output tensors back into samples
+  InferenceStats::Timer outputTimer(_stats, InferenceStats::Phase::Output);
+  int outputTensorsCount = TfLiteInterpreterGetOutputTensorCount(interpreter.get());
+  std::vector<std::vector<OutputData>> outputs(samples.size());
+  if (_options.detection.has_value()) {
+    for (size_t sample = 0; sample < samples.size(); sample++) {
+      auto buffer = decodeDetections(interpreter.get(), sample, batchSize);
+      outputs[sample].push_back(OutputData{.type = kTfLiteFloat32, .buffer = buffer});
+    }
+    return outputs;
+  }
+  for (int i = 0; i < outputTensorsCount; i++) {
+    const TfLiteTensor* tensor = TfLiteInterpreterGetOutputTensor(interpreter.get(), i);
+    size_t byteSize = TfLiteTensorByteSize(tensor);
+    if (byteSize % batchSize != 0) {
+      [[unlikely]];
+      throw std::runtime_error("TFLite: Output tensor \"" + std::string(TfLiteTensorName(tensor)) +
+                               "\" is not batched!");
+    }
+    size_t sampleSize = byteSize / batchSize;
+    size_t sampleCount =
+        sampleSize / TensorHelpers::getTFLTensorDataTypeSize(TfLiteTensorType(tensor));
+    const OutputPostprocessing* postprocessing = getOutputPostprocessing(i);
+    bool isFloat32 = isFloatIO(tensor);
+    for (size_t sample = 0; sample < samples.size(); sample++) {
+      if (postprocessing != nullptr) {
+        auto buffer = TensorHelpers::postprocessTensorData(tensor, sample * sampleCount,
+                                                           sampleCount, *postprocessing);
+        outputs[sample].push_back(OutputData{.type = kTfLiteFloat32, .buffer = buffer});
+      } else if (isFloat32) {
+        auto buffer =
+            TensorHelpers::copyTensorDataAsFloat32(tensor, sample * sampleCount, sampleCount);
+        outputs[sample].push_back(OutputData{.type = kTfLiteFloat32, .buffer = buffer});
+      } else {
+        auto buffer = TensorHelpers::copyTensorData(tensor, sample * sampleSize, sampleSize);
+        outputs[sample].push_back(OutputData{.type = TfLiteTensorType(tensor), .buffer = buffer});
+      }
+    }
+  }
+  return outputs;
+}
+
+void TensorflowPlugin::runBatchAsync(jsi::Runtime& runtime, std::shared_ptr<ShapeState> state,
+                                     std::vector<std::vector<TensorData>> samples,
+                                     std::shared_ptr<jsi::Object> inputValues,
+                                     std::shared_ptr<Promise> promise, RunControl control) {
+  auto callInvoker = _callInvoker;
+  auto enqueuedAt = std::chrono::steady_clock::now();
+  bool isEnqueued = _worker->enqueue([=, &runtime]() mutable {
+    _stats.recordSince(InferenceStats::Phase::QueueWait, enqueuedAt);
+    std::vector<std::vector<OutputData>> outputs;
+    // Dropped without running if it was cancelled or missed its deadline while it waited.
+    std::string errorMessage = getStopReason(control);
+    try {
+      if (errorMessage.empty()) {
+        outputs = runBatch(*state, samples, samples.size(), control);
+      }
+    } catch (std::exception& error) {
+      errorMessage = error.what();
+    }
+
+    // Move all JS values back to the JS Thread, they must not be destroyed on this Thread.
+    callInvoker->invokeAsync([&runtime, promise = std::move(promise), state = std::move(state),
+                              inputValues = std::move(inputValues), outputs = std::move(outputs),
+                              errorMessage]() {
+      if (!errorMessage.empty()) {
+        [[unlikely]];
+        rejectRun(*promise, errorMessage);
+        return;
+      }
+
+      jsi::Array result(runtime, outputs.size());
+      for (size_t i = 0; i < outputs.size(); i++) {
+        result.setValueAtIndex(runtime, i, createOutputArray(runtime, outputs[i]));
+      }
+      promise->resolve(std::move(result));
+    });
+  });
+
+  if (!isEnqueued) {
+    [[unlikely]];
+    promise->reject("TFLite: Too many pending runs! (Max. " + std::to_string(kMaxPendingRuns) +
+                    ") Wait for previous runs to finish before calling runBatch(..) again.");
+  }
+}
+
+void TensorflowPlugin::enqueueBatchedRun(jsi::Runtime& runtime, PendingRun run) {
+  std::unique_lock<std::mutex> lock(_pendingRunsMutex);
+  _pendingRuns.push_back(std::move(run));
+  if (_pendingRuns.size() >= _options.maxBatchSize) {
+    // The batch is full, no need to wait for the time window to pass.
+    flushPendingRuns(runtime);
+    return;
+  }
+  if (_pendingRuns.size() > 1) {
+    // The timer of the first run flushes this one as well.
+    return;
+  }
+  uint64_t batchId = _pendingBatchId;
+  lock.unlock();
+
+  // No worker waits for the window to pass, the timer hands the batch to one once it's over.
+  auto window = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double, std::milli>(_options.batchWindowMs));
+  _deadlineTimer.schedule(std::chrono::steady_clock::now() + window, [this, &runtime, batchId]() {
+    std::unique_lock<std::mutex> lock(_pendingRunsMutex);
+    if (_pendingBatchId == batchId) {
+      flushPendingRuns(runtime);
+    }
+  });
+}
+
+void TensorflowPlugin::flushPendingRuns(jsi::Runtime& runtime) {
+  // Timers of the flushed batch must not flush the next one early.
+  _pendingBatchId++;
+  auto runs = std::make_shared<std::vector<PendingRun>>(std::move(_pendingRuns));
+  _pendingRuns.clear();
+  bool isEnqueued =
+      _worker->enqueue([this, &runtime, runs]() { processPendingRuns(runtime, std::move(*runs)); });
+  if (!isEnqueued) {
+    [[unlikely]];
+    // This might be the timer's Thread, so the runs are rejected on the JS Thread.
+    _callInvoker->invokeAsync([runs]() {
+      for (const auto& pendingRun : *runs) {
+        pendingRun.promise->reject(
+            "TFLite: Too many pending runs! (Max. " + std::to_string(kMaxPendingRuns) +
+            ") Wait for previous runs to finish before calling run(..) again.");
+      }
+    });
+  }
+}
+
+void TensorflowPlugin::processPendingRuns(jsi::Runtime& runtime, std::vector<PendingRun> runs) {
+  while (!runs.empty()) {
+    // Only runs with the same input shapes can be batched
+    std::vector<PendingRun> batch;
+    ShapeState* state = runs.front().state.get();
+    for (auto it = runs.begin(); it != runs.end() && batch.size() < _options.maxBatchSize;) {
+      if (it->state.get() == state) {
+        batch.push_back(std::move(*it));
+        it = runs.erase(it);
+      } else {
+        it++;
+      }
+    }
+    runPendingRuns(runtime, std::move(batch));
+  }
+}
+
+void TensorflowPlugin::runPendingRuns(jsi::Runtime& runtime, std::vector<PendingRun> runs) {
+  // Runs that were cancelled or missed their deadline while they waited are dropped.
+  std::vector<std::pair<PendingRun, std::string>> droppedRuns;
+  for (auto it = runs.begin(); it != runs.end();) {
+    _stats.recordSince(InferenceStats::Phase::QueueWait, it->enqueuedAt);
+    std::string stopReason = getStopReason(it->control);
+    if (!stopReason.empty()) {
+      droppedRuns.emplace_back(std::move(*it), stopReason);
+      it = runs.erase(it);
+    } else {
+      it++;
+    }
+  }
+
+  std::vector<std::vector<OutputData>> outputs;
+  std::string errorMessage;
+  try {
+    if (runs.size() == 1) {
+      // Nothing to merge, use the unbatched Interpreters.
+      const PendingRun& run = runs.front();
+      auto interpreter = run.state->pool->acquire();
+      copyInputData(interpreter.get(), run.inputs);
+      this->run(interpreter.get(), run.control);
+      outputs.push_back(copyOutputData(interpreter.get()));
+    } else if (runs.size() > 1) {
+      std::vector<std::vector<TensorData>> samples;
+      samples.reserve(runs.size());
+      // The batch is only stopped once none of its runs need the result anymore.
+      RunControl control = runs.front().control;
+      for (const auto& run : runs) {
+        samples.push_back(run.inputs);
+        control.deadline = std::max(control.deadline, run.control.deadline);
+      }
+      // Round up to a power of two so we only need Interpreters for a few batch sizes.
+      size_t batchSize = std::min(nextPowerOfTwo(runs.size()), _options.maxBatchSize);
+      outputs = runBatch(*runs.front().state, samples, batchSize, control);
+    }
+  } catch (std::exception& error) {
+    errorMessage = error.what();
+  }
+
+  // Move all JS values back to the JS Thread, they must not be destroyed on this Thread.
+  _callInvoker->invokeAsync([&runtime, runs = std::move(runs), outputs = std::move(outputs),
+                             droppedRuns = std::move(droppedRuns), errorMessage]() {
+    for (size_t i = 0; i < runs.size(); i++) {
+      if (!errorMessage.empty()) {
+        [[unlikely]];
+        rejectRun(*runs[i].promise, errorMessage);
+      } else {
+        runs[i].promise->resolve(createOutputArray(runtime, outputs[i]));
+      }
+    }
+    for (const auto& [run, stopReason] : droppedRuns) {
+      rejectRun(*run.promise, stopReason);
+    }
+  });
+}
+
+void TensorflowPlugin::enqueueLatestRun(jsi::Runtime& runtime, PendingRun run) {
+  std::unique_lock<std::mutex> lock(_latestRunMutex);
+  std::optional<PendingRun> droppedRun = std::move(_latestRun);
+  _latestRun = std::move(run);
+  bool needsWorker = !_isProcessingLatestRun;
+  _isProcessingLatestRun = true;
+  lock.unlock();
+
+  if (droppedRun.has_value()) {
+    // A newer frame arrived before the previous one started, so we skip the previous one.
+    _droppedFrames++;
+    droppedRun->promise->resolve(jsi::Value::undefined());
+  }
+  if (!needsWorker) {
+    // The worker will pick up this run once the current one is done.
+    return;
+  }
+
+  bool isEnqueued = _worker->enqueue([this, &runtime]() { processLatestRun(runtime); });
+  if (!isEnqueued) {
+    [[unlikely]];
+    lock.lock();
+    std::optional<PendingRun> rejectedRun = std::move(_latestRun);
+    _latestRun.reset();
+    _isProcessingLatestRun = false;
+    lock.unlock();
+    if (rejectedRun.has_value()) {
+      rejectedRun->promise->reject(
+          "TFLite: Too many pending runs! (Max. " + std::to_string(kMaxPendingRuns) +
+          ") Wait for previous runs to finish before calling runLatest(..) again.");
+    }
   }
 }
 
-jsi::Value TensorflowPlugin::copyOutputBuffers(jsi::Runtime& runtime) {
+void TensorflowPlugin::processLatestRun(jsi::Runtime& runtime) {
+  std::unique_lock<std::mutex> lock(_latestRunMutex);
+  while (_latestRun.has_value()) {
+    PendingRun run = std::move(*_latestRun);
+    _latestRun.reset();
+    lock.unlock();
+    runPendingRuns(runtime, {std::move(run)});
+    lock.lock();
+  }
+  _isProcessingLatestRun = false;
+}
+
+jsi::Value TensorflowPlugin::copyOutputBuffers(jsi::Runtime& runtime, ShapeState& state) {
   // Copy output to result process the inference results.
-  int outputTensorsCount = TfLiteInterpreterGetOutputTensorCount(_interpreter);
+  InferenceStats::Timer timer(_stats, InferenceStats::Phase::Output);
+  TfLiteInterpreter* interpreter = state.interpreter.get();
+  if (_options.detection.has_value()) {
+    auto detections = decodeDetections(interpreter, 0, 1);
+    jsi::Array result(runtime, 1);
+    result.setValueAtIndex(
+        runtime, 0, TensorHelpers::createJSBufferForData(runtime, kTfLiteFloat32, detections));
+    return result;
+  }
+  int outputTensorsCount = TfLiteInterpreterGetOutputTensorCount(interpreter);
   jsi::Array result(runtime, outputTensorsCount);
-  for (size_t i = 0; i < outputTensorsCount; i++) {
-    const TfLiteTensor* outputTensor = TfLiteInterpreterGetOutputTensor(_interpreter, i);
-    auto outputBuffer = getOutputArrayForTensor(runtime, outputTensor);
-    TensorHelpers::updateJSBufferFromTensor(runtime, *outputBuffer, outputTensor);
-    result.setValueAtIndex(runtime, i, *outputBuffer);
+  for (int i = 0; i < outputTensorsCount; i++) {
+    const TfLiteTensor* outputTensor = TfLiteInterpreterGetOutputTensor(interpreter, i);
+    const OutputPostprocessing* postprocessing = getOutputPostprocessing(i);
+    if (postprocessing != nullptr) {
+      // The result is small, so it is just copied into a new TypedArray every time.
+      size_t count = TfLiteTensorByteSize(outputTensor) /
+                     TensorHelpers::getTFLTensorDataTypeSize(TfLiteTensorType(outputTensor));
+      auto data = TensorHelpers::postprocessTensorData(outputTensor, 0, count, *postprocessing);
+      result.setValueAtIndex(runtime, i,
+                             TensorHelpers::createJSBufferForData(runtime, kTfLiteFloat32, data));
+    } else if (isFloatIO(outputTensor)) {
+      // Converted outputs can never point to the output tensor's memory.
+      auto outputBuffer = getOutputArrayForTensor(runtime, state, outputTensor);
+      TensorHelpers::updateFloat32JSBufferFromTensor(runtime, *outputBuffer, outputTensor);
+      result.setValueAtIndex(runtime, i, *outputBuffer);
+    } else if (_options.zeroCopyOutputs) {
+      // The TypedArray already points to the output tensor's memory.
+      auto outputView = getTensorView(runtime, state, outputTensor, state.outputViews);
+      result.setValueAtIndex(runtime, i, *outputView);
+    } else {
+      auto outputBuffer = getOutputArrayForTensor(runtime, state, outputTensor);
+      TensorHelpers::updateJSBufferFromTensor(runtime, *outputBuffer, outputTensor);
+      result.setValueAtIndex(runtime, i, *outputBuffer);
+    }
   }
   return result;
 }
 
-void TensorflowPlugin::run() {
-  // Run Model
-  TfLiteStatus status = TfLiteInterpreterInvoke(_interpreter);
+jsi::Object createLatencyStatsObject(jsi::Runtime& runtime, const LatencyHistogram& histogram) {
+  LatencyHistogram::Summary summary = histogram.getSummary();
+  jsi::Object result(runtime);
+  result.setProperty(runtime, "count", static_cast<double>(summary.count));
+  result.setProperty(runtime, "mean", summary.mean);
+  result.setProperty(runtime, "p50", summary.p50);
+  result.setProperty(runtime, "p95", summary.p95);
+  result.setProperty(runtime, "p99", summary.p99);
+  result.setProperty(runtime, "max", summary.max);
+  return result;
+}
+
+jsi::Object TensorflowPlugin::createStatsObject(jsi::Runtime& runtime) const {
+  jsi::Object result(runtime);
+  for (size_t i = 0; i < InferenceStats::kPhaseCount; i++) {
+    auto phase = static_cast<InferenceStats::Phase>(i);
+    result.setProperty(runtime, InferenceStats::getPhaseName(phase),
+                       createLatencyStatsObject(runtime, _stats.get(phase)));
+  }
+  result.setProperty(runtime, "warmup", createLatencyStatsObject(runtime, _warmupStats));
+  return result;
+}
+
+void TensorflowPlugin::runAsync(jsi::Runtime& runtime, std::shared_ptr<ShapeState> state,
+                                std::vector<TensorData> inputs,
+                                std::shared_ptr<jsi::Object> inputValues,
+                                std::shared_ptr<Promise> promise, RunControl control) {
+  auto callInvoker = _callInvoker;
+  bool isPipelined = _options.pipelineDepth > 1;
+  // Pipelined runs are enqueued in the order of their sequence numbers, so the workers never all
+  // wait for an earlier run that is still queued behind them.
+  std::unique_lock<std::mutex> sequenceLock(_pipelineSequenceMutex, std::defer_lock);
+  uint64_t sequence = 0;
+  if (isPipelined) {
+    sequenceLock.lock();
+    sequence = _pipelineSequence++;
+  }
+  // In pipelined mode, only one run can invoke at a time (in order), while the others copy their
+  // inputs and outputs. Otherwise runs are fully independent.
+  auto acquire = [this, isPipelined, sequence](InterpreterPool& pool) {
+    return isPipelined ? _pipeline.acquire(sequence, pool) : pool.acquire();
+  };
+  auto invoke = [this, isPipelined, sequence](const std::function<void()>& func) {
+    if (isPipelined) {
+      _pipeline.invoke(sequence, func);
+    } else {
+      func();
+    }
+  };
+  auto finish = [this, isPipelined, sequence](const std::function<void()>& func) {
+    if (isPipelined) {
+      _pipeline.finish(sequence, func);
+    } else {
+      func();
+    }
+  };
+
+  auto enqueuedAt = std::chrono::steady_clock::now();
+  bool isEnqueued = _worker->enqueue([=, &runtime]() mutable {
+    _stats.recordSince(InferenceStats::Phase::QueueWait, enqueuedAt);
+    std::vector<OutputData> outputs;
+    // Dropped without running if it was cancelled or missed its deadline while it waited.
+    std::string errorMessage = getStopReason(control);
+    {
+      // Runs acquire in order, otherwise a later run could take the last free Interpreter (e.g.
+      // if `getInputBuffer(..)` reserved the primary one) and wait for an earlier run to invoke.
+      auto interpreter = acquire(*state->pool);
+      try {
+        // 2.
+        if (errorMessage.empty()) {
+          copyInputData(interpreter.get(), inputs);
+        }
+      } catch (std::exception& error) {
+        errorMessage = error.what();
+      }
+      // 3. Even failed runs need to pass, otherwise the next runs would wait forever.
+      invoke([&]() {
+        try {
+          if (errorMessage.empty()) {
+            this->run(interpreter.get(), control);
+          }
+        } catch (std::exception& error) {
+          errorMessage = error.what();
+        }
+      });
+      try {
+        // 4.
+        if (errorMessage.empty()) {
+          outputs = copyOutputData(interpreter.get());
+        }
+      } catch (std::exception& error) {
+        errorMessage = error.what();
+      }
+    }
+
+    // Move all JS values back to the JS Thread, they must not be destroyed on this Thread.
+    // The ShapeState holds JS values too. The JS Thread runs them in the order they were added,
+    // so in pipelined mode the results arrive in order.
+    finish([&]() {
+      callInvoker->invokeAsync([&runtime, promise = std::move(promise), state = std::move(state),
+                                inputValues = std::move(inputValues),
+                                outputs = std::move(outputs), errorMessage]() {
+        if (!errorMessage.empty()) {
+          [[unlikely]];
+          rejectRun(*promise, errorMessage);
+          return;
+        }
+
+        // 5.
+        promise->resolve(createOutputArray(runtime, outputs));
+      });
+    });
+  });
+
+  if (!isEnqueued) {
+    [[unlikely]];
+    if (isPipelined) {
+      // The sequence number is taken, so let the later runs pass it.
+      _pipeline.skip(sequence);
+      sequenceLock.unlock();
+    }
+    promise->reject("TFLite: Too many pending runs! (Max. " + std::to_string(kMaxPendingRuns) +
+                    ") Wait for previous runs to finish before calling run(..) again.");
+  }
+}
+
+void TensorflowPlugin::warmUp(const std::atomic<bool>& isCancelled) {
+  if (_options.warmupRuns == 0) {
+    return;
+  }
+  auto state = getState();
+  for (size_t index = 0; index < state->pool->size(); index++) {
+    auto interpreter = state->pool->acquire(index);
+    size_t inputCount = TfLiteInterpreterGetInputTensorCount(interpreter.get());
+    if (_options.warmupInputs != nullptr && _options.warmupInputs->size() != inputCount) {
+      [[unlikely]];
+      throw std::runtime_error("TFLite: Warm-up inputs have different size than there are input "
+                               "tensors!");
+    }
+    for (size_t i = 0; i < inputCount; i++) {
+      TfLiteTensor* tensor = TfLiteInterpreterGetInputTensor(interpreter.get(), i);
+      if (_options.warmupInputs != nullptr) {
+        auto& input = (*_options.warmupInputs)[i];
+        TensorData data{.data = const_cast<uint8_t*>(input.data()), .size = input.size()};
+        TensorHelpers::updateTensorFromData(tensor, data);
+      } else {
+        // Freshly allocated tensors contain whatever was in the arena before.
+        memset(TfLiteTensorData(tensor), 0, TfLiteTensorByteSize(tensor));
+      }
+    }
+
+    for (size_t run = 0; run < _options.warmupRuns; run++) {
+      if (isCancelled.load()) {
+        // The load is cancelled, so there is no need to finish warming up.
+        return;
+      }
+      auto start = std::chrono::steady_clock::now();
+      TfLiteStatus status = TfLiteInterpreterInvoke(interpreter.get());
+      if (status != kTfLiteOk) {
+        [[unlikely]];
+        throw std::runtime_error("TFLite: Failed to warm up TFLite Model! Status: " +
+                                 tfLiteStatusToString(status));
+      }
+      auto duration = std::chrono::steady_clock::now() - start;
+      _warmupStats.record(
+          std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    }
+  }
+  log("Warmed up Tensorflow Model with %zu runs, the slowest took %.1f ms.", _options.warmupRuns,
+      _warmupStats.getSummary().max);
+}
+
+TensorflowPlugin::RunControl TensorflowPlugin::createRunControl(jsi::Runtime& runtime,
+                                                               const jsi::Value* runOptions) const {
+  RunControl control{.cancelGeneration = _cancelGeneration.load()};
+  if (runOptions != nullptr && runOptions->isObject()) {
+    jsi::Value timeoutMs = runOptions->asObject(runtime).getProperty(runtime, "timeoutMs");
+    if (timeoutMs.isNumber()) {
+      // The deadline includes the time the run waits for the worker Thread.
+      auto timeout = std::chrono::duration<double, std::milli>(timeoutMs.asNumber());
+      control.deadline = std::chrono::steady_clock::now() +
+                         std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+    }
+  }
+  return control;
+}
+
+std::string TensorflowPlugin::getStopReason(const RunControl& control) const {
+  if (control.cancelGeneration.has_value() &&
+      control.cancelGeneration.value() != _cancelGeneration.load()) {
+    return kRunCancelledMessage;
+  }
+  if (std::chrono::steady_clock::now() >= control.deadline) {
+    return kRunDeadlineMessage;
+  }
+  return "";
+}
+
+void TensorflowPlugin::cancelRuns() {
+  // Runs that did not invoke yet see the new generation, running async invocations are
+  // interrupted. A `runSync` call on the primary Interpreter is never interrupted.
+  _cancelGeneration++;
+  {
+    std::unique_lock<std::mutex> lock(_shapeStatesMutex);
+    for (const auto& [signature, state] : _shapeStates) {
+      state->pool->cancelAsyncRuns();
+    }
+  }
+  std::unique_lock<std::mutex> lock(_batchStatesMutex);
+  for (const auto& [signature, batchState] : _batchStates) {
+    batchState.pool->cancelAsyncRuns();
+  }
+}
+
+void TensorflowPlugin::run(TfLiteInterpreter* interpreter, const RunControl& control) {
+  std::string stopReason = getStopReason(control);
+  if (!stopReason.empty()) {
+    throw std::runtime_error(stopReason);
+  }
+
+  std::optional<uint64_t> deadlineId;
+  if (control.deadline != std::chrono::steady_clock::time_point::max()) {
+    deadlineId = _deadlineTimer.schedule(control.deadline,
+                                         [interpreter]() { TfLiteInterpreterCancel(interpreter); });
+  }
+  TfLiteStatus status;
+  {
+    InferenceStats::Timer timer(_stats, InferenceStats::Phase::Invoke);
+    // Run Model
+    status = TfLiteInterpreterInvoke(interpreter);
+  }
+  if (deadlineId.has_value()) {
+    _deadlineTimer.cancel(*deadlineId);
+  }
+
+  if (status == kTfLiteCancelled) {
+    stopReason = getStopReason(control);
+    throw std::runtime_error(stopReason.empty() ? kRunCancelledMessage : stopReason);
+  }
   if (status != kTfLiteOk) {
     [[unlikely]];
     throw std::runtime_error("TFLite: Failed to run TFLite Model! Status: " +
@@ -296,46 +1651,174 @@ jsi::Value TensorflowPlugin::get(jsi::Runtime& runtime, const jsi::PropNameID& p
   if (propName == "runSync") {
     return jsi::Function::createFromHostFunction(
         runtime, jsi::PropNameID::forAscii(runtime, "runModel"), 1,
-        [=](jsi::Runtime& runtime, const jsi::Value& thisValue, const jsi::Value* arguments,
-            size_t count) -> jsi::Value {
+        [=](jsi::Runtime& runtime, const jsi::Value&, const jsi::Value* arguments,
+            size_t) -> jsi::Value {
+          // Always use the primary Interpreter, since `getInputBuffer` and `zeroCopyOutputs`
+          // point to its tensors. A worker Thread might currently use it for an async run.
+          auto state = getState();
+          auto interpreter = state->pool->acquire(0);
           // 1.
-          copyInputBuffers(runtime, arguments[0].asObject(runtime));
-          // 2.
-          this->run();
+          copyInputBuffers(runtime, *state, arguments[0].asObject(runtime));
+          // 2. `runSync` can't be cancelled and has no deadline.
+          this->run(interpreter.get(), RunControl());
           // 3.
-          return copyOutputBuffers(runtime);
+          return copyOutputBuffers(runtime, *state);
         });
   } else if (propName == "run") {
     return jsi::Function::createFromHostFunction(
         runtime, jsi::PropNameID::forAscii(runtime, "runModel"), 1,
-        [=](jsi::Runtime& runtime, const jsi::Value& thisValue, const jsi::Value* arguments,
+        [=](jsi::Runtime& runtime, const jsi::Value&, const jsi::Value* arguments,
             size_t count) -> jsi::Value {
-          // 1.
-          copyInputBuffers(runtime, arguments[0].asObject(runtime));
-          auto promise =
-              Promise::createPromise(runtime, [=, &runtime](std::shared_ptr<Promise> promise) {
-                std::async(std::launch::async, [=, &runtime]() {
-                  // 2.
-                  try {
-                    this->run();
-
-                    this->_callInvoker->invokeAsync([=, &runtime]() {
-                      // 3.
-                      auto result = this->copyOutputBuffers(runtime);
-                      promise->resolve(std::move(result));
-                    });
-                  } catch (std::exception& error) {
-                    promise->reject(error.what());
-                  }
-                });
+          // 1. The input data is read directly from the JS buffers on the worker Thread, so we
+          // need to keep them alive until the run is finished.
+          auto state = getState();
+          auto inputValues = std::make_shared<jsi::Object>(arguments[0].asObject(runtime));
+          auto inputs = getInputData(runtime, *state, *inputValues);
+          auto control = createRunControl(runtime, count > 1 ? &arguments[1] : nullptr);
+          return _promiseFactory->createPromise(
+              runtime, [=, &runtime](std::shared_ptr<Promise> promise) {
+                if (_options.batchWindowMs > 0) {
+                  enqueueBatchedRun(runtime, PendingRun{.state = state,
+                                                        .inputs = inputs,
+                                                        .inputValues = inputValues,
+                                                        .promise = promise,
+                                                        .control = control});
+                } else {
+                  runAsync(runtime, state, inputs, inputValues, promise, control);
+                }
               });
-          return promise;
+        });
+  } else if (propName == "runLatest") {
+    return jsi::Function::createFromHostFunction(
+        runtime, jsi::PropNameID::forAscii(runtime, "runLatest"), 1,
+        [=](jsi::Runtime& runtime, const jsi::Value&, const jsi::Value* arguments,
+            size_t count) -> jsi::Value {
+          auto state = getState();
+          auto inputValues = std::make_shared<jsi::Object>(arguments[0].asObject(runtime));
+          auto inputs = getInputData(runtime, *state, *inputValues);
+          auto control = createRunControl(runtime, count > 1 ? &arguments[1] : nullptr);
+          return _promiseFactory->createPromise(
+              runtime, [=, &runtime](std::shared_ptr<Promise> promise) {
+                enqueueLatestRun(runtime, PendingRun{.state = state,
+                                                     .inputs = inputs,
+                                                     .inputValues = inputValues,
+                                                     .promise = promise,
+                                                     .control = control});
+              });
+        });
+  } else if (propName == "droppedFrames") {
+    return jsi::Value(static_cast<double>(_droppedFrames));
+  } else if (propName == "stats") {
+    return createStatsObject(runtime);
+  } else if (propName == "cancel") {
+    return jsi::Function::createFromHostFunction(
+        runtime, jsi::PropNameID::forAscii(runtime, "cancel"), 0,
+        [=](jsi::Runtime&, const jsi::Value&, const jsi::Value*, size_t) -> jsi::Value {
+          cancelRuns();
+          return jsi::Value::undefined();
+        });
+  } else if (propName == "resetStats") {
+    return jsi::Function::createFromHostFunction(
+        runtime, jsi::PropNameID::forAscii(runtime, "resetStats"), 0,
+        [=](jsi::Runtime&, const jsi::Value&, const jsi::Value*, size_t) -> jsi::Value {
+          _stats.reset();
+          return jsi::Value::undefined();
+        });
+  } else if (propName == "runBatch") {
+    return jsi::Function::createFromHostFunction(
+        runtime, jsi::PropNameID::forAscii(runtime, "runBatch"), 1,
+        [=](jsi::Runtime& runtime, const jsi::Value&, const jsi::Value* arguments,
+            size_t count) -> jsi::Value {
+          auto state = getState();
+          // The input data is read directly from the JS buffers on the worker Thread, so we need
+          // to keep them alive until the run is finished.
+          auto inputValues = std::make_shared<jsi::Object>(arguments[0].asObject(runtime));
+          jsi::Array array = inputValues->asArray(runtime);
+          size_t size = array.size(runtime);
+          if (size == 0) {
+            [[unlikely]];
+            throw jsi::JSError(runtime, "TFLite: runBatch(..) needs at least one sample!");
+          }
+
+          std::vector<std::vector<TensorData>> samples;
+          samples.reserve(size);
+          for (size_t i = 0; i < size; i++) {
+            samples.push_back(
+                getInputData(runtime, *state, array.getValueAtIndex(runtime, i).asObject(runtime)));
+          }
+          auto control = createRunControl(runtime, count > 1 ? &arguments[1] : nullptr);
+          return _promiseFactory->createPromise(
+              runtime, [=, &runtime](std::shared_ptr<Promise> promise) {
+                runBatchAsync(runtime, state, samples, inputValues, promise, control);
+              });
+        });
+  } else if (propName == "resizeInputs") {
+    return jsi::Function::createFromHostFunction(
+        runtime, jsi::PropNameID::forAscii(runtime, "resizeInputs"), 1,
+        [=](jsi::Runtime& runtime, const jsi::Value&, const jsi::Value* arguments,
+            size_t) -> jsi::Value {
+          jsi::Array array = arguments[0].asObject(runtime).asArray(runtime);
+          size_t size = array.size(runtime);
+          if (size != static_cast<size_t>(
+                          TfLiteInterpreterGetInputTensorCount(getState()->interpreter.get()))) {
+            [[unlikely]];
+            throw jsi::JSError(runtime,
+                               "TFLite: Input shapes have different size than there are input "
+                               "tensors!");
+          }
+
+          std::vector<std::vector<int>> shapes;
+          shapes.reserve(size);
+          for (size_t i = 0; i < size; i++) {
+            jsi::Array shape = array.getValueAtIndex(runtime, i).asObject(runtime).asArray(runtime);
+            std::vector<int> dims;
+            dims.reserve(shape.size(runtime));
+            for (size_t dim = 0; dim < shape.size(runtime); dim++) {
+              dims.push_back(static_cast<int>(shape.getValueAtIndex(runtime, dim).asNumber()));
+            }
+            shapes.push_back(std::move(dims));
+          }
+
+          try {
+            resizeInputs(shapes);
+          } catch (std::exception& error) {
+            throw jsi::JSError(runtime, error.what());
+          }
+          return jsi::Value::undefined();
+        });
+  } else if (propName == "getInputBuffer") {
+    return jsi::Function::createFromHostFunction(
+        runtime, jsi::PropNameID::forAscii(runtime, "getInputBuffer"), 1,
+        [=](jsi::Runtime& runtime, const jsi::Value&, const jsi::Value* arguments,
+            size_t count) -> jsi::Value {
+          int index = count > 0 ? static_cast<int>(arguments[0].asNumber()) : 0;
+          auto state = getState();
+          int size = TfLiteInterpreterGetInputTensorCount(state->interpreter.get());
+          if (index < 0 || index >= size) {
+            [[unlikely]];
+            throw jsi::JSError(runtime, "TFLite: Input tensor index " + std::to_string(index) +
+                                            " is out of range! (Model has " +
+                                            std::to_string(size) + " input tensors)");
+          }
+
+          // The view points to the primary Interpreter's tensor, so async runs must not use it.
+          if (state->pool->isAcquiredForAsyncRun(0)) {
+            [[unlikely]];
+            throw jsi::JSError(runtime, "TFLite: getInputBuffer(..) can't be used while a run(..) "
+                                        "uses the same interpreter! Wait for the run to finish, "
+                                        "or set interpreterPoolSize to 2 or more.");
+          }
+          state->pool->reservePrimary();
+
+          TfLiteTensor* tensor = TfLiteInterpreterGetInputTensor(state->interpreter.get(), index);
+          return jsi::Value(runtime, *getTensorView(runtime, *state, tensor, state->inputViews));
         });
   } else if (propName == "inputs") {
-    int size = TfLiteInterpreterGetInputTensorCount(_interpreter);
+    auto state = getState();
+    int size = TfLiteInterpreterGetInputTensorCount(state->interpreter.get());
     jsi::Array tensors(runtime, size);
-    for (size_t i = 0; i < size; i++) {
-      TfLiteTensor* tensor = TfLiteInterpreterGetInputTensor(_interpreter, i);
+    for (int i = 0; i < size; i++) {
+      TfLiteTensor* tensor = TfLiteInterpreterGetInputTensor(state->interpreter.get(), i);
       if (tensor == nullptr) {
         [[unlikely]];
         throw jsi::JSError(runtime,
@@ -347,10 +1830,11 @@ jsi::Value TensorflowPlugin::get(jsi::Runtime& runtime, const jsi::PropNameID& p
     }
     return tensors;
   } else if (propName == "outputs") {
-    int size = TfLiteInterpreterGetOutputTensorCount(_interpreter);
+    auto state = getState();
+    int size = TfLiteInterpreterGetOutputTensorCount(state->interpreter.get());
     jsi::Array tensors(runtime, size);
-    for (size_t i = 0; i < size; i++) {
-      const TfLiteTensor* tensor = TfLiteInterpreterGetOutputTensor(_interpreter, i);
+    for (int i = 0; i < size; i++) {
+      const TfLiteTensor* tensor = TfLiteInterpreterGetOutputTensor(state->interpreter.get(), i);
       if (tensor == nullptr) {
         [[unlikely]];
         throw jsi::JSError(runtime,
@@ -362,7 +1846,7 @@ jsi::Value TensorflowPlugin::get(jsi::Runtime& runtime, const jsi::PropNameID& p
     }
     return tensors;
   } else if (propName == "delegate") {
-    switch (_delegate) {
+    switch (_options.delegate) {
       case Delegate::Default:
         return jsi::String::createFromUtf8(runtime, "default");
       case Delegate::CoreML:
@@ -383,6 +1867,14 @@ std::vector<jsi::PropNameID> TensorflowPlugin::getPropertyNames(jsi::Runtime& ru
   std::vector<jsi::PropNameID> result;
   result.push_back(jsi::PropNameID::forAscii(runtime, "run"));
   result.push_back(jsi::PropNameID::forAscii(runtime, "runSync"));
+  result.push_back(jsi::PropNameID::forAscii(runtime, "runBatch"));
+  result.push_back(jsi::PropNameID::forAscii(runtime, "runLatest"));
+  result.push_back(jsi::PropNameID::forAscii(runtime, "droppedFrames"));
+  result.push_back(jsi::PropNameID::forAscii(runtime, "stats"));
+  result.push_back(jsi::PropNameID::forAscii(runtime, "resetStats"));
+  result.push_back(jsi::PropNameID::forAscii(runtime, "cancel"));
+  result.push_back(jsi::PropNameID::forAscii(runtime, "getInputBuffer"));
+  result.push_back(jsi::PropNameID::forAscii(runtime, "resizeInputs"));
   result.push_back(jsi::PropNameID::forAscii(runtime, "inputs"));
   result.push_back(jsi::PropNameID::forAscii(runtime, "outputs"));
   result.push_back(jsi::PropNameID::forAscii(runtime, "delegate"));
@@ -8,13 +8,27 @@
 
 #pragma once
 
+#include "Buffer.h"
+#include "DeadlineTimer.h"
+#include "InferenceStats.h"
+#include "InterpreterPool.h"
+#include "Pipeline.h"
+#include "TensorHelpers.h"
+#include "ThreadPool.h"
+#include "jsi/Promise.h"
 #include "jsi/TypedArray.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <jsi/jsi.h>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
-#ifdef ANDROID
+#if defined(ANDROID) || defined(FAST_TFLITE_HOST)
 #include <ReactCommon/CallInvoker.h>
 #include <tflite/c/c_api.h>
 #else
@@ -25,20 +39,68 @@
 using namespace facebook;
 using namespace mrousavy;
 
-struct Buffer {
-  void* data;
-  size_t size;
-};
-typedef std::function<Buffer(std::string)> FetchURLFunc;
-
 class TensorflowPlugin : public jsi::HostObject {
 public:
   // TFL Delegate Type
   enum Delegate { Default, Metal, CoreML, NnApi, AndroidGPU };
 
+  // Options passed to `loadTensorflowModel(...)`
+  struct Options {
+    Delegate delegate = Delegate::Default;
+    // Pending loads with a higher priority are started first.
+    int loadPriority = 0;
+    // If true, output TypedArrays directly point into the output tensor's memory instead of
+    // being copied after every run.
+    bool zeroCopyOutputs = false;
+    // The amount of Interpreters that share the Model, so multiple `run(..)` calls can execute in
+    // parallel.
+    size_t interpreterPoolSize = 1;
+    // The amount of CPU threads each Interpreter uses, or 0 to split a budget based on the CPU
+    // cores across all Interpreters.
+    int numThreads = 0;
+    // If true, the XNNPACK CPU delegate runs float models with 16-bit floats.
+    bool useFp16 = false;
+    // A file XNNPACK stores the packed weights in, so later loads of the Model can skip packing.
+    // Ignored if the TFLite version doesn't support it.
+    std::string weightsCachePath;
+    // If greater than 0, `run(..)` calls that arrive within this time window are merged into one
+    // batched run.
+    double batchWindowMs = 0;
+    // The maximum amount of `run(..)` calls that are merged into one batched run.
+    size_t maxBatchSize = 8;
+    // If greater than 1, async runs are pipelined: While one run invokes the Model, up to
+    // `pipelineDepth - 1` other runs copy their inputs and outputs. Results arrive in order.
+    size_t pipelineDepth = 1;
+    // Per input tensor, the normalization and layout conversion that is applied to 8-bit pixel
+    // inputs while they are copied into the tensor. Inputs without preprocessing are copied as-is.
+    std::vector<std::optional<InputPreprocessing>> inputPreprocessing;
+    // If true, quantized (int8/uint8) tensors accept Float32Array inputs and return Float32Array
+    // outputs, which are (de-)quantized with the tensor's quantization params.
+    bool floatIO = false;
+    // Per output tensor, the post-processing that runs natively after every run. Post-processed
+    // outputs only return the small result instead of the whole tensor.
+    std::vector<std::optional<OutputPostprocessing>> outputPostprocessing;
+    // If set, the raw outputs of an object detection Model are decoded natively and runs return
+    // a single output with the detections instead of the output tensors.
+    std::optional<DetectionOptions> detection;
+    // The amount of runs every Interpreter does while loading, so delegates finish their lazy
+    // preparation before the first real run.
+    size_t warmupRuns = 0;
+    // The raw bytes of every input tensor for the warm-up runs, or null to use zeros. Shared, since
+    // the Options are copied for every Interpreter.
+    std::shared_ptr<const std::vector<std::vector<uint8_t>>> warmupInputs;
+  };
+
+  // Creates a new Interpreter for the Model, all Interpreters share the same Model
+  using InterpreterFactory = std::function<std::shared_ptr<TfLiteInterpreter>()>;
+
+  // The packed XNNPACK weights all Interpreters of a Model share (see `createWeightsCache`).
+  struct WeightsCache;
+
 public:
-  explicit TensorflowPlugin(TfLiteInterpreter* interpreter, Buffer model, Delegate delegate,
-                            std::shared_ptr<react::CallInvoker> callInvoker);
+  explicit TensorflowPlugin(InterpreterFactory createInterpreter, Options options,
+                            std::shared_ptr<react::CallInvoker> callInvoker,
+                            std::shared_ptr<PromiseFactory> promiseFactory);
   ~TensorflowPlugin();
 
   jsi::Value get(jsi::Runtime& runtime, const jsi::PropNameID& name) override;
@@ -48,19 +110,206 @@ public:
                                std::shared_ptr<react::CallInvoker> callInvoker,
                                FetchURLFunc fetchURL);
 
+  /**
+   Create a Model from the given Buffer. The Model takes ownership of the Buffer.
+   */
+  static std::shared_ptr<TfLiteModel> createModel(Buffer buffer, const std::string& modelPath);
+  /**
+   Create the in-memory XNNPACK weights cache for all Interpreters of one Model, so its weights are
+   only packed (and kept in memory) once instead of once per Interpreter. Returns null if the Model
+   doesn't run on XNNPACK, or XNNPACK stores the packed weights in the `weightsCachePath` file.
+   */
+  static std::shared_ptr<WeightsCache> createWeightsCache(const Options& options);
+  /**
+   Create a new Interpreter for the given Model using the delegate from the given options.
+   The Interpreter keeps the Model (and the weights cache) alive, and owns its delegate.
+   */
+  static std::shared_ptr<TfLiteInterpreter>
+  createInterpreter(std::shared_ptr<TfLiteModel> model, const Options& options,
+                    const std::string& modelPath,
+                    std::shared_ptr<WeightsCache> weightsCache = nullptr);
+  /**
+   The amount of CPU threads each Interpreter uses. Unless `numThreads` is set, the default thread
+   budget is split across all Interpreters that can run at the same time.
+   */
+  static int getNumThreads(const Options& options);
+
+  /**
+   Runs every Interpreter `warmupRuns` times with the warm-up inputs. Called on the loader Thread
+   before the Model is handed to JS. Stops early once `isCancelled` is set.
+   */
+  void warmUp(const std::atomic<bool>& isCancelled);
+
 private:
-  void copyInputBuffers(jsi::Runtime& runtime, jsi::Object inputValues);
-  void run();
-  jsi::Value copyOutputBuffers(jsi::Runtime& runtime);
+  // TypedArrays that directly point to a tensor's memory, with the pointer they were created for.
+  // If the tensor gets re-allocated, they need to be re-created.
+  using TensorViewCache =
+      std::unordered_map<std::string, std::pair<void*, std::shared_ptr<TypedArrayBase>>>;
+
+  // The Interpreters (and everything cached for their tensors) for one set of input shapes.
+  // Switching between shapes that were used before does not need to re-allocate anything.
+  struct ShapeState {
+    // The primary Interpreter, used by `runSync` and for the tensor metadata. It also owns the
+    // Model. TypedArrays that point into the Tensor's memory hold a reference to this so the
+    // memory stays valid even if the Plugin is already destroyed.
+    std::shared_ptr<TfLiteInterpreter> interpreter;
+    // All Interpreters (including the primary one), each of them can only be used by one Thread.
+    std::unique_ptr<InterpreterPool> pool;
+    std::unordered_map<std::string, std::shared_ptr<TypedArrayBase>> outputBuffers;
+    TensorViewCache inputViews;
+    TensorViewCache outputViews;
+    // The shapes of all input tensors
+    std::vector<std::vector<int>> inputShapes;
+    // Used to evict the least recently used shapes
+    uint64_t lastUsed = 0;
+  };
+
+  // Interpreters for one batch size, they don't hold any JS values so they can be used anywhere.
+  struct BatchState {
+    std::shared_ptr<InterpreterPool> pool;
+    // Used to evict the least recently used batch sizes
+    uint64_t lastUsed = 0;
+  };
+
+  // Stops an async run: `cancel()` stops all runs that were called before it, and runs that are
+  // not done by their deadline are stopped as well. Runs without a generation (`runSync`) can't
+  // be cancelled.
+  struct RunControl {
+    std::optional<uint64_t> cancelGeneration;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+  };
+
+  // A copy of an output tensor's data that can be handed over to JS without copying again.
+  struct OutputData {
+    TfLiteType type;
+    std::shared_ptr<jsi::MutableBuffer> buffer;
+  };
+
+  // A `run(..)` call that waits to be merged into a batch with other runs.
+  struct PendingRun {
+    std::shared_ptr<ShapeState> state;
+    std::vector<TensorData> inputs;
+    std::shared_ptr<jsi::Object> inputValues;
+    std::shared_ptr<Promise> promise;
+    RunControl control;
+    // When the run was called, to measure how long it waited.
+    std::chrono::steady_clock::time_point enqueuedAt = std::chrono::steady_clock::now();
+  };
+
+  static Options parseOptions(jsi::Runtime& runtime, const jsi::Value& value);
+
+  std::vector<std::shared_ptr<TfLiteInterpreter>>
+  createInterpreters(const std::vector<std::vector<int>>& shapes, size_t count);
+  std::shared_ptr<ShapeState> createShapeState(const std::vector<std::vector<int>>& shapes);
+  void resizeInputs(const std::vector<std::vector<int>>& shapes);
+  /**
+   The Interpreters for the current input shapes. `resizeInputs(..)` can switch them from another
+   JS Runtime (e.g. a Frame Processor), so every call should only get them once.
+   */
+  std::shared_ptr<ShapeState> getState() const;
+  std::shared_ptr<InterpreterPool> getBatchPool(const std::vector<std::vector<int>>& shapes,
+                                                size_t batchSize);
+
+  const InputPreprocessing* getInputPreprocessing(size_t inputIndex) const;
+  bool isFloatIO(const TfLiteTensor* tensor) const;
+  const OutputPostprocessing* getOutputPostprocessing(size_t outputIndex) const;
+  std::vector<TensorData> getInputData(jsi::Runtime& runtime, const ShapeState& state,
+                                       const jsi::Object& inputValues);
+  void copyInputData(TfLiteInterpreter* interpreter, const std::vector<TensorData>& inputs);
+  void copyInputBuffers(jsi::Runtime& runtime, const ShapeState& state, jsi::Object inputValues);
+  /**
+   Creates the RunControl for a run that is called now, with the `timeoutMs` from the given run
+   options (if any).
+   */
+  RunControl createRunControl(jsi::Runtime& runtime, const jsi::Value* runOptions) const;
+  /**
+   Returns why the run has to stop (it was cancelled or missed its deadline), or an empty string.
+   */
+  std::string getStopReason(const RunControl& control) const;
+  void cancelRuns();
+  void run(TfLiteInterpreter* interpreter, const RunControl& control);
+  void runAsync(jsi::Runtime& runtime, std::shared_ptr<ShapeState> state,
+                std::vector<TensorData> inputs, std::shared_ptr<jsi::Object> inputValues,
+                std::shared_ptr<Promise> promise, RunControl control);
+  std::vector<OutputData> copyOutputData(TfLiteInterpreter* interpreter);
+  std::shared_ptr<jsi::MutableBuffer> decodeDetections(TfLiteInterpreter* interpreter,
+                                                       size_t sample, size_t batchSize);
+  static jsi::Array createOutputArray(jsi::Runtime& runtime,
+                                      const std::vector<OutputData>& outputs);
+  std::vector<std::vector<OutputData>> runBatch(const ShapeState& state,
+                                                const std::vector<std::vector<TensorData>>& samples,
+                                                size_t batchSize, const RunControl& control);
+  void runBatchAsync(jsi::Runtime& runtime, std::shared_ptr<ShapeState> state,
+                     std::vector<std::vector<TensorData>> samples,
+                     std::shared_ptr<jsi::Object> inputValues, std::shared_ptr<Promise> promise,
+                     RunControl control);
+  void enqueueBatchedRun(jsi::Runtime& runtime, PendingRun run);
+  /**
+   Hands all pending runs to the worker. `_pendingRunsMutex` must be locked.
+   */
+  void flushPendingRuns(jsi::Runtime& runtime);
+  void processPendingRuns(jsi::Runtime& runtime, std::vector<PendingRun> runs);
+  void runPendingRuns(jsi::Runtime& runtime, std::vector<PendingRun> runs);
+  void enqueueLatestRun(jsi::Runtime& runtime, PendingRun run);
+  void processLatestRun(jsi::Runtime& runtime);
+  jsi::Value copyOutputBuffers(jsi::Runtime& runtime, ShapeState& state);
+  jsi::Object createStatsObject(jsi::Runtime& runtime) const;
 
   std::shared_ptr<TypedArrayBase> getOutputArrayForTensor(jsi::Runtime& runtime,
+                                                          ShapeState& state,
                                                           const TfLiteTensor* tensor);
+  std::shared_ptr<TypedArrayBase> getTensorView(jsi::Runtime& runtime, const ShapeState& state,
+                                                const TfLiteTensor* tensor, TensorViewCache& cache);
 
 private:
-  TfLiteInterpreter* _interpreter = nullptr;
-  Delegate _delegate = Delegate::Default;
-  Buffer _model;
+  InterpreterFactory _createInterpreter;
+  Options _options;
   std::shared_ptr<react::CallInvoker> _callInvoker;
+  std::shared_ptr<PromiseFactory> _promiseFactory;
+
+  // Runs all async `run(..)` calls
+  std::unique_ptr<ThreadPool> _worker;
+
+  // In pipelined mode, every async run gets a sequence number to invoke and resolve in order.
+  // `run(..)` is also called from worklet Runtimes, so they are handed out under the mutex.
+  std::mutex _pipelineSequenceMutex;
+  uint64_t _pipelineSequence = 0;
+  Pipeline _pipeline;
+
+  // The Interpreters for the current input shapes. Only use `std::atomic_load`/`std::atomic_store`.
+  std::shared_ptr<ShapeState> _state;
+  // All Interpreters that were created for custom input shapes, keyed by their shape signature.
+  // The Model's original input shapes use the empty signature.
+  std::mutex _shapeStatesMutex;
+  std::unordered_map<std::string, std::shared_ptr<ShapeState>> _shapeStates;
+  uint64_t _shapeCounter = 0;
+
+  // Interpreters for batched runs, keyed by their (batched) shape signature. Used from any Thread.
+  std::mutex _batchStatesMutex;
+  std::unordered_map<std::string, BatchState> _batchStates;
+  uint64_t _batchCounter = 0;
+
+  // `run(..)` calls that wait to be merged into a batch
+  std::mutex _pendingRunsMutex;
+  std::vector<PendingRun> _pendingRuns;
+  // Incremented whenever the pending runs are flushed, so the batch window's timer only flushes
+  // the batch it was scheduled for.
+  uint64_t _pendingBatchId = 0;
+
+  // The newest `runLatest(..)` call that did not start yet, older ones are dropped.
+  std::mutex _latestRunMutex;
+  std::optional<PendingRun> _latestRun;
+  bool _isProcessingLatestRun = false;
+  // Only accessed on the JS Thread
+  size_t _droppedFrames = 0;
+
+  // Incremented by every `cancel()` call, runs from an older generation are stopped.
+  std::atomic<uint64_t> _cancelGeneration{0};
+  // Interrupts running invocations once their deadline passed
+  DeadlineTimer _deadlineTimer{"TFLite Deadline"};
 
-  std::unordered_map<std::string, std::shared_ptr<TypedArrayBase>> _outputBuffers;
+  // Timings of all runs, recorded from any Thread.
+  InferenceStats _stats;
+  // Timings of the warm-up runs while loading, kept apart so they don't skew the run stats.
+  LatencyHistogram _warmupStats;
 };
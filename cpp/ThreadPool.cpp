@@ -0,0 +1,59 @@
+#include "ThreadPool.h"
+
+#include <pthread.h>
+#include <utility>
+
+ThreadPool::ThreadPool(std::string name, size_t threadCount, size_t maxQueueSize)
+    : _name(std::move(name)), _maxQueueSize(maxQueueSize) {
+  for (size_t i = 0; i < threadCount; i++) {
+    _threads.emplace_back([this]() { loop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _isRunning = false;
+    _queue.clear();
+  }
+  _condition.notify_all();
+
+  for (auto& thread : _threads) {
+    thread.join();
+  }
+}
+
+bool ThreadPool::enqueue(Job job) {
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_queue.size() >= _maxQueueSize) {
+      [[unlikely]];
+      return false;
+    }
+    _queue.push_back(std::move(job));
+  }
+  _condition.notify_one();
+  return true;
+}
+
+void ThreadPool::loop() {
+#ifdef __APPLE__
+  pthread_setname_np(_name.c_str());
+#else
+  pthread_setname_np(pthread_self(), _name.substr(0, 15).c_str());
+#endif
+
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _condition.wait(lock, [this]() { return !_isRunning || !_queue.empty(); });
+      if (!_isRunning) {
+        return;
+      }
+      job = std::move(_queue.front());
+      _queue.pop_front();
+    }
+    job();
+  }
+}
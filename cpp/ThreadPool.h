@@ -0,0 +1,39 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ A fixed amount of long-lived Threads that run jobs from a bounded queue.
+ Destroying the pool drops all pending jobs and waits for running jobs to finish, so it must not be
+ destroyed from one of its own jobs.
+ */
+class ThreadPool {
+public:
+  using Job = std::function<void()>;
+
+  ThreadPool(std::string name, size_t threadCount, size_t maxQueueSize);
+  ~ThreadPool();
+
+  /**
+   Adds the given job to the queue. Returns `false` if the queue is full.
+   */
+  bool enqueue(Job job);
+
+private:
+  void loop();
+
+private:
+  std::string _name;
+  size_t _maxQueueSize;
+  bool _isRunning = true;
+  std::deque<Job> _queue;
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  std::vector<std::thread> _threads;
+};
@@ -1,5 +1,4 @@
 #include "Promise.h"
-#include <future>
 #include <jsi/jsi.h>
 #include <utility>
 #include <vector>
@@ -11,26 +10,6 @@ using namespace facebook;
 Promise::Promise(jsi::Runtime& runtime, jsi::Value resolver, jsi::Value rejecter)
     : runtime(runtime), _resolver(std::move(resolver)), _rejecter(std::move(rejecter)) {}
 
-jsi::Value Promise::createPromise(jsi::Runtime& runtime,
-                                  std::function<void(std::shared_ptr<Promise> promise)> run) {
-  // Get Promise ctor from global
-  auto promiseCtor = runtime.global().getPropertyAsFunction(runtime, "Promise");
-
-  auto promiseCallback = jsi::Function::createFromHostFunction(
-      runtime, jsi::PropNameID::forUtf8(runtime, "PromiseCallback"), 2,
-      [=](jsi::Runtime& runtime, const jsi::Value& thisValue, const jsi::Value* arguments,
-          size_t count) -> jsi::Value {
-        // Call function
-        auto promise = std::make_shared<Promise>(runtime, arguments[0].asObject(runtime),
-                                                 arguments[1].asObject(runtime));
-        run(promise);
-
-        return jsi::Value::undefined();
-      });
-
-  return promiseCtor.callAsConstructor(runtime, promiseCallback);
-}
-
 void Promise::resolve(jsi::Value&& result) {
   _resolver.asObject(runtime).asFunction(runtime).call(runtime, std::move(result));
 }
@@ -40,4 +19,42 @@ void Promise::reject(std::string message) {
   _rejecter.asObject(runtime).asFunction(runtime).call(runtime, error.value());
 }
 
+void Promise::reject(std::string message, const std::string& code) {
+  jsi::JSError error(runtime, message);
+  error.value().asObject(runtime).setProperty(runtime, "code",
+                                              jsi::String::createFromUtf8(runtime, code));
+  _rejecter.asObject(runtime).asFunction(runtime).call(runtime, error.value());
+}
+
+jsi::Function createExecutor(jsi::Runtime& runtime,
+                             std::shared_ptr<std::shared_ptr<Promise>> pendingPromise) {
+  return jsi::Function::createFromHostFunction(
+      runtime, jsi::PropNameID::forUtf8(runtime, "PromiseCallback"), 2,
+      [=](jsi::Runtime& runtime, const jsi::Value&, const jsi::Value* arguments,
+          size_t) -> jsi::Value {
+        *pendingPromise = std::make_shared<Promise>(runtime, arguments[0].asObject(runtime),
+                                                    arguments[1].asObject(runtime));
+        return jsi::Value::undefined();
+      });
+}
+
+PromiseFactory::PromiseFactory(jsi::Runtime& runtime)
+    : _pendingPromise(std::make_shared<std::shared_ptr<Promise>>()),
+      _constructor(runtime.global().getPropertyAsFunction(runtime, "Promise")),
+      _executor(createExecutor(runtime, _pendingPromise)) {}
+
+jsi::Value
+PromiseFactory::createPromise(jsi::Runtime& runtime,
+                              std::function<void(std::shared_ptr<Promise> promise)> run) {
+  jsi::Value result = _constructor.callAsConstructor(runtime, _executor);
+  std::shared_ptr<Promise> promise = std::move(*_pendingPromise);
+
+  try {
+    run(promise);
+  } catch (std::exception& error) {
+    promise->reject(error.what());
+  }
+  return result;
+}
+
 } // namespace mrousavy
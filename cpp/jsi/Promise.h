@@ -1,10 +1,11 @@
 #pragma once
 
 #include <jsi/jsi.h>
+#include <memory>
 #include <utility>
 #include <vector>
 
-#ifdef ANDROID
+#if defined(ANDROID) || defined(FAST_TFLITE_HOST)
 #include <ReactCommon/CallInvoker.h>
 #else
 #include <React-callinvoker/ReactCommon/CallInvoker.h>
@@ -20,6 +21,10 @@ public:
 
   void resolve(jsi::Value&& result);
   void reject(std::string error);
+  /**
+   Rejects with an Error that has the given `code` property, so JS can tell it apart from others.
+   */
+  void reject(std::string error, const std::string& code);
 
 public:
   jsi::Runtime& runtime;
@@ -27,13 +32,28 @@ public:
 private:
   jsi::Value _resolver;
   jsi::Value _rejecter;
+};
 
+/**
+ Creates Promises for a specific jsi::Runtime.
+ The `Promise` constructor and the executor function are only looked up/created once, so creating a
+ Promise does not need to go through `global` or create a new host function every time.
+ */
+class PromiseFactory {
 public:
+  explicit PromiseFactory(jsi::Runtime& runtime);
+
   /**
    Create a new Promise and runs the given `run` function.
    */
-  static jsi::Value createPromise(jsi::Runtime& runtime,
-                                  std::function<void(std::shared_ptr<Promise> promise)> run);
+  jsi::Value createPromise(jsi::Runtime& runtime,
+                           std::function<void(std::shared_ptr<Promise> promise)> run);
+
+private:
+  // The executor is called synchronously by the Promise constructor and stores the Promise here.
+  std::shared_ptr<std::shared_ptr<Promise>> _pendingPromise;
+  jsi::Function _constructor;
+  jsi::Function _executor;
 };
 
 } // namespace mrousavy
@@ -13,7 +13,10 @@
 #include "TypedArray.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -46,31 +49,91 @@ enum class Prop {
   BigUint64Array,    // "BigUint64Array"
 };
 
+constexpr size_t kPropCount = static_cast<size_t>(Prop::BigUint64Array) + 1;
+constexpr size_t kKindCount = static_cast<size_t>(TypedArrayKind::BigUint64Array) + 1;
+
+// Everything that is cached for a single jsi::Runtime.
+struct RuntimeCache {
+  std::array<std::unique_ptr<jsi::PropNameID>, kPropCount> props;
+  // The global TypedArray constructors, used to get a TypedArray's kind by identity.
+  std::array<std::unique_ptr<jsi::Object>, kKindCount> constructors;
+  // `ArrayBuffer.isView`
+  std::unique_ptr<jsi::Function> isView;
+};
+
 class PropNameIDCache {
 public:
   const jsi::PropNameID& get(jsi::Runtime& runtime, Prop prop) {
-    auto key = reinterpret_cast<uintptr_t>(&runtime);
-    if (this->props.find(key) == this->props.end()) {
-      this->props[key] = std::unordered_map<Prop, std::unique_ptr<jsi::PropNameID>>();
-    }
-    if (!this->props[key][prop]) {
-      this->props[key][prop] = std::make_unique<jsi::PropNameID>(createProp(runtime, prop));
+    auto& cached = getRuntimeCache(runtime).props[static_cast<size_t>(prop)];
+    if (cached == nullptr) {
+      cached = std::make_unique<jsi::PropNameID>(createProp(runtime, prop));
     }
-    return *(this->props[key][prop]);
+    return *cached;
   }
 
   const jsi::PropNameID& getConstructorNameProp(jsi::Runtime& runtime, TypedArrayKind kind);
 
-  void invalidate(uintptr_t key) {
-    if (props.find(key) != props.end()) {
-      props[key].clear();
+  const jsi::Object& getConstructor(jsi::Runtime& runtime, TypedArrayKind kind) {
+    auto& cached = getRuntimeCache(runtime).constructors[static_cast<size_t>(kind)];
+    if (cached == nullptr) {
+      cached = std::make_unique<jsi::Object>(
+          runtime.global()
+              .getProperty(runtime, getConstructorNameProp(runtime, kind))
+              .asObject(runtime));
     }
+    return *cached;
+  }
+
+  const jsi::Function& getIsView(jsi::Runtime& runtime) {
+    auto& cached = getRuntimeCache(runtime).isView;
+    if (cached == nullptr) {
+      auto arrayBuffer =
+          runtime.global().getProperty(runtime, get(runtime, Prop::ArrayBuffer)).asObject(runtime);
+      auto isView = arrayBuffer.getProperty(runtime, get(runtime, Prop::IsView));
+      cached = std::make_unique<jsi::Function>(isView.asObject(runtime).asFunction(runtime));
+    }
+    return *cached;
+  }
+
+  void invalidate(uintptr_t key) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _caches.erase(key);
+    _generation++;
   }
 
 private:
-  std::unordered_map<uintptr_t, std::unordered_map<Prop, std::unique_ptr<jsi::PropNameID>>> props;
+  RuntimeCache& getRuntimeCache(jsi::Runtime& runtime) {
+    // Most lookups come from the same Runtime over and over again, so remember the last one per
+    // Thread to skip the lock and the map lookup.
+    thread_local uintptr_t lastKey = 0;
+    thread_local uint64_t lastGeneration = 0;
+    thread_local RuntimeCache* lastCache = nullptr;
+
+    auto key = reinterpret_cast<uintptr_t>(&runtime);
+    uint64_t generation = _generation.load();
+    if (lastCache != nullptr && lastKey == key && lastGeneration == generation) {
+      [[likely]];
+      return *lastCache;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto& cache = _caches[key];
+    if (cache == nullptr) {
+      cache = std::make_unique<RuntimeCache>();
+    }
+    lastKey = key;
+    lastGeneration = _generation.load();
+    lastCache = cache.get();
+    return *cache;
+  }
 
   jsi::PropNameID createProp(jsi::Runtime& runtime, Prop prop);
+
+private:
+  std::mutex _mutex;
+  std::unordered_map<uintptr_t, std::unique_ptr<RuntimeCache>> _caches;
+  // Incremented whenever a Runtime's cache is removed, so Threads don't use a stale cache.
+  std::atomic<uint64_t> _generation{0};
 };
 
 PropNameIDCache propNameIDCache;
@@ -84,6 +147,25 @@ InvalidateCacheOnDestroy::~InvalidateCacheOnDestroy() {
 
 TypedArrayKind getTypedArrayKindForName(const std::string& name);
 
+TypedArrayKind getTypedArrayKindForConstructor(jsi::Runtime& runtime,
+                                               const jsi::Object& constructor) {
+  // Comparing the constructor's identity is a lot faster than reading its name.
+  for (size_t i = 0; i < kKindCount; i++) {
+    auto kind = static_cast<TypedArrayKind>(i);
+    if (jsi::Object::strictEquals(runtime, constructor,
+                                  propNameIDCache.getConstructor(runtime, kind))) {
+      return kind;
+    }
+  }
+
+  // e.g. a TypedArray subclass or one created in a different realm
+  auto name = constructor.getProperty(runtime, propNameIDCache.get(runtime, Prop::Name));
+  if (!name.isString()) {
+    throw std::runtime_error("Object is not a TypedArray");
+  }
+  return getTypedArrayKindForName(name.asString(runtime).utf8(runtime));
+}
+
 TypedArrayBase::TypedArrayBase(jsi::Runtime& runtime, size_t size, TypedArrayKind kind)
     : TypedArrayBase(
           runtime, runtime.global()
@@ -93,16 +175,23 @@ TypedArrayBase::TypedArrayBase(jsi::Runtime& runtime, size_t size, TypedArrayKin
                        .callAsConstructor(runtime, {static_cast<double>(size)})
                        .asObject(runtime)) {}
 
+TypedArrayBase::TypedArrayBase(jsi::Runtime& runtime, const jsi::ArrayBuffer& buffer,
+                               TypedArrayKind kind)
+    : TypedArrayBase(
+          runtime, runtime.global()
+                       .getProperty(runtime, propNameIDCache.getConstructorNameProp(runtime, kind))
+                       .asObject(runtime)
+                       .asFunction(runtime)
+                       .callAsConstructor(runtime, {jsi::Value(runtime, buffer)})
+                       .asObject(runtime)) {}
+
 TypedArrayBase::TypedArrayBase(jsi::Runtime& runtime, const jsi::Object& obj)
     : jsi::Object(jsi::Value(runtime, obj).asObject(runtime)) {}
 
 TypedArrayKind TypedArrayBase::getKind(jsi::Runtime& runtime) const {
-  auto constructorName = this->getProperty(runtime, propNameIDCache.get(runtime, Prop::Constructor))
-                             .asObject(runtime)
-                             .getProperty(runtime, propNameIDCache.get(runtime, Prop::Name))
-                             .asString(runtime)
-                             .utf8(runtime);
-  return getTypedArrayKindForName(constructorName);
+  auto constructor =
+      this->getProperty(runtime, propNameIDCache.get(runtime, Prop::Constructor)).asObject(runtime);
+  return getTypedArrayKindForConstructor(runtime, constructor);
 }
 
 size_t TypedArrayBase::size(jsi::Runtime& runtime) const {
@@ -142,13 +231,8 @@ jsi::ArrayBuffer TypedArrayBase::getBuffer(jsi::Runtime& runtime) const {
 }
 
 bool isTypedArray(jsi::Runtime& runtime, const jsi::Object& jsObj) {
-  auto jsVal = runtime.global()
-                   .getProperty(runtime, propNameIDCache.get(runtime, Prop::ArrayBuffer))
-                   .asObject(runtime)
-                   .getProperty(runtime, propNameIDCache.get(runtime, Prop::IsView))
-                   .asObject(runtime)
-                   .asFunction(runtime)
-                   .callWithThis(runtime, runtime.global(), {jsi::Value(runtime, jsObj)});
+  auto jsVal = propNameIDCache.getIsView(runtime).callWithThis(runtime, runtime.global(),
+                                                               {jsi::Value(runtime, jsObj)});
   if (jsVal.isBool()) {
     return jsVal.getBool();
   } else {
@@ -157,13 +241,8 @@ bool isTypedArray(jsi::Runtime& runtime, const jsi::Object& jsObj) {
 }
 
 TypedArrayBase getTypedArray(jsi::Runtime& runtime, const jsi::Object& jsObj) {
-  auto jsVal = runtime.global()
-                   .getProperty(runtime, propNameIDCache.get(runtime, Prop::ArrayBuffer))
-                   .asObject(runtime)
-                   .getProperty(runtime, propNameIDCache.get(runtime, Prop::IsView))
-                   .asObject(runtime)
-                   .asFunction(runtime)
-                   .callWithThis(runtime, runtime.global(), {jsi::Value(runtime, jsObj)});
+  auto jsVal = propNameIDCache.getIsView(runtime).callWithThis(runtime, runtime.global(),
+                                                               {jsi::Value(runtime, jsObj)});
   if (jsVal.isBool()) {
     return TypedArrayBase(runtime, jsObj);
   } else {
@@ -171,6 +250,29 @@ TypedArrayBase getTypedArray(jsi::Runtime& runtime, const jsi::Object& jsObj) {
   }
 }
 
+TypedArrayInfo getTypedArrayInfo(jsi::Runtime& runtime, const jsi::Object& jsObj) {
+  jsi::Value buffer = jsObj.getProperty(runtime, propNameIDCache.get(runtime, Prop::Buffer));
+  jsi::Value constructor =
+      jsObj.getProperty(runtime, propNameIDCache.get(runtime, Prop::Constructor));
+  if (!buffer.isObject() || !constructor.isObject()) {
+    [[unlikely]];
+    throw std::runtime_error("Object is not a TypedArray");
+  }
+  jsi::Object bufferObject = buffer.getObject(runtime);
+  if (!bufferObject.isArrayBuffer(runtime)) {
+    [[unlikely]];
+    throw std::runtime_error("Object is not a TypedArray");
+  }
+
+  TypedArrayKind kind = getTypedArrayKindForConstructor(runtime, constructor.getObject(runtime));
+  size_t byteOffset =
+      jsObj.getProperty(runtime, propNameIDCache.get(runtime, Prop::ByteOffset)).asNumber();
+  size_t byteLength =
+      jsObj.getProperty(runtime, propNameIDCache.get(runtime, Prop::ByteLength)).asNumber();
+  uint8_t* data = bufferObject.getArrayBuffer(runtime).data(runtime) + byteOffset;
+  return TypedArrayInfo{.kind = kind, .data = data, .byteLength = byteLength};
+}
+
 std::vector<uint8_t> arrayBufferToVector(jsi::Runtime& runtime, jsi::Object& jsObj) {
   if (!jsObj.isArrayBuffer(runtime)) {
     throw std::runtime_error("Object is not an ArrayBuffer");
@@ -332,7 +434,11 @@ std::unordered_map<std::string, TypedArrayKind> nameToKindMap = {
 };
 
 TypedArrayKind getTypedArrayKindForName(const std::string& name) {
-  return nameToKindMap.at(name);
+  auto kind = nameToKindMap.find(name);
+  if (kind == nameToKindMap.end()) {
+    throw std::runtime_error("Object is not a TypedArray");
+  }
+  return kind->second;
 }
 
 template class TypedArray<TypedArrayKind::Int8Array>;
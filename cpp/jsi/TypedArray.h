@@ -77,11 +77,11 @@ class InvalidateCacheOnDestroy : public jsi::HostObject {
 public:
   explicit InvalidateCacheOnDestroy(jsi::Runtime& runtime);
   virtual ~InvalidateCacheOnDestroy();
-  virtual jsi::Value get(jsi::Runtime&, const jsi::PropNameID& name) {
+  virtual jsi::Value get(jsi::Runtime&, const jsi::PropNameID&) {
     return jsi::Value::null();
   }
-  virtual void set(jsi::Runtime&, const jsi::PropNameID& name, const jsi::Value& value) {}
-  virtual std::vector<jsi::PropNameID> getPropertyNames(jsi::Runtime& rt) {
+  virtual void set(jsi::Runtime&, const jsi::PropNameID&, const jsi::Value&) {}
+  virtual std::vector<jsi::PropNameID> getPropertyNames(jsi::Runtime&) {
     return {};
   }
 
@@ -94,6 +94,7 @@ public:
   template <TypedArrayKind T> using ContentType = typename typedArrayTypeMap<T>::type;
 
   TypedArrayBase(jsi::Runtime&, size_t, TypedArrayKind);
+  TypedArrayBase(jsi::Runtime&, const jsi::ArrayBuffer&, TypedArrayKind);
   TypedArrayBase(jsi::Runtime&, const jsi::Object&);
   TypedArrayBase(TypedArrayBase&&) = default;
   TypedArrayBase& operator=(TypedArrayBase&&) = default;
@@ -118,7 +119,21 @@ private:
   template <TypedArrayKind> friend class TypedArray;
 };
 
+/**
+ The kind and raw memory of a TypedArray.
+ */
+struct TypedArrayInfo {
+  TypedArrayKind kind;
+  uint8_t* data;
+  size_t byteLength;
+};
+
 bool isTypedArray(jsi::Runtime& runtime, const jsi::Object& jsObj);
+/**
+ Reads the kind and the memory of the given TypedArray in a single pass, using only cached
+ property names and constructors. Throws if the object is not a TypedArray.
+ */
+TypedArrayInfo getTypedArrayInfo(jsi::Runtime& runtime, const jsi::Object& jsObj);
 TypedArrayBase getTypedArray(jsi::Runtime& runtime, const jsi::Object& jsObj);
 
 std::vector<uint8_t> arrayBufferToVector(jsi::Runtime& runtime, jsi::Object& jsObj);
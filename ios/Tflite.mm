@@ -29,7 +29,19 @@ RCT_EXPORT_MODULE(Tflite)
     NSString* string = [NSString stringWithUTF8String:url.c_str()];
     NSLog(@"Fetching %@...", string);
     NSURL* nsURL = [NSURL URLWithString:string];
+    if (nsURL.isFileURL) {
+      // Local files (e.g. bundled assets) can be memory-mapped without any copies
+      try {
+        return Buffer::mapFile(std::string(nsURL.path.UTF8String));
+      } catch (std::exception& exc) {
+        NSLog(@"%s Reading it into memory instead.", exc.what());
+      }
+    }
+
     NSData* contents = [NSData dataWithContentsOfURL:nsURL];
+    if (contents == nil) {
+      throw std::runtime_error("TFLite: Failed to read model from \"" + url + "\"!");
+    }
 
     void* data = malloc(contents.length * sizeof(uint8_t));
     memcpy(data, contents.bytes, contents.length);
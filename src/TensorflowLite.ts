@@ -1,4 +1,4 @@
-import { useEffect, useState } from 'react'
+import { useEffect, useMemo, useState } from 'react'
 import { Image } from 'react-native'
 import { TensorflowModule } from './TensorflowModule'
 
@@ -22,8 +22,19 @@ declare global {
   // eslint-disable-next-line no-var
   var __loadTensorflowModel: (
     path: string,
-    delegate: TensorflowModelDelegate
+    options: TensorflowModelDelegate | TensorflowModelOptions,
+    loadId: number
   ) => Promise<TensorflowModel>
+  /**
+   * Cancels the load with the given id, if it is still pending or running.
+   */
+  // eslint-disable-next-line no-var
+  var __cancelTensorflowModelLoad: (loadId: number) => boolean
+  /**
+   * Sets how many Models can be loaded at the same time.
+   */
+  // eslint-disable-next-line no-var
+  var __setTensorflowModelLoadConcurrency: (concurrency: number) => void
 }
 // Installs the JSI bindings into the global namespace.
 console.log('Installing bindings...')
@@ -33,6 +44,65 @@ if (result !== true)
 
 console.log('Successfully installed!')
 
+export interface ImageInput {
+  /**
+   * The image's pixels, e.g. from `frame.toArrayBuffer()`.
+   */
+  data: ArrayBuffer | TypedArray
+  /**
+   * The image's width in pixels.
+   */
+  width: number
+  /**
+   * The image's height in pixels.
+   */
+  height: number
+  /**
+   * The image's pixel format. YUV formats are converted with full-range BT.601.
+   * - `'rgb'`, `'rgba'`, `'bgra'`: Interleaved pixels.
+   * - `'nv12'`, `'nv21'`: A Y plane followed by an interleaved UV (or VU) plane.
+   * - `'i420'`: A Y plane followed by separate U and V planes.
+   */
+  format: 'rgb' | 'rgba' | 'bgra' | 'nv12' | 'nv21' | 'i420'
+  /**
+   * The stride of the first (RGB or Y) plane, if rows are padded.
+   */
+  bytesPerRow?: number
+  /**
+   * The byte offset of the first chroma plane, if it does not directly follow the Y plane.
+   */
+  uvOffset?: number
+  /**
+   * The stride of the chroma plane(s), if rows are padded.
+   */
+  uvBytesPerRow?: number
+  /**
+   * The byte offset of the V plane (`'i420'` only), if it does not directly follow the U plane.
+   */
+  vOffset?: number
+  /**
+   * The region of the image (in pixels) to use. Defaults to the whole image.
+   */
+  crop?: { x: number; y: number; width: number; height: number }
+  /**
+   * Clockwise rotation in degrees, applied after cropping.
+   * @default 0
+   */
+  rotation?: 0 | 90 | 180 | 270
+  /**
+   * Flips the image horizontally, applied after rotating.
+   * @default false
+   */
+  mirror?: boolean
+}
+
+/**
+ * An input value: Either the raw tensor data, or an image that is sampled into an RGB input tensor
+ * natively (cropped, resized with bilinear filtering, rotated and normalized with the input's
+ * {@linkcode TensorflowModelOptions.inputPreprocessing}).
+ */
+export type TensorflowInput = TypedArray | ImageInput
+
 export type TensorflowModelDelegate =
   | 'default'
   | 'metal'
@@ -40,6 +110,253 @@ export type TensorflowModelDelegate =
   | 'nnapi'
   | 'android-gpu'
 
+export interface InputPreprocessing {
+  /**
+   * The mean that is subtracted from every pixel value, either one value for all channels or one
+   * value per channel (in the Model's channel order).
+   * @default 0
+   */
+  mean?: number | number[]
+  /**
+   * The standard deviation every pixel value is divided by, either one value for all channels or
+   * one value per channel (in the Model's channel order).
+   * @default 1
+   */
+  std?: number | number[]
+  /**
+   * If `true`, the first three channels are reversed (RGB <-> BGR).
+   * @default false
+   */
+  swapRedBlue?: boolean
+  /**
+   * The layout of the input tensor. The input pixels are always interleaved (`'nhwc'`), with
+   * `'nchw'` they are transposed into one plane per channel.
+   * @default 'nhwc'
+   */
+  layout?: 'nhwc' | 'nchw'
+}
+
+export interface OutputPostprocessing {
+  /**
+   * The number of highest scores to return for every row (the last dimension) of the output
+   * tensor. `1` is an argmax.
+   * @default 1
+   */
+  topK?: number
+  /**
+   * If `true`, the returned scores are softmax probabilities over the whole row instead of the
+   * raw scores.
+   * @default false
+   */
+  softmax?: boolean
+}
+
+export interface DetectionOptions {
+  /**
+   * The layout of the Model's raw outputs:
+   * - `'ssd'`: A boxes output (`[N, 4]`) and a class scores output (`[N, C]`). With
+   * {@linkcode anchors}, boxes are encoded as `[ty, tx, th, tw]`, otherwise they are
+   * `[y1, x1, y2, x2]`.
+   * - `'yolo'`: A single `[N, 4 + C]` (or transposed `[4 + C, N]`) output of
+   * `[cx, cy, w, h, ...scores]`, with an objectness score before the class scores if
+   * {@linkcode objectness} is set.
+   * @default 'ssd'
+   */
+  format?: 'ssd' | 'yolo'
+  /**
+   * The index of the output tensor that holds the boxes (or the whole YOLO output).
+   * @default 0
+   */
+  boxesOutput?: number
+  /**
+   * The index of the output tensor that holds the class scores (SSD only).
+   * @default 1
+   */
+  scoresOutput?: number
+  /**
+   * SSD anchors, as `[cy, cx, h, w]` for each box.
+   */
+  anchors?: number[]
+  /**
+   * The SSD box encoding scales for `[y, x, h, w]`.
+   * @default [10, 10, 5, 5]
+   */
+  boxScales?: [number, number, number, number]
+  /**
+   * The minimum score of a detection.
+   * @default 0.5
+   */
+  scoreThreshold?: number
+  /**
+   * Boxes that overlap a higher scoring box by more than this are removed.
+   * @default 0.5
+   */
+  iouThreshold?: number
+  /**
+   * The maximum number of detections to return.
+   * @default 100
+   */
+  maxDetections?: number
+  /**
+   * If `true`, overlapping boxes of different classes also suppress each other.
+   * @default false
+   */
+  classAgnostic?: boolean
+  /**
+   * If `true`, the scores are logits and a sigmoid is applied to them.
+   * @default false
+   */
+  sigmoid?: boolean
+  /**
+   * If `true`, YOLO outputs have an objectness score that is multiplied with the class scores.
+   * @default false
+   */
+  objectness?: boolean
+  /**
+   * If `true`, the first class is a background class that is never detected.
+   * @default false
+   */
+  skipBackgroundClass?: boolean
+}
+
+export interface TensorflowModelOptions {
+  /**
+   * The computation delegate to use for this Model.
+   * @default 'default'
+   */
+  delegate?: TensorflowModelDelegate
+  /**
+   * Models are loaded on a small pool of background threads (see
+   * {@linkcode setModelLoadConcurrency}). If more Models are waiting to be loaded, the ones with
+   * a higher priority are loaded first.
+   * @default 0
+   */
+  loadPriority?: number
+  /**
+   * If `true`, the TypedArrays returned by {@linkcode TensorflowModel.run} and
+   * {@linkcode TensorflowModel.runSync} directly point to the output tensor's memory instead of
+   * being copied after every run.
+   *
+   * This avoids copying large outputs, but the data will be overwritten by the next run.
+   * @default false
+   */
+  zeroCopyOutputs?: boolean
+  /**
+   * The number of interpreters to create for this Model. All interpreters share the same
+   * weights, but each one has its own tensors, so up to this many
+   * {@linkcode TensorflowModel.run} calls can execute in parallel.
+   *
+   * {@linkcode TensorflowModel.runSync} and {@linkcode TensorflowModel.getInputBuffer} always
+   * use the first interpreter. Once {@linkcode TensorflowModel.getInputBuffer} was called, async
+   * runs only use the others.
+   * @default 1
+   */
+  interpreterPoolSize?: number
+  /**
+   * If greater than `0`, {@linkcode TensorflowModel.run} calls that arrive within this time
+   * window (in milliseconds) are merged into one batched run, which has a lot less overhead than
+   * running each sample on its own. No worker is blocked while a window is open, a timer hands
+   * the batch to one once the window is over (or the batch is full).
+   *
+   * This requires a Model with a dynamic batch (first) dimension in all inputs and outputs.
+   * @default 0
+   */
+  batchWindowMs?: number
+  /**
+   * The maximum number of {@linkcode TensorflowModel.run} calls that are merged into one batch
+   * if {@linkcode batchWindowMs} is set.
+   * @default 8
+   */
+  maxBatchSize?: number
+  /**
+   * If greater than `1`, {@linkcode TensorflowModel.run} calls are pipelined: While one run
+   * executes the Model, up to `pipelineDepth - 1` other runs already copy their inputs (and
+   * outputs) on separate interpreters. Results always arrive in the order `run(..)` was called.
+   *
+   * This is useful for camera streams, where copying the next frame can overlap with running
+   * the Model on the current frame.
+   * @default 1
+   */
+  pipelineDepth?: number
+  /**
+   * The number of CPU threads each interpreter uses for inference.
+   *
+   * If not set, a budget based on the device's CPU cores (up to 4) is split across all
+   * interpreters of the Model (see `interpreterPoolSize` and `pipelineDepth`).
+   */
+  numThreads?: number
+  /**
+   * If `true`, the default CPU delegate (XNNPACK) runs float models with 16-bit floats.
+   *
+   * This is usually faster on modern ARM CPUs, but reduces precision.
+   * @default false
+   */
+  useFp16?: boolean
+  /**
+   * A file path (or `file://` URL) where the default CPU delegate (XNNPACK) stores the packed
+   * model weights. The first load of the Model creates this file, later loads skip packing the
+   * weights which makes them considerably faster.
+   *
+   * Use a different file for every Model, for example in your app's cache directory. This is
+   * ignored if the TensorFlow Lite version of the platform doesn't support it.
+   */
+  weightsCachePath?: string
+  /**
+   * Normalization and layout conversion for each input tensor, or `null` to copy that input
+   * as-is.
+   *
+   * Preprocessed inputs are passed as a `Uint8Array` of 8-bit pixels (one byte per tensor
+   * value), which are converted to `(value - mean) / std` natively while they are copied into
+   * the tensor. Quantized (int8/uint8) inputs are quantized with the tensor's quantization
+   * params.
+   */
+  inputPreprocessing?: (InputPreprocessing | null)[]
+  /**
+   * If `true`, float16 and quantized (int8/uint8) input tensors also accept `Float32Array`s, and
+   * float16 and quantized output tensors are returned as `Float32Array`s. Float16 values are
+   * converted natively with SIMD, quantized values are (de-)quantized with each tensor's scale and
+   * zero-point (per-tensor or per-channel).
+   *
+   * This allows running float16 and int8 models with the same float inputs and outputs as float
+   * models. Converted outputs are always copied, even with {@linkcode zeroCopyOutputs}.
+   * Without it, float16 values are passed as their raw bits in a `Uint16Array`.
+   * @default false
+   */
+  floatIO?: boolean
+  /**
+   * Post-processing for each output tensor that runs natively right after the Model ran, or
+   * `null` to return that output as-is.
+   *
+   * A post-processed output is returned as a `Float32Array` of `[index, score]` pairs, `topK`
+   * pairs per row sorted by descending score, instead of the whole tensor. Indices are exact up
+   * to 2^24.
+   */
+  outputPostprocessing?: (OutputPostprocessing | null)[]
+  /**
+   * If set, the raw outputs of an object detection Model are decoded natively (box decoding,
+   * score thresholding and non-maximum suppression) on the inference thread.
+   *
+   * Runs then return a single `Float32Array` with 6 values per detection:
+   * `[x1, y1, x2, y2, score, classIndex]`, sorted by descending score.
+   */
+  detection?: DetectionOptions
+  /**
+   * The number of times every interpreter runs the Model while it is loaded, before the Promise
+   * resolves.
+   *
+   * Delegates (and XNNPACK) finish their preparation lazily in the first run, which is often a
+   * lot slower than later runs. Warming up moves that cost into loading, so the first real run
+   * (e.g. the first camera frame) already runs at full speed.
+   * @default 0
+   */
+  warmupRuns?: number
+  /**
+   * The inputs for the {@linkcode warmupRuns}, one TypedArray with the raw data of each input
+   * tensor. If not set, the warm-up runs with all inputs set to zero.
+   */
+  warmupInputs?: TypedArray[]
+}
+
 export interface Tensor {
   /**
    * The name of the Tensor.
@@ -65,6 +382,63 @@ export interface Tensor {
   shape: number[]
 }
 
+/**
+ * Latencies of one phase of all runs, in milliseconds.
+ */
+export interface LatencyStats {
+  /**
+   * The number of recorded runs.
+   */
+  count: number
+  mean: number
+  p50: number
+  p95: number
+  p99: number
+  max: number
+}
+
+/**
+ * Where the time of all runs since the Model was loaded (or {@linkcode TensorflowModel.resetStats}
+ * was called) went.
+ */
+export interface InferenceStats {
+  /**
+   * How long async runs waited for the worker thread (including the batch window).
+   */
+  queueWait: LatencyStats
+  /**
+   * Copying (and converting or preprocessing) the inputs into the input tensors.
+   */
+  input: LatencyStats
+  /**
+   * Running the Model itself.
+   */
+  invoke: LatencyStats
+  /**
+   * Copying (and converting or post-processing) the output tensors.
+   */
+  output: LatencyStats
+  /**
+   * The warm-up runs while loading (see {@linkcode TensorflowModelOptions.warmupRuns}). They are
+   * not included in the other stats, and not cleared by {@linkcode TensorflowModel.resetStats}.
+   */
+  warmup: LatencyStats
+}
+
+/**
+ * Options for a single asynchronous run.
+ */
+export interface RunOptions {
+  /**
+   * The time (in milliseconds, starting when the run is called) the run has to finish in. If it
+   * is still waiting for the worker thread by then, it is dropped without running. If the Model
+   * is already running, the inference is interrupted.
+   *
+   * Either way the Promise rejects with an error whose `code` is `'deadline-exceeded'`.
+   */
+  timeoutMs?: number
+}
+
 export interface TensorflowModel {
   /**
    * The computation delegate used by this Model.
@@ -74,13 +448,86 @@ export interface TensorflowModel {
   /**
    * Run the Tensorflow Model with the given input buffer.
    * The input buffer has to match the input tensor's shape.
+   *
+   * The Model runs on a separate Thread, so the input buffers must not be modified until the
+   * returned Promise resolves.
    */
-  run(input: TypedArray[]): Promise<TypedArray[]>
+  run(input: TensorflowInput[], options?: RunOptions): Promise<TypedArray[]>
   /**
    * Synchronously run the Tensorflow Model with the given input buffer.
    * The input buffer has to match the input tensor's shape.
    */
-  runSync(input: TypedArray[]): TypedArray[]
+  runSync(input: TensorflowInput[]): TypedArray[]
+  /**
+   * Run the Tensorflow Model with multiple samples at once.
+   * Each sample has to match the input tensor's shape, the samples are stacked along the
+   * first (batch) dimension and run in a single inference.
+   *
+   * This requires a Model with a dynamic batch (first) dimension in all inputs and outputs.
+   * Returns the outputs for each sample.
+   */
+  runBatch(
+    samples: TensorflowInput[][],
+    options?: RunOptions
+  ): Promise<TypedArray[][]>
+  /**
+   * Run the Tensorflow Model with the given input buffer, dropping older inputs that did not
+   * start running yet.
+   *
+   * At most one call is waiting to run at any time. If a newer call arrives before it started,
+   * the waiting call is dropped and its Promise resolves with `undefined`. This is useful for
+   * camera streams, where only the freshest frame matters.
+   */
+  runLatest(
+    input: TensorflowInput[],
+    options?: RunOptions
+  ): Promise<TypedArray[] | undefined>
+  /**
+   * The number of {@linkcode runLatest} calls that were dropped because a newer call arrived.
+   */
+  droppedFrames: number
+  /**
+   * Stops all asynchronous runs that were called so far: Waiting runs are dropped, and running
+   * inferences are interrupted. Their Promises reject with an error whose `code` is
+   * `'cancelled'`.
+   *
+   * {@linkcode runSync} calls are not affected.
+   */
+  cancel(): void
+  /**
+   * Timings of all runs, split into queue wait, input copy, inference and output copy.
+   *
+   * Percentiles are accurate to about 6%. Use this to find out whether copies or the Model
+   * itself dominate on a device.
+   */
+  stats: InferenceStats
+  /**
+   * Clears all recorded {@linkcode stats}, except the warm-up runs.
+   */
+  resetStats(): void
+  /**
+   * Get a TypedArray that directly points to the memory of the input tensor at the given index.
+   *
+   * Writing into this TypedArray writes straight into the input tensor, so if you pass it to
+   * {@linkcode run} or {@linkcode runSync}, no copy will be made.
+   * The returned TypedArray stays valid for as long as the Model is alive, but after calling
+   * {@linkcode resizeInputs} you need to get the input buffer again.
+   *
+   * The buffer belongs to the first interpreter, so once it was requested, async runs only use the
+   * other interpreters of the pool (see {@linkcode TensorflowModelOptions.interpreterPoolSize}).
+   * With a single interpreter, async runs share the buffer: Don't write into it until they
+   * finished, and don't call this while one is running (it throws).
+   */
+  getInputBuffer(index: number): TypedArray
+  /**
+   * Resize the input tensors of this Model to the given shapes, one shape for each input tensor.
+   * Use this for Models that support variable-size inputs, e.g. multiple image resolutions.
+   *
+   * The Model's weights are shared between all shapes, and the memory for up to 4 different shapes
+   * is kept around, so switching back to a shape that was used before is cheap.
+   * {@linkcode inputs} and {@linkcode outputs} reflect the new shapes.
+   */
+  resizeInputs(shapes: number[][]): void
 
   /**
    * All input tensors of this Tensorflow Model.
@@ -119,12 +566,14 @@ export type TensorflowPlugin =
  * * If you are passing in a `{ url: ... }`, make sure the URL points directly to a `.tflite` model. This can either be a web URL (`http://..`/`https://..`), or a local file (`file://..`).
  *
  * @param source The `.tflite` model in form of either a `require(..)` statement or a `{ url: string }`.
- * @param delegate The delegate to use for computations. Uses the standard CPU delegate per default. The `core-ml` or `metal` delegates are GPU-accelerated, but don't work on every model.
+ * @param options The delegate to use for computations, or an object of {@linkcode TensorflowModelOptions}. Uses the standard CPU delegate per default. The `core-ml` or `metal` delegates are GPU-accelerated, but don't work on every model.
+ * @param signal An optional `AbortSignal` that cancels the load, e.g. when the screen that needs the Model is closed. A cancelled load rejects with an `AbortError`.
  * @returns The loaded Model.
  */
 export function loadTensorflowModel(
   source: ModelSource,
-  delegate: TensorflowModelDelegate = 'default'
+  options: TensorflowModelDelegate | TensorflowModelOptions = 'default',
+  signal?: AbortSignal
 ): Promise<TensorflowModel> {
   let uri: string
   if (typeof source === 'number') {
@@ -139,7 +588,46 @@ export function loadTensorflowModel(
       'TFLite: Invalid source passed! Source should be either a React Native require(..) or a `{ url: string }` object!'
     )
   }
-  return global.__loadTensorflowModel(uri, delegate)
+  if (signal?.aborted) {
+    return Promise.reject(createAbortError())
+  }
+
+  const loadId = nextLoadId++
+  const promise = global.__loadTensorflowModel(uri, options, loadId)
+  if (signal == null) return promise
+
+  return new Promise((resolve, reject) => {
+    const onAbort = (): void => {
+      // Frees the loader thread if the load is still pending or running.
+      global.__cancelTensorflowModelLoad(loadId)
+      reject(createAbortError())
+    }
+    signal.addEventListener('abort', onAbort)
+    promise
+      .then(resolve, reject)
+      .finally(() => signal.removeEventListener('abort', onAbort))
+  })
+}
+
+let nextLoadId = 1
+
+function createAbortError(): Error {
+  const error = new Error('TFLite: Loading the Model was cancelled!')
+  error.name = 'AbortError'
+  return error
+}
+
+/**
+ * Sets how many Models can be loaded at the same time, on separate background threads.
+ *
+ * Loads beyond this limit wait, and start in order of their
+ * {@linkcode TensorflowModelOptions.loadPriority}.
+ * @default 2
+ */
+export function setModelLoadConcurrency(concurrency: number): void {
+  global.__setTensorflowModelLoadConcurrency(
+    Math.max(Math.floor(concurrency), 1)
+  )
 }
 
 /**
@@ -149,32 +637,52 @@ export function loadTensorflowModel(
  * * If you are passing in a `{ url: ... }`, make sure the URL points directly to a `.tflite` model. This can either be a web URL (`http://..`/`https://..`), or a local file (`file://..`).
  *
  * @param source The `.tflite` model in form of either a `require(..)` statement or a `{ url: string }`.
- * @param delegate The delegate to use for computations. Uses the standard CPU delegate per default. The `core-ml` or `metal` delegates are GPU-accelerated, but don't work on every model.
+ * @param options The delegate to use for computations, or an object of {@linkcode TensorflowModelOptions}. Uses the standard CPU delegate per default. The `core-ml` or `metal` delegates are GPU-accelerated, but don't work on every model.
  * @returns The state of the Model.
  */
 export function useTensorflowModel(
   source: ModelSource,
-  delegate: TensorflowModelDelegate = 'default'
+  options: TensorflowModelDelegate | TensorflowModelOptions = 'default'
 ): TensorflowPlugin {
   const [state, setState] = useState<TensorflowPlugin>({
     model: undefined,
     state: 'loading',
   })
 
+  // Options are often passed as an inline object, so only reload if their contents change. The
+  // warm-up inputs can be large, so they are compared by reference instead of being serialized.
+  const warmupInputs =
+    typeof options === 'object' ? options.warmupInputs : undefined
+  const optionsKey = JSON.stringify(
+    typeof options === 'object'
+      ? { ...options, warmupInputs: undefined }
+      : options
+  )
+  // eslint-disable-next-line react-hooks/exhaustive-deps
+  const stableOptions = useMemo(() => options, [optionsKey, warmupInputs])
+
   useEffect(() => {
+    // Cancels the load if the component unmounts (or the Model changes) before it finished.
+    const controller = new AbortController()
     const load = async (): Promise<void> => {
       try {
         setState({ model: undefined, state: 'loading' })
-        const m = await loadTensorflowModel(source, delegate)
+        const m = await loadTensorflowModel(
+          source,
+          stableOptions,
+          controller.signal
+        )
         setState({ model: m, state: 'loaded' })
         console.log('Model loaded!')
       } catch (e) {
+        if (controller.signal.aborted) return
         console.error(`Failed to load Tensorflow Model ${source}!`, e)
         setState({ model: undefined, state: 'error', error: e as Error })
       }
     }
     load()
-  }, [delegate, source])
+    return () => controller.abort()
+  }, [stableOptions, source])
 
   return state
 }